@@ -0,0 +1,67 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "bench_utils.h"
+#include "audio_processor.h"
+#include "utils/downmix.h"
+
+namespace chromaprint {
+
+namespace {
+
+typedef void (*DownmixFunc)(const int16_t *input, int16_t *output, size_t length, int num_channels);
+
+// One second of 48 kHz audio.
+const int kSampleRate = 48000;
+const size_t kNumFrames = kSampleRate;
+
+void BM_Downmix(benchmark::State &state, DownmixFunc func, bool supported)
+{
+	if (!supported) {
+		state.SkipWithError("not supported by the CPU");
+		return;
+	}
+	const int num_channels = int(state.range(0));
+	const auto input = GenerateAudio(1.0, kSampleRate, num_channels);
+	std::vector<int16_t> output(kNumFrames);
+	for (auto _ : state) {
+		func(input.data(), output.data(), kNumFrames, num_channels);
+		benchmark::DoNotOptimize(output.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+// Loading into the AudioProcessor buffer without resampling, including
+// the handling of chunks that end in the middle of a frame.
+void BM_AudioProcessorLoad(benchmark::State &state)
+{
+	const int num_channels = int(state.range(0));
+	const auto input = GenerateAudio(1.0, kSampleRate, num_channels);
+	const size_t chunk_size = 4095;
+	NullAudioConsumer consumer;
+	AudioProcessor processor(kSampleRate, &consumer);
+	processor.Reset(kSampleRate, num_channels);
+	for (auto _ : state) {
+		for (size_t offset = 0; offset < input.size(); offset += chunk_size) {
+			processor.Consume(input.data() + offset, int(std::min(chunk_size, input.size() - offset)));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+}; // namespace
+
+BENCHMARK_CAPTURE(BM_Downmix, Generic, Downmix_Generic, true)->Arg(1)->Arg(2)->Arg(4)->Arg(6)->Arg(8);
+#ifdef CHROMAPRINT_ARCH_X86
+BENCHMARK_CAPTURE(BM_Downmix, SSE2, Downmix_SSE2, GetCpuFeatures().sse2)->Arg(1)->Arg(2)->Arg(4)->Arg(6)->Arg(8);
+BENCHMARK_CAPTURE(BM_Downmix, AVX2, Downmix_AVX2, GetCpuFeatures().avx2)->Arg(1)->Arg(2)->Arg(4)->Arg(6)->Arg(8);
+#endif
+#ifdef CHROMAPRINT_ARCH_NEON
+BENCHMARK_CAPTURE(BM_Downmix, NEON, Downmix_NEON, true)->Arg(1)->Arg(2)->Arg(4)->Arg(6)->Arg(8);
+#endif
+BENCHMARK(BM_AudioProcessorLoad)->Arg(1)->Arg(2)->Arg(4)->Arg(6)->Arg(8);
+
+}; // namespace chromaprint
@@ -0,0 +1,102 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "bench_utils.h"
+#include "fingerprint_compressor.h"
+#include "fingerprint_decompressor.h"
+#include "simhash.h"
+#include "utils/base64.h"
+#include "chromaprint.h"
+
+namespace chromaprint {
+
+namespace {
+
+// Fingerprint of three minutes of synthetic audio.
+const std::vector<uint32_t> &GetFingerprint()
+{
+	static const std::vector<uint32_t> fingerprint = [] {
+		const int sample_rate = 11025;
+		const auto audio = GenerateAudio(180.0, sample_rate);
+		ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT);
+		chromaprint_start(ctx, sample_rate, 1);
+		chromaprint_feed(ctx, audio.data(), int(audio.size()));
+		chromaprint_finish(ctx);
+		uint32_t *data = nullptr;
+		int size = 0;
+		chromaprint_get_raw_fingerprint(ctx, &data, &size);
+		std::vector<uint32_t> result(data, data + size);
+		chromaprint_dealloc(data);
+		chromaprint_free(ctx);
+		return result;
+	}();
+	return fingerprint;
+}
+
+void BM_FingerprintCompressor(benchmark::State &state)
+{
+	const auto &fingerprint = GetFingerprint();
+	FingerprintCompressor compressor;
+	std::string output;
+	for (auto _ : state) {
+		compressor.Compress(fingerprint, CHROMAPRINT_ALGORITHM_DEFAULT, output);
+		benchmark::DoNotOptimize(output.data());
+	}
+	state.SetItemsProcessed(state.iterations() * fingerprint.size());
+}
+
+void BM_FingerprintDecompressor(benchmark::State &state)
+{
+	const auto &fingerprint = GetFingerprint();
+	const auto compressed = CompressFingerprint(fingerprint, CHROMAPRINT_ALGORITHM_DEFAULT);
+	FingerprintDecompressor decompressor;
+	for (auto _ : state) {
+		decompressor.Decompress(compressed);
+		benchmark::DoNotOptimize(decompressor.GetOutput().data());
+	}
+	state.SetItemsProcessed(state.iterations() * fingerprint.size());
+}
+
+void BM_Base64Encode(benchmark::State &state)
+{
+	const auto compressed = CompressFingerprint(GetFingerprint(), CHROMAPRINT_ALGORITHM_DEFAULT);
+	std::string output;
+	for (auto _ : state) {
+		Base64Encode(compressed, output);
+		benchmark::DoNotOptimize(output.data());
+	}
+	state.SetBytesProcessed(state.iterations() * compressed.size());
+}
+
+void BM_Base64Decode(benchmark::State &state)
+{
+	const auto encoded = Base64Encode(CompressFingerprint(GetFingerprint(), CHROMAPRINT_ALGORITHM_DEFAULT));
+	std::string output;
+	for (auto _ : state) {
+		Base64Decode(encoded, output);
+		benchmark::DoNotOptimize(output.data());
+	}
+	state.SetBytesProcessed(state.iterations() * encoded.size());
+}
+
+void BM_SimHash(benchmark::State &state)
+{
+	const auto &fingerprint = GetFingerprint();
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(SimHash(fingerprint));
+	}
+	state.SetItemsProcessed(state.iterations() * fingerprint.size());
+}
+
+}; // namespace
+
+BENCHMARK(BM_FingerprintCompressor);
+BENCHMARK(BM_FingerprintDecompressor);
+BENCHMARK(BM_Base64Encode);
+BENCHMARK(BM_Base64Decode);
+BENCHMARK(BM_SimHash);
+
+}; // namespace chromaprint
@@ -0,0 +1,72 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+#include "fingerprint_index.h"
+#include "chromaprint.h"
+
+namespace chromaprint {
+
+namespace {
+
+// Random fingerprints of roughly 3 minute tracks, every ninth one is
+// queried with a 30 second noisy excerpt.
+const size_t kTrackSize = 1500;
+const size_t kQuerySize = 250;
+
+void BuildIndex(FingerprintIndex &index, size_t num_tracks, std::vector<std::vector<uint32_t>> &queries)
+{
+	std::mt19937 rng(1234);
+	std::vector<uint32_t> fp(kTrackSize);
+	for (size_t i = 0; i < num_tracks; i++) {
+		for (auto &x : fp) {
+			x = rng();
+		}
+		index.Add(uint32_t(i), fp);
+		if (i % 9 == 0) {
+			std::vector<uint32_t> query(fp.begin() + 500, fp.begin() + 500 + kQuerySize);
+			for (auto &x : query) {
+				x ^= 1u << (rng() % 32);
+			}
+			queries.push_back(query);
+		}
+	}
+	index.Build();
+}
+
+void BM_FingerprintIndexBuild(benchmark::State &state)
+{
+	for (auto _ : state) {
+		FingerprintIndex index(CHROMAPRINT_ALGORITHM_DEFAULT);
+		std::vector<std::vector<uint32_t>> queries;
+		BuildIndex(index, state.range(0), queries);
+		benchmark::DoNotOptimize(index.memory_usage());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_FingerprintIndexSearch(benchmark::State &state, bool verify)
+{
+	FingerprintIndex index(CHROMAPRINT_ALGORITHM_DEFAULT);
+	std::vector<std::vector<uint32_t>> queries;
+	BuildIndex(index, state.range(0), queries);
+	index.set_verify(verify);
+	std::vector<FingerprintIndexResult> results;
+	size_t i = 0;
+	for (auto _ : state) {
+		index.Search(queries[i++ % queries.size()], 10, results);
+		benchmark::DoNotOptimize(results.data());
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.counters["bytes_per_track"] = double(index.memory_usage()) / state.range(0);
+}
+
+}; // namespace
+
+BENCHMARK(BM_FingerprintIndexBuild)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_FingerprintIndexSearch, Votes, false)->Arg(1000)->Arg(10000);
+BENCHMARK_CAPTURE(BM_FingerprintIndexSearch, Verified, true)->Arg(1000)->Arg(10000);
+
+}; // namespace chromaprint
@@ -0,0 +1,49 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+#include "fingerprint_matcher.h"
+#include "fingerprinter_configuration.h"
+
+namespace chromaprint {
+
+namespace {
+
+// Two fingerprints sharing a noisy section in the middle, roughly what
+// matching a long recording against an excerpt of itself looks like.
+void GenerateFingerprints(size_t size, std::vector<uint32_t> &fp1, std::vector<uint32_t> &fp2)
+{
+	std::mt19937 rng(1234);
+	fp1.resize(size);
+	for (auto &x : fp1) {
+		x = rng();
+	}
+	fp2.assign(fp1.begin() + size / 4, fp1.begin() + size * 3 / 4);
+	for (auto &x : fp2) {
+		x ^= 1u << (rng() % 32);
+	}
+}
+
+void BM_FingerprintMatcher(benchmark::State &state, FingerprintMatcher::AlignmentMethod method)
+{
+	std::vector<uint32_t> fp1, fp2;
+	GenerateFingerprints(state.range(0), fp1, fp2);
+	FingerprintMatcher matcher(CreateFingerprinterConfiguration(CHROMAPRINT_ALGORITHM_DEFAULT));
+	matcher.set_alignment_method(method);
+	for (auto _ : state) {
+		matcher.Match(fp1, fp2);
+		benchmark::DoNotOptimize(matcher.segments().data());
+	}
+	state.SetItemsProcessed(state.iterations() * (fp1.size() + fp2.size()));
+}
+
+}; // namespace
+
+BENCHMARK_CAPTURE(BM_FingerprintMatcher, Sort, FingerprintMatcher::ALIGNMENT_SORT)
+	->RangeMultiplier(8)->Range(1 << 10, 1 << 16);
+BENCHMARK_CAPTURE(BM_FingerprintMatcher, Buckets, FingerprintMatcher::ALIGNMENT_BUCKETS)
+	->RangeMultiplier(8)->Range(1 << 10, 1 << 16);
+
+}; // namespace chromaprint
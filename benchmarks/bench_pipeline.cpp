@@ -0,0 +1,387 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+#include "bench_utils.h"
+#include "audio_processor.h"
+#include "audio/audio_slicer.h"
+#include "fft.h"
+#include "chroma.h"
+#include "chroma_filter.h"
+#include "chroma_normalizer.h"
+#include "fingerprint_calculator.h"
+#include "fingerprinter.h"
+#include "multi_fingerprinter.h"
+#include "fingerprinter_configuration.h"
+#include "chromaprint.h"
+
+namespace chromaprint {
+
+namespace {
+
+const int kMinFreq = 28;
+const int kMaxFreq = 3520;
+
+// Length of the audio processed by one iteration of the stage benchmarks.
+const double kDuration = 10.0;
+
+const char *GetFFTLibName()
+{
+#if defined(USE_AVTX)
+	return "avtx";
+#elif defined(USE_AVFFT)
+	return "avfft";
+#elif defined(USE_FFTW3)
+	return "fftw3";
+#elif defined(USE_FFTW3F)
+	return "fftw3f";
+#elif defined(USE_VDSP)
+	return "vdsp";
+#elif defined(USE_KISSFFT)
+	return "kissfft";
+#else
+	return "unknown";
+#endif
+}
+
+class FFTFrameCollector : public FFTFrameConsumer
+{
+public:
+	void Consume(const FFTFrame &frame) override {
+		frames.push_back(frame);
+	}
+	std::vector<FFTFrame> frames;
+};
+
+class FeatureVectorCollector : public FeatureVectorConsumer
+{
+public:
+	void Consume(std::vector<double> &features) override {
+		features_list.push_back(features);
+	}
+	std::vector<std::vector<double>> features_list;
+};
+
+// Intermediate results of the pipeline for the synthetic audio, so that
+// every stage can be measured on its own input.
+struct StageInputs
+{
+	std::vector<int16_t> audio;
+	std::vector<FFTFrame> fft_frames;
+	std::vector<std::vector<double>> chroma_features;
+	std::vector<std::vector<double>> normalized_features;
+};
+
+const StageInputs &GetStageInputs()
+{
+	static const StageInputs inputs = [] {
+		StageInputs result;
+		std::unique_ptr<FingerprinterConfiguration> config(CreateFingerprinterConfiguration(CHROMAPRINT_ALGORITHM_DEFAULT));
+		result.audio = GenerateAudio(kDuration, config->sample_rate());
+
+		FFTFrameCollector frames;
+		FFT fft(config->frame_size(), config->frame_overlap(), &frames);
+		fft.Consume(result.audio.data(), int(result.audio.size()));
+		result.fft_frames = frames.frames;
+
+		FeatureVectorCollector chroma_features;
+		Chroma chroma(kMinFreq, kMaxFreq, config->frame_size(), config->sample_rate(), &chroma_features);
+		for (const auto &frame : result.fft_frames) {
+			chroma.Consume(frame);
+		}
+		result.chroma_features = chroma_features.features_list;
+
+		FeatureVectorCollector normalized_features;
+		ChromaNormalizer normalizer(&normalized_features);
+		ChromaFilter filter(config->filter_coefficients(), config->num_filter_coefficients(), &normalizer);
+		for (auto features : result.chroma_features) {
+			filter.Consume(features);
+		}
+		result.normalized_features = normalized_features.features_list;
+		return result;
+	}();
+	return inputs;
+}
+
+void BM_AudioProcessorResample(benchmark::State &state)
+{
+	const int sample_rate = int(state.range(0));
+	const auto audio = GenerateAudio(kDuration, sample_rate);
+	const size_t chunk_size = 4096;
+	NullAudioConsumer consumer;
+	AudioProcessor processor(DEFAULT_SAMPLE_RATE, &consumer);
+	processor.set_resampler(ChromaprintResampler(state.range(1)));
+	for (auto _ : state) {
+		processor.Reset(sample_rate, 1);
+		for (size_t offset = 0; offset < audio.size(); offset += chunk_size) {
+			processor.Consume(audio.data() + offset, int(std::min(chunk_size, audio.size() - offset)));
+		}
+		processor.Flush();
+	}
+	state.SetItemsProcessed(state.iterations() * audio.size());
+}
+
+void BM_AudioSlicer(benchmark::State &state)
+{
+	const auto &inputs = GetStageInputs();
+	std::unique_ptr<FingerprinterConfiguration> config(CreateFingerprinterConfiguration(CHROMAPRINT_ALGORITHM_DEFAULT));
+	const size_t frame_size = config->frame_size();
+	const size_t increment = frame_size - config->frame_overlap();
+	const size_t chunk_size = 4096;
+	AudioSlicer<int16_t> slicer(frame_size, increment);
+	int64_t sum = 0;
+	for (auto _ : state) {
+		slicer.Reset();
+		for (size_t offset = 0; offset < inputs.audio.size(); offset += chunk_size) {
+			const int16_t *begin = inputs.audio.data() + offset;
+			const int16_t *end = inputs.audio.data() + std::min(offset + chunk_size, inputs.audio.size());
+			slicer.Process(begin, end, [&](const int16_t *b1, const int16_t *e1, const int16_t *b2, const int16_t *e2) {
+				sum += (e1 - b1) + (e2 - b2);
+			});
+		}
+	}
+	benchmark::DoNotOptimize(sum);
+	state.SetItemsProcessed(state.iterations() * inputs.audio.size());
+}
+
+void BM_FFT(benchmark::State &state)
+{
+	const auto &inputs = GetStageInputs();
+	std::unique_ptr<FingerprinterConfiguration> config(CreateFingerprinterConfiguration(CHROMAPRINT_ALGORITHM_DEFAULT));
+	NullFFTFrameConsumer consumer;
+	FFT fft(config->frame_size(), config->frame_overlap(), &consumer);
+	for (auto _ : state) {
+		fft.Reset();
+		fft.Consume(inputs.audio.data(), int(inputs.audio.size()));
+	}
+	state.SetLabel(GetFFTLibName());
+	state.SetItemsProcessed(state.iterations() * inputs.fft_frames.size());
+}
+
+void BM_Chroma(benchmark::State &state)
+{
+	const auto &inputs = GetStageInputs();
+	std::unique_ptr<FingerprinterConfiguration> config(CreateFingerprinterConfiguration(CHROMAPRINT_ALGORITHM_DEFAULT));
+	NullFeatureVectorConsumer consumer;
+	Chroma chroma(kMinFreq, kMaxFreq, config->frame_size(), config->sample_rate(), &consumer);
+	for (auto _ : state) {
+		for (const auto &frame : inputs.fft_frames) {
+			chroma.Consume(frame);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * inputs.fft_frames.size());
+}
+
+// FFT followed by chroma, either with the intermediate power spectrum
+// frames (0) or with the chroma calculated directly from the transform (1).
+void BM_FFTChroma(benchmark::State &state)
+{
+	const auto &inputs = GetStageInputs();
+	std::unique_ptr<FingerprinterConfiguration> config(CreateFingerprinterConfiguration(CHROMAPRINT_ALGORITHM_DEFAULT));
+	NullFeatureVectorConsumer consumer;
+	Chroma chroma(kMinFreq, kMaxFreq, config->frame_size(), config->sample_rate(), &consumer);
+	std::unique_ptr<FFT> fft;
+	if (state.range(0)) {
+		fft.reset(new FFT(config->frame_size(), config->frame_overlap(), &chroma));
+	} else {
+		fft.reset(new FFT(config->frame_size(), config->frame_overlap(), static_cast<FFTFrameConsumer *>(&chroma)));
+	}
+	for (auto _ : state) {
+		fft->Reset();
+		fft->Consume(inputs.audio.data(), int(inputs.audio.size()));
+	}
+	state.SetLabel(GetFFTLibName());
+	state.SetItemsProcessed(state.iterations() * inputs.fft_frames.size());
+}
+
+void BM_ChromaFilter(benchmark::State &state)
+{
+	const auto &inputs = GetStageInputs();
+	std::unique_ptr<FingerprinterConfiguration> config(CreateFingerprinterConfiguration(CHROMAPRINT_ALGORITHM_DEFAULT));
+	auto features = inputs.chroma_features;
+	NullFeatureVectorConsumer consumer;
+	ChromaFilter filter(config->filter_coefficients(), config->num_filter_coefficients(), &consumer);
+	for (auto _ : state) {
+		filter.Reset();
+		for (auto &x : features) {
+			filter.Consume(x);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * features.size());
+}
+
+void BM_FingerprintCalculator(benchmark::State &state)
+{
+	const auto &inputs = GetStageInputs();
+	std::unique_ptr<FingerprinterConfiguration> config(CreateFingerprinterConfiguration(CHROMAPRINT_ALGORITHM_DEFAULT));
+	auto features = inputs.normalized_features;
+	FingerprintCalculator calculator(config->classifiers(), config->num_classifiers());
+	if (state.range(0)) {
+		// all features in one block, the classifiers are evaluated for many offsets at once
+		std::vector<double> block;
+		for (const auto &x : features) {
+			block.insert(block.end(), x.begin(), x.end());
+		}
+		const size_t num_columns = features[0].size();
+		for (auto _ : state) {
+			calculator.Reset();
+			calculator.ConsumeBlock(block.data(), features.size(), num_columns);
+			benchmark::DoNotOptimize(calculator.GetFingerprint().data());
+		}
+	} else {
+		for (auto _ : state) {
+			calculator.Reset();
+			for (auto &x : features) {
+				calculator.Consume(x);
+			}
+			benchmark::DoNotOptimize(calculator.GetFingerprint().data());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * features.size());
+}
+
+typedef BasicFingerprinter<double, DynamicFingerprintPipeline<double>> DynamicFingerprinter;
+
+// The whole pipeline with the features calculated in double or single
+// precision, and with the stages connected through virtual calls.
+template <typename FingerprinterType>
+void BM_Fingerprinter(benchmark::State &state)
+{
+	const auto &inputs = GetStageInputs();
+	FingerprinterType fingerprinter(CreateFingerprinterConfiguration(CHROMAPRINT_ALGORITHM_DEFAULT));
+	const int sample_rate = fingerprinter.config()->sample_rate();
+	for (auto _ : state) {
+		fingerprinter.Start(sample_rate, 1);
+		fingerprinter.Consume(inputs.audio.data(), int(inputs.audio.size()));
+		fingerprinter.Finish();
+		benchmark::DoNotOptimize(fingerprinter.GetFingerprint().data());
+	}
+	state.SetItemsProcessed(state.iterations() * inputs.audio.size());
+}
+
+// The whole pipeline through the public API, reported as seconds of audio
+// processed per second.
+void BM_EndToEnd(benchmark::State &state)
+{
+	const int sample_rate = int(state.range(0));
+	const int num_channels = int(state.range(1));
+	const double duration = 60.0;
+	const auto audio = GenerateAudio(duration, sample_rate, num_channels);
+	const size_t chunk_size = 4096 * num_channels;
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT);
+	for (auto _ : state) {
+		chromaprint_start(ctx, sample_rate, num_channels);
+		for (size_t offset = 0; offset < audio.size(); offset += chunk_size) {
+			chromaprint_feed(ctx, audio.data() + offset, int(std::min(chunk_size, audio.size() - offset)));
+		}
+		chromaprint_finish(ctx);
+		char *fp = nullptr;
+		chromaprint_get_fingerprint(ctx, &fp);
+		chromaprint_dealloc(fp);
+	}
+	chromaprint_free(ctx);
+	state.counters["audio_seconds"] = benchmark::Counter(state.iterations() * duration, benchmark::Counter::kIsRate);
+}
+
+// Creating a context and starting a stream, as done for every short file
+// or stream that is fingerprinted, without any audio.
+void BM_ContextSetup(benchmark::State &state)
+{
+	const int sample_rate = int(state.range(0));
+	for (auto _ : state) {
+		ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT);
+		chromaprint_start(ctx, sample_rate, 2);
+		chromaprint_free(ctx);
+	}
+}
+
+// Same as above, with the contexts reused from a pool.
+void BM_ContextPoolSetup(benchmark::State &state)
+{
+	const int sample_rate = int(state.range(0));
+	ChromaprintContextPool *pool = chromaprint_pool_new(1);
+	for (auto _ : state) {
+		ChromaprintContext *ctx = chromaprint_pool_acquire(pool, CHROMAPRINT_ALGORITHM_DEFAULT);
+		chromaprint_start(ctx, sample_rate, 2);
+		chromaprint_pool_release(pool, ctx);
+	}
+	chromaprint_pool_free(pool);
+}
+
+// Fingerprinting of a whole long recording, with the features calculated
+// on the given number of threads. fpcalc passes mono audio at the
+// fingerprinting sample rate.
+void BM_ShardedEndToEnd(benchmark::State &state)
+{
+	const int num_threads = int(state.range(0));
+	const double duration = 600.0;
+	const auto audio = GenerateAudio(duration, 11025, 1);
+	const size_t chunk_size = 4096;
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT);
+	chromaprint_set_option(ctx, "num_threads", num_threads);
+	for (auto _ : state) {
+		chromaprint_start(ctx, 11025, 1);
+		for (size_t offset = 0; offset < audio.size(); offset += chunk_size) {
+			chromaprint_feed(ctx, audio.data() + offset, int(std::min(chunk_size, audio.size() - offset)));
+		}
+		chromaprint_finish(ctx);
+		uint32_t *fp = nullptr;
+		int size = 0;
+		chromaprint_get_raw_fingerprint(ctx, &fp, &size);
+		chromaprint_dealloc(fp);
+	}
+	chromaprint_free(ctx);
+	state.counters["audio_seconds"] = benchmark::Counter(state.iterations() * duration, benchmark::Counter::kIsRate);
+}
+
+// Algorithms 1, 2 and 4 of the same audio, with separate fingerprinters
+// (0) or with one multi-algorithm fingerprinter (1).
+void BM_MultiAlgorithm(benchmark::State &state)
+{
+	const bool multi = state.range(0) != 0;
+	const auto audio = GenerateAudio(120.0, 44100, 2);
+	const int algorithms[] = { CHROMAPRINT_ALGORITHM_TEST1, CHROMAPRINT_ALGORITHM_TEST2, CHROMAPRINT_ALGORITHM_TEST4 };
+	const size_t num_algorithms = sizeof(algorithms) / sizeof(algorithms[0]);
+	MultiFingerprinter multi_fingerprinter(algorithms, num_algorithms);
+	std::vector<std::unique_ptr<Fingerprinter>> fingerprinters;
+	for (size_t i = 0; i < num_algorithms; i++) {
+		fingerprinters.emplace_back(new Fingerprinter(CreateFingerprinterConfiguration(algorithms[i])));
+	}
+	for (auto _ : state) {
+		if (multi) {
+			multi_fingerprinter.Start(44100, 2);
+			multi_fingerprinter.Consume(audio.data(), int(audio.size()));
+			multi_fingerprinter.Finish();
+			benchmark::DoNotOptimize(multi_fingerprinter.GetFingerprint(0).data());
+		} else {
+			for (auto &fingerprinter : fingerprinters) {
+				fingerprinter->Start(44100, 2);
+				fingerprinter->Consume(audio.data(), int(audio.size()));
+				fingerprinter->Finish();
+				benchmark::DoNotOptimize(fingerprinter->GetFingerprint().data());
+			}
+		}
+	}
+}
+
+}; // namespace
+
+BENCHMARK(BM_AudioProcessorResample)->ArgsProduct({ { 11025, 22050, 44100, 48000 }, { CHROMAPRINT_RESAMPLER_AVRESAMPLE, CHROMAPRINT_RESAMPLER_POLYPHASE } });
+BENCHMARK(BM_AudioSlicer);
+BENCHMARK(BM_FFT);
+BENCHMARK(BM_Chroma);
+BENCHMARK(BM_FFTChroma)->Arg(0)->Arg(1);
+BENCHMARK(BM_ChromaFilter);
+BENCHMARK(BM_FingerprintCalculator)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_Fingerprinter, BasicFingerprinter<double>);
+BENCHMARK_TEMPLATE(BM_Fingerprinter, BasicFingerprinter<float>);
+BENCHMARK_TEMPLATE(BM_Fingerprinter, DynamicFingerprinter);
+BENCHMARK(BM_EndToEnd)->Args({ 11025, 1 })->Args({ 44100, 2 })->Args({ 48000, 6 })->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ContextSetup)->Arg(11025)->Arg(44100);
+BENCHMARK(BM_ContextPoolSetup)->Arg(11025)->Arg(44100);
+BENCHMARK(BM_ShardedEndToEnd)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MultiAlgorithm)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+}; // namespace chromaprint
@@ -0,0 +1,74 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_BENCHMARKS_BENCH_UTILS_H_
+#define CHROMAPRINT_BENCHMARKS_BENCH_UTILS_H_
+
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "audio_consumer.h"
+#include "feature_vector_consumer.h"
+#include "fft_frame_consumer.h"
+
+namespace chromaprint {
+
+// Deterministic synthetic "music", a few tones that change every half a
+// second plus some noise, so that all the benchmarks can run offline and
+// the fingerprints are not trivial.
+inline std::vector<int16_t> GenerateAudio(double duration, int sample_rate, int num_channels = 1)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<double> freq_dist(100.0, 3000.0);
+	std::normal_distribution<double> noise_dist(0.0, 500.0);
+	const size_t num_frames = size_t(duration * sample_rate);
+	const size_t note_length = size_t(sample_rate / 2);
+	std::vector<int16_t> data(num_frames * num_channels);
+	double freqs[3] = { 0.0, 0.0, 0.0 };
+	for (size_t i = 0; i < num_frames; i++) {
+		if (i % note_length == 0) {
+			for (auto &freq : freqs) {
+				freq = freq_dist(rng);
+			}
+		}
+		const double t = double(i) / sample_rate;
+		double value = 0.0;
+		for (auto freq : freqs) {
+			value += 8000.0 * std::sin(2.0 * M_PI * freq * t);
+		}
+		for (int c = 0; c < num_channels; c++) {
+			data[i * num_channels + c] = int16_t(value + noise_dist(rng));
+		}
+	}
+	return data;
+}
+
+class NullAudioConsumer : public AudioConsumer
+{
+public:
+	void Consume(const int16_t *input, int length) override {
+		benchmark::DoNotOptimize(input);
+	}
+};
+
+class NullFFTFrameConsumer : public FFTFrameConsumer
+{
+public:
+	void Consume(const FFTFrame &frame) override {
+		benchmark::DoNotOptimize(frame.data());
+	}
+};
+
+class NullFeatureVectorConsumer : public FeatureVectorConsumer
+{
+public:
+	void Consume(std::vector<double> &features) override {
+		benchmark::DoNotOptimize(features.data());
+	}
+};
+
+}; // namespace chromaprint
+
+#endif
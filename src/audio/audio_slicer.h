@@ -9,6 +9,7 @@
 #include <cassert>
 #include <vector>
 #include "debug.h"
+#include "utils/allocator.h"
 
 namespace chromaprint {
 
@@ -72,9 +73,9 @@ public:
 private:
 	size_t m_size;
 	size_t m_increment;
-	std::vector<T> m_buffer;
-	typename std::vector<T>::iterator m_buffer_begin;
-	typename std::vector<T>::iterator m_buffer_end;
+	Vector<T> m_buffer;
+	typename Vector<T>::iterator m_buffer_begin;
+	typename Vector<T>::iterator m_buffer_end;
 };
 
 }; // namespace chromaprint
@@ -4,12 +4,34 @@
 #ifndef CHROMAPRINT_AUDIO_CONSUMER_H_
 #define CHROMAPRINT_AUDIO_CONSUMER_H_
 
+#include <algorithm>
+#include "utils.h"
+#include "utils/allocator.h"
+
 namespace chromaprint {
 
-class AudioConsumer {
+class AudioConsumer : public Allocated {
 public:
 	virtual ~AudioConsumer() {}
 	virtual void Consume(const int16_t *input, int length) = 0;
+
+	/**
+	 * Process samples that are in the range of 16-bit integers, but were
+	 * not rounded, so that float input is not quantized before the FFT.
+	 * Consumers that only work with 16-bit samples don't need to override
+	 * it, the samples are rounded and passed to Consume().
+	 */
+	virtual void ConsumeFloat(const float *input, int length) {
+		const int buffer_size = 1024;
+		int16_t buffer[buffer_size];
+		while (length > 0) {
+			const int count = std::min(length, buffer_size);
+			std::transform(input, input + count, buffer, RoundToInt16);
+			Consume(buffer, count);
+			input += count;
+			length -= count;
+		}
+	}
 };
 
 }; // namespace chromaprint
@@ -16,9 +16,153 @@ extern "C" {
 
 #include "debug.h"
 #include "audio_processor.h"
+#include "polyphase_resampler.h"
+#include "utils/downmix.h"
+#include "utils/shared_cache.h"
 
 namespace chromaprint {
 
+namespace {
+
+// Conversion of the sum of samples from all channels to a mono sample, either
+// 16-bit, or a float in the same range. The sum is kept in a wider type, so
+// downmixing and quantization happen in one step, without rounding the
+// individual channels first.
+template <typename T>
+struct SampleTraits;
+
+template <>
+struct SampleTraits<int16_t>
+{
+	typedef int32_t Sum;
+	static const bool kLossless = true;
+	static void Average(Sum sum, int num_channels, int16_t &output) {
+		output = static_cast<int16_t>(sum / num_channels);
+	}
+	static void Average(Sum sum, int num_channels, float &output) {
+		output = static_cast<float>(sum / num_channels);
+	}
+};
+
+template <>
+struct SampleTraits<int32_t>
+{
+	typedef int64_t Sum;
+	static const bool kLossless = false;
+	static void Average(Sum sum, int num_channels, int16_t &output) {
+		output = static_cast<int16_t>(sum / (static_cast<int64_t>(num_channels) << 16));
+	}
+	static void Average(Sum sum, int num_channels, float &output) {
+		output = static_cast<float>(static_cast<double>(sum) / (num_channels * 65536.0));
+	}
+};
+
+template <>
+struct SampleTraits<float>
+{
+	typedef float Sum;
+	static const bool kLossless = false;
+	static float Scale(Sum sum, int num_channels) {
+		const float value = sum * (32768.0f / num_channels);
+		if (value >= 32767.0f) {
+			return 32767.0f;
+		}
+		if (value <= -32768.0f) {
+			return -32768.0f;
+		}
+		if (value != value) {
+			return 0.0f;
+		}
+		return value;
+	}
+	static void Average(Sum sum, int num_channels, int16_t &output) {
+		const float value = Scale(sum, num_channels);
+		output = static_cast<int16_t>(value + (value >= 0.0f ? 0.5f : -0.5f));
+	}
+	static void Average(Sum sum, int num_channels, float &output) {
+		output = Scale(sum, num_channels);
+	}
+};
+
+template <typename T, typename Output>
+void DownmixInterleaved(const T *input, Output *output, int length, int num_channels)
+{
+	typedef SampleTraits<T> Traits;
+	typedef typename Traits::Sum Sum;
+	switch (num_channels) {
+	case 1:
+		for (int i = 0; i < length; i++) {
+			Traits::Average(Sum(input[i]), 1, output[i]);
+		}
+		break;
+	case 2:
+		for (int i = 0; i < length; i++) {
+			Traits::Average(Sum(input[2 * i]) + Sum(input[2 * i + 1]), 2, output[i]);
+		}
+		break;
+	default:
+		for (int i = 0; i < length; i++) {
+			Sum sum = 0;
+			for (int j = 0; j < num_channels; j++) {
+				sum += *input++;
+			}
+			Traits::Average(sum, num_channels, output[i]);
+		}
+		break;
+	}
+}
+
+// 16-bit input is the common case, it uses the SIMD kernels.
+inline void DownmixInterleaved(const int16_t *input, int16_t *output, int length, int num_channels)
+{
+	Downmix(input, output, size_t(length), num_channels);
+}
+
+template <typename T, typename Output>
+void DownmixPlanar(const T *const *input, int offset, Output *output, int length, int num_channels)
+{
+	typedef SampleTraits<T> Traits;
+	typedef typename Traits::Sum Sum;
+	switch (num_channels) {
+	case 1: {
+		const T *input0 = input[0] + offset;
+		for (int i = 0; i < length; i++) {
+			Traits::Average(Sum(input0[i]), 1, output[i]);
+		}
+		break;
+	}
+	case 2: {
+		const T *input0 = input[0] + offset;
+		const T *input1 = input[1] + offset;
+		for (int i = 0; i < length; i++) {
+			Traits::Average(Sum(input0[i]) + Sum(input1[i]), 2, output[i]);
+		}
+		break;
+	}
+	default:
+		for (int i = 0; i < length; i++) {
+			Sum sum = 0;
+			for (int j = 0; j < num_channels; j++) {
+				sum += input[j][offset + i];
+			}
+			Traits::Average(sum, num_channels, output[i]);
+		}
+		break;
+	}
+}
+
+inline void ConsumeSamples(AudioConsumer *consumer, const int16_t *input, int length)
+{
+	consumer->Consume(input, length);
+}
+
+inline void ConsumeSamples(AudioConsumer *consumer, const float *input, int length)
+{
+	consumer->ConsumeFloat(input, length);
+}
+
+} // namespace
+
 static const int kMinSampleRate = 1000;
 static const int kMaxBufferSize = 1024 * 32;
 
@@ -28,14 +172,39 @@ static const int kResampleFilterLength = 16;
 static const int kResamplePhaseShift = 8;
 static const int kResampleLinear = 0;
 static const double kResampleCutoff = 0.8;
+
+// Building the filter bank is much more expensive than the rest of the
+// context, so it is built once per pair of sample rates, in a context that
+// is never used for resampling itself, and shared by the real ones.
+static std::shared_ptr<const AVResampleContext> GetResampleFilter(int input_rate, int output_rate)
+{
+	static SharedCache<std::pair<int, int>, AVResampleContext> cache;
+	return cache.Get(std::make_pair(input_rate, output_rate), [&]() {
+		std::shared_ptr<const AVResampleContext> filter;
+		AVResampleContext *ctx = av_resample_init(
+			output_rate, input_rate,
+			kResampleFilterLength,
+			kResamplePhaseShift,
+			kResampleLinear,
+			kResampleCutoff);
+		if (ctx) {
+			filter.reset(ctx, av_resample_close);
+		}
+		return filter;
+	});
+}
 #endif
 
 AudioProcessor::AudioProcessor(int sample_rate, AudioConsumer *consumer)
 	: m_buffer(kMaxBufferSize),
 	  m_buffer_offset(0),
+	  m_buffer_float(false),
 	  m_resample_buffer(kMaxBufferSize),
 	  m_target_sample_rate(sample_rate),
+	  m_num_channels(0),
 	  m_consumer(consumer),
+	  m_resampler(CHROMAPRINT_RESAMPLER_DEFAULT),
+	  m_use_polyphase_resampler(false),
 	  m_resample_ctx(0)
 {
 }
@@ -49,60 +218,52 @@ AudioProcessor::~AudioProcessor()
 #endif
 }
 
-void AudioProcessor::LoadMono(const int16_t *input, int length)
-{
-	int16_t *output = m_buffer.data() + m_buffer_offset;
-	while (length--) {
-		*output++ = input[0];
-		input++;
-	}
-}
-
-void AudioProcessor::LoadStereo(const int16_t *input, int length)
+int AudioProcessor::GetBufferSpace(int length) const
 {
-	int16_t *output = m_buffer.data() + m_buffer_offset;
-	while (length--) {
-		*output++ = (input[0] + input[1]) / 2;
-		input += 2;
-	}
+	assert(length >= 0);
+	assert(m_buffer_offset <= m_buffer.size());
+	return std::min(length, static_cast<int>(m_buffer.size() - m_buffer_offset));
 }
 
-void AudioProcessor::LoadMultiChannel(const int16_t *input, int length)
+bool AudioProcessor::CommitBuffer(int length)
 {
-	int16_t *output = m_buffer.data() + m_buffer_offset;
-	while (length--) {
-		int32_t sum = 0;
-		for (int i = 0; i < m_num_channels; i++) {
-			sum += *input++;
+	m_buffer_offset += length;
+	if (m_buffer.size() == m_buffer_offset) {
+		Resample();
+		if (m_buffer.size() == m_buffer_offset) {
+			DEBUG("chromaprint::AudioProcessor::CommitBuffer() -- Resampling failed?");
+			return false;
 		}
-		*output++ = (int16_t)(sum / m_num_channels);
 	}
+	return true;
 }
 
-int AudioProcessor::Load(const int16_t *input, int length)
+template <typename Sample>
+void AudioProcessor::ResamplePolyphase(Vector<Sample> &buffer, Vector<Sample> &output)
 {
-	assert(length >= 0);
-	assert(m_buffer_offset <= m_buffer.size());
-	length = std::min(length, static_cast<int>(m_buffer.size() - m_buffer_offset));
-	switch (m_num_channels) {
-	case 1:
-		LoadMono(input, length);
-		break;
-	case 2:
-		LoadStereo(input, length);
-		break;
-	default:
-		LoadMultiChannel(input, length);
-		break;
+	size_t consumed = 0;
+	const size_t length = m_polyphase_resampler->Resample(buffer.data(), m_buffer_offset, output.data(), kMaxBufferSize, &consumed);
+	ConsumeSamples(m_consumer, output.data(), int(length));
+	const size_t remaining = m_buffer_offset - consumed;
+	if (remaining > 0) {
+		std::copy(buffer.begin() + consumed, buffer.begin() + m_buffer_offset, buffer.begin());
 	}
-	m_buffer_offset += length;
-	return length;
+	m_buffer_offset = remaining;
 }
 
 void AudioProcessor::Resample()
 {
+	if (m_use_polyphase_resampler) {
+		if (m_buffer_float) {
+			ResamplePolyphase(m_float_buffer, m_float_resample_buffer);
+		} else {
+			ResamplePolyphase(m_buffer, m_resample_buffer);
+		}
+		return;
+	}
 #if USE_INTERNAL_AVRESAMPLE
-	if (m_resample_ctx) {
+	if (m_resample_filter) {
+		assert(!m_buffer_float);
 		int consumed = 0;
   	int length = av_resample(m_resample_ctx, m_resample_buffer.data(), m_buffer.data(), &consumed, int(m_buffer_offset), kMaxBufferSize, 1);
 		if (length > kMaxBufferSize) {
@@ -122,11 +283,32 @@ void AudioProcessor::Resample()
 	} else
 #endif
 	{
-		m_consumer->Consume(m_buffer.data(), int(m_buffer_offset));
+		if (m_buffer_float) {
+			m_consumer->ConsumeFloat(m_float_buffer.data(), int(m_buffer_offset));
+		} else {
+			m_consumer->Consume(m_buffer.data(), int(m_buffer_offset));
+		}
 		m_buffer_offset = 0;
 	}
 }
 
+bool AudioProcessor::PrepareBuffer(bool lossless)
+{
+	// avresample only works with 16-bit samples, the input is rounded right away
+	if (lossless || m_buffer_float || m_resample_filter) {
+		return m_buffer_float;
+	}
+	if (m_float_buffer.empty()) {
+		m_float_buffer.resize(kMaxBufferSize);
+	}
+	if (m_use_polyphase_resampler && m_float_resample_buffer.empty()) {
+		m_float_resample_buffer.resize(kMaxBufferSize);
+	}
+	// the 16-bit samples that are still buffered are converted exactly
+	std::copy(m_buffer.begin(), m_buffer.begin() + m_buffer_offset, m_float_buffer.begin());
+	m_buffer_float = true;
+	return true;
+}
 
 bool AudioProcessor::Reset(int sample_rate, int num_channels)
 {
@@ -140,68 +322,138 @@ bool AudioProcessor::Reset(int sample_rate, int num_channels)
 		return false;
 	}
 	m_buffer_offset = 0;
+	m_buffer_float = false;
     m_leftover.clear();
+	m_leftover_s32.clear();
+	m_leftover_float.clear();
 
+	// The resamplers are kept between streams and only switched to the new
+	// filters, so restarting a context doesn't allocate memory, unless the
+	// filters for the sample rate have to be built.
+	bool use_polyphase = false;
 #if USE_INTERNAL_AVRESAMPLE
-	if (m_resample_ctx) {
-		av_resample_close(m_resample_ctx);
-		m_resample_ctx = 0;
-	}
-	if (sample_rate != m_target_sample_rate) {
-		m_resample_ctx = av_resample_init(
-			m_target_sample_rate, sample_rate,
-			kResampleFilterLength,
-			kResamplePhaseShift,
-			kResampleLinear,
-			kResampleCutoff);
+	m_resample_filter.reset();
+	if (sample_rate != m_target_sample_rate && m_resampler == CHROMAPRINT_RESAMPLER_POLYPHASE && PolyphaseResampler::IsSupported(sample_rate, m_target_sample_rate)) {
+		use_polyphase = true;
+	} else if (sample_rate != m_target_sample_rate) {
+		m_resample_filter = GetResampleFilter(sample_rate, m_target_sample_rate);
+		if (m_resample_filter) {
+			if (m_resample_ctx) {
+				av_resample_reset_shared(m_resample_ctx, m_resample_filter.get());
+			} else {
+				m_resample_ctx = av_resample_init_shared(m_resample_filter.get());
+				if (!m_resample_ctx) {
+					m_resample_filter.reset();
+				}
+			}
+		}
 	}
 #else
+	// without avresample, the polyphase resampler is the only option
 	if (sample_rate != m_target_sample_rate) {
-		DEBUG("chromaprint::AudioProcessor::Reset() -- Cannot resample from " << sample_rate
-		           << " to " << m_target_sample_rate << " without internal avresample.");
-		return false;
+		if (!PolyphaseResampler::IsSupported(sample_rate, m_target_sample_rate)) {
+			DEBUG("chromaprint::AudioProcessor::Reset() -- Cannot resample from " << sample_rate
+			           << " to " << m_target_sample_rate << " without internal avresample.");
+			return false;
+		}
+		use_polyphase = true;
 	}
 #endif
+	if (use_polyphase) {
+		if (m_polyphase_resampler) {
+			m_polyphase_resampler->Reset(sample_rate, m_target_sample_rate);
+		} else {
+			m_polyphase_resampler.reset(new PolyphaseResampler(sample_rate, m_target_sample_rate));
+		}
+	}
+	m_use_polyphase_resampler = use_polyphase;
 	m_num_channels = num_channels;
 	return true;
 }
 
 void AudioProcessor::Consume(const int16_t *input, int length)
+{
+	ConsumeInterleaved(input, length, m_leftover);
+}
+
+void AudioProcessor::Consume(const int32_t *input, int length)
+{
+	ConsumeInterleaved(input, length, m_leftover_s32);
+}
+
+void AudioProcessor::Consume(const float *input, int length)
+{
+	ConsumeInterleaved(input, length, m_leftover_float);
+}
+
+void AudioProcessor::ConsumePlanar(const int16_t *const *input, int length)
+{
+	ConsumePlanarImpl(input, length);
+}
+
+void AudioProcessor::ConsumePlanar(const float *const *input, int length)
+{
+	ConsumePlanarImpl(input, length);
+}
+
+template <typename T>
+void AudioProcessor::ConsumeInterleaved(const T *input, int length, Vector<T> &leftover)
 {
 	assert(length >= 0);
-	if (!m_leftover.empty()) {
-		while (length > 0 && static_cast<int>(m_leftover.size()) < m_num_channels) {
-			m_leftover.push_back(*input++);
+	if (!leftover.empty()) {
+		while (length > 0 && static_cast<int>(leftover.size()) < m_num_channels) {
+			leftover.push_back(*input++);
 			length--;
 		}
-		if (static_cast<int>(m_leftover.size()) < m_num_channels) {
+		if (static_cast<int>(leftover.size()) < m_num_channels) {
 			return;
 		}
-		ConsumeAligned(&m_leftover[0], m_num_channels);
-		m_leftover.clear();
+		ConsumeAligned(&leftover[0], m_num_channels);
+		leftover.clear();
 	}
 	const int remainder = length % m_num_channels;
 	ConsumeAligned(input, length - remainder);
 	if (remainder > 0) {
-		m_leftover.assign(input + length - remainder, input + length);
+		leftover.assign(input + length - remainder, input + length);
 	}
 }
 
-void AudioProcessor::ConsumeAligned(const int16_t *input, int length)
+template <typename T>
+void AudioProcessor::ConsumeAligned(const T *input, int length)
 {
 	assert(length >= 0);
 	assert(length % m_num_channels == 0);
 	length /= m_num_channels;
 	while (length > 0) {
-		int consumed = Load(input, length);
-		input += consumed * m_num_channels;
-		length -= consumed;
-		if (m_buffer.size() == m_buffer_offset) {
-			Resample();
-			if (m_buffer.size() == m_buffer_offset) {
-				DEBUG("chromaprint::AudioProcessor::ConsumeAligned() -- Resampling failed?");
-				return;
-			}
+		const int count = GetBufferSpace(length);
+		if (PrepareBuffer(SampleTraits<T>::kLossless)) {
+			DownmixInterleaved(input, m_float_buffer.data() + m_buffer_offset, count, m_num_channels);
+		} else {
+			DownmixInterleaved(input, m_buffer.data() + m_buffer_offset, count, m_num_channels);
+		}
+		input += count * m_num_channels;
+		length -= count;
+		if (!CommitBuffer(count)) {
+			return;
+		}
+	}
+}
+
+template <typename T>
+void AudioProcessor::ConsumePlanarImpl(const T *const *input, int length)
+{
+	assert(length >= 0);
+	int offset = 0;
+	while (offset < length) {
+		const int count = GetBufferSpace(length - offset);
+		if (PrepareBuffer(SampleTraits<T>::kLossless)) {
+			DownmixPlanar(input, offset, m_float_buffer.data() + m_buffer_offset, count, m_num_channels);
+		} else {
+			DownmixPlanar(input, offset, m_buffer.data() + m_buffer_offset, count, m_num_channels);
+		}
+		offset += count;
+		if (!CommitBuffer(count)) {
+			return;
 		}
 	}
 }
@@ -6,12 +6,15 @@
 
 #include "utils.h"
 #include "audio_consumer.h"
+#include "chromaprint.h"
+#include <memory>
 #include <vector>
 
 struct AVResampleContext;
 
 namespace chromaprint
 {
+	class PolyphaseResampler;
 
 	class AudioProcessor : public AudioConsumer
 	{
@@ -29,11 +32,27 @@ namespace chromaprint
 			m_target_sample_rate = sample_rate;
 		}
 
+		int num_channels() const
+		{
+			return m_num_channels;
+		}
+
 		AudioConsumer *consumer() const
 		{
 			return m_consumer;
 		}
 
+		ChromaprintResampler resampler() const
+		{
+			return m_resampler;
+		}
+
+		//! Select the resampler, used from the next Reset()
+		void set_resampler(ChromaprintResampler resampler)
+		{
+			m_resampler = resampler;
+		}
+
 		void set_consumer(AudioConsumer *consumer)
 		{
 			m_consumer = consumer;
@@ -45,28 +64,65 @@ namespace chromaprint
 		//! Process a chunk of data from the audio stream
 		void Consume(const int16_t *input, int length);
 
+		/**
+		 * Process a chunk of 32-bit integer data from the audio stream.
+		 *
+		 * 32-bit and float input is downmixed to floats in the range of
+		 * 16-bit samples, which are resampled and passed to
+		 * AudioConsumer::ConsumeFloat() without rounding. Only avresample
+		 * needs 16-bit samples, with it the input is rounded when downmixing.
+		 */
+		void Consume(const int32_t *input, int length);
+
+		//! Process a chunk of floating point data (in the range -1.0 to 1.0) from the audio stream
+		void Consume(const float *input, int length);
+
+		//! Process a chunk of planar data, with one array per channel, length is the number of samples per channel
+		void ConsumePlanar(const int16_t *const *input, int length);
+		void ConsumePlanar(const float *const *input, int length);
+
 		//! Process any buffered input that was not processed before and clear buffers
 		void Flush();
 
 	private:
 		CHROMAPRINT_DISABLE_COPY(AudioProcessor);
 
-        void ConsumeAligned(const int16_t *input, int length);
-		int Load(const int16_t *input, int length);
-		void LoadMono(const int16_t *input, int length);
-		void LoadStereo(const int16_t *input, int length);
-		void LoadMultiChannel(const int16_t *input, int length);
+		template <typename T>
+		void ConsumeInterleaved(const T *input, int length, Vector<T> &leftover);
+		template <typename T>
+		void ConsumeAligned(const T *input, int length);
+		template <typename T>
+		void ConsumePlanarImpl(const T *const *input, int length);
+		int GetBufferSpace(int length) const;
+		bool CommitBuffer(int length);
+		//! Switch to the float buffer for input that is not lossless, returns whether it's used
+		bool PrepareBuffer(bool lossless);
+		template <typename Sample>
+		void ResamplePolyphase(Vector<Sample> &buffer, Vector<Sample> &output);
 		void Resample();
 
-		std::vector<int16_t> m_buffer;
+		Vector<int16_t> m_buffer;
 		size_t m_buffer_offset;
-		std::vector<int16_t> m_resample_buffer;
+		// After the first 32-bit or float input, the stream is buffered in
+		// the float buffers instead, they are allocated on the first use.
+		bool m_buffer_float;
+		Vector<float> m_float_buffer;
+		Vector<float> m_float_resample_buffer;
+		Vector<int16_t> m_resample_buffer;
 		int m_target_sample_rate;
 		int m_num_channels;
         // Trailing partial frame carried over between Consume() calls when a
         // caller splits its audio on non-frame boundaries.
-        std::vector<int16_t> m_leftover;
+        Vector<int16_t> m_leftover;
+		Vector<int32_t> m_leftover_s32;
+		Vector<float> m_leftover_float;
 		AudioConsumer *m_consumer;
+		ChromaprintResampler m_resampler;
+		std::unique_ptr<PolyphaseResampler> m_polyphase_resampler;
+		bool m_use_polyphase_resampler;
+		// avresample is used when the filter is set, the context is kept
+		// when it's not, but it may point to a filter that no longer exists
+		std::shared_ptr<const AVResampleContext> m_resample_filter;
 		struct AVResampleContext *m_resample_ctx;
 	};
 
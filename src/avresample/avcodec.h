@@ -76,6 +76,10 @@ static CHROMAPRINT_C_INLINE int av_clip(int a, int amin, int amax)
 
 struct AVResampleContext;
 struct AVResampleContext *av_resample_init(int out_rate, int in_rate, int filter_length, int log2_phase_count, int linear, double cutoff);
+/* Creates a context with the same settings as src, which shares its filter bank, src must outlive it. */
+struct AVResampleContext *av_resample_init_shared(const struct AVResampleContext *src);
+/* Reinitializes c like av_resample_init_shared(), without allocating a new context. */
+void av_resample_reset_shared(struct AVResampleContext *c, const struct AVResampleContext *src);
 int av_resample(struct AVResampleContext *c, short *dst, short *src, int *consumed, int src_size, int dst_size, int update_ctx);
 void av_resample_compensate(struct AVResampleContext *c, int sample_delta, int compensation_distance);
 void av_resample_close(struct AVResampleContext *c);
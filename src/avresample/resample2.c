@@ -69,6 +69,7 @@ typedef struct AVResampleContext{
     int phase_shift;
     int phase_mask;
     int linear;
+    int shared_filter_bank;
 }AVResampleContext;
 
 /**
@@ -218,8 +219,35 @@ error:
     return NULL;
 }
 
+void av_resample_reset_shared(AVResampleContext *c, const AVResampleContext *src){
+    int phase_count= 1<<src->phase_shift;
+
+    if (!c->shared_filter_bank)
+        av_freep(&c->filter_bank);
+
+    *c= *src;
+    c->shared_filter_bank= 1;
+    c->compensation_distance= 0;
+    c->dst_incr= c->ideal_dst_incr;
+    c->index= -phase_count*((c->filter_length-1)/2);
+    c->frac= 0;
+}
+
+AVResampleContext *av_resample_init_shared(const AVResampleContext *src){
+    AVResampleContext *c= av_mallocz(sizeof(AVResampleContext));
+
+    if (!c)
+        return NULL;
+
+    c->shared_filter_bank= 1;
+    av_resample_reset_shared(c, src);
+
+    return c;
+}
+
 void av_resample_close(AVResampleContext *c){
-    av_freep(&c->filter_bank);
+    if (!c->shared_filter_bank)
+        av_freep(&c->filter_bank);
     av_freep(&c);
 }
 
@@ -1,78 +1,44 @@
 // Copyright (C) 2010-2016  Lukas Lalinsky
 // Distributed under the MIT license, see the LICENSE file for details.
 
-#include <limits>
-#include <cmath>
-#include "fft_frame.h"
-#include "utils.h"
+#include <tuple>
 #include "chroma.h"
-#include "debug.h"
+#include "utils/shared_cache.h"
 
 namespace chromaprint {
 
-static const int NUM_BANDS = 12;
+namespace {
 
-inline double FreqToOctave(double freq, double base = 440.0 / 16.0)
-{
-	return log(freq / base) / log(2.0);
-}
-
-Chroma::Chroma(int min_freq, int max_freq, int frame_size, int sample_rate, FeatureVectorConsumer *consumer)
-	: m_interpolate(false),
-	  m_notes(frame_size),
-	  m_notes_frac(frame_size),
-	  m_features(NUM_BANDS),
-	  m_consumer(consumer)
-{
-	PrepareNotes(min_freq, max_freq, frame_size, sample_rate);
-}
-
-Chroma::~Chroma()
-{
-}
+const int NUM_BANDS = 12;
 
-void Chroma::PrepareNotes(int min_freq, int max_freq, int frame_size, int sample_rate)
+std::shared_ptr<ChromaNotes> CreateChromaNotes(int min_freq, int max_freq, int frame_size, int sample_rate)
 {
-	m_min_index = std::max(1, FreqToIndex(min_freq, frame_size, sample_rate));
-	m_max_index = std::min(frame_size / 2, FreqToIndex(max_freq, frame_size, sample_rate));
-	for (int i = m_min_index; i < m_max_index; i++) {
+	std::shared_ptr<ChromaNotes> table(new ChromaNotes());
+	table->notes.resize(frame_size);
+	table->notes_frac.resize(frame_size);
+	table->min_index = std::max(1, FreqToIndex(min_freq, frame_size, sample_rate));
+	table->max_index = std::min(frame_size / 2, FreqToIndex(max_freq, frame_size, sample_rate));
+	for (int i = table->min_index; i < table->max_index; i++) {
 		double freq = IndexToFreq(i, frame_size, sample_rate);
 		double octave = FreqToOctave(freq);
-		double note = NUM_BANDS * (octave - floor(octave)); 
-		m_notes[i] = (char)note;
-		m_notes_frac[i] = note - m_notes[i];
+		double note = NUM_BANDS * (octave - floor(octave));
+		table->notes[i] = (char)note;
+		table->notes_frac[i] = note - table->notes[i];
 	}
+	return table;
 }
 
-void Chroma::Reset()
-{
-}
+}; // namespace
 
-void Chroma::Consume(const FFTFrame &frame)
+std::shared_ptr<const ChromaNotes> GetChromaNotes(int min_freq, int max_freq, int frame_size, int sample_rate)
 {
-	fill(m_features.begin(), m_features.end(), 0.0);
-	for (int i = m_min_index; i < m_max_index; i++) {
-		int note = m_notes[i];
-		double energy = frame[i];
-		if (m_interpolate) {
-			int note2 = note;
-			double a = 1.0;
-			if (m_notes_frac[i] < 0.5) {
-				note2 = (note + NUM_BANDS - 1) % NUM_BANDS;
-				a = 0.5 + m_notes_frac[i];
-			}
-			if (m_notes_frac[i] > 0.5) {
-				note2 = (note + 1) % NUM_BANDS;
-				a = 1.5 - m_notes_frac[i];
-			}
-			m_features[note] += energy * a; 
-			m_features[note2] += energy * (1.0 - a); 
-		}
-		else {
-			m_features[note] += energy; 
-		}
-	}
-	m_consumer->Consume(m_features);
+	static SharedCache<std::tuple<int, int, int, int>, ChromaNotes> cache;
+	return cache.Get(std::make_tuple(min_freq, max_freq, frame_size, sample_rate), [&]() {
+		return CreateChromaNotes(min_freq, max_freq, frame_size, sample_rate);
+	});
 }
 
+template class BasicChroma<float>;
+template class BasicChroma<double>;
+
 }; // namespace chromaprint
@@ -5,17 +5,64 @@
 #define CHROMAPRINT_CHROMA_H_
 
 #include <math.h>
+#include <memory>
 #include <vector>
+#include <algorithm>
 #include "utils.h"
 #include "fft_frame_consumer.h"
 #include "feature_vector_consumer.h"
 
 namespace chromaprint {
 
-class Chroma : public FFTFrameConsumer {
+inline double FreqToOctave(double freq, double base = 440.0 / 16.0)
+{
+	return log(freq / base) / log(2.0);
+}
+
+/**
+ * Note of every bin of the power spectrum, between min_index and max_index.
+ * It only depends on the parameters of the transform, so it's shared by
+ * all chroma stages that use the same ones.
+ */
+struct ChromaNotes
+{
+	int min_index;
+	int max_index;
+	std::vector<char> notes;
+	std::vector<double> notes_frac;
+};
+
+//! Get the shared note mapping for the given parameters.
+std::shared_ptr<const ChromaNotes> GetChromaNotes(int min_freq, int max_freq, int frame_size, int sample_rate);
+
+/**
+ * Maps the power spectrum to the 12 notes of the octave.
+ *
+ * The features are passed to a Consumer, which is the virtual consumer
+ * interface by default, but can be the exact type of the next stage, so
+ * that the compiler can inline it (see StaticFingerprintPipeline).
+ *
+ * If the block size is larger than 1, the features are collected and
+ * passed to the consumer in blocks of that many vectors, so that the
+ * following stages can process multiple frames at once. Flush() must be
+ * called at the end of the stream to pass the last incomplete block.
+ */
+template <typename T, typename Consumer = BasicFeatureVectorConsumer<T>>
+class BasicChroma final : public BasicFFTFrameConsumer<T> {
 public:
-	Chroma(int min_freq, int max_freq, int frame_size, int sample_rate, FeatureVectorConsumer *consumer);
-	~Chroma();
+	BasicChroma(int min_freq, int max_freq, int frame_size, int sample_rate, Consumer *consumer)
+		: m_interpolate(false),
+		  m_table(GetChromaNotes(min_freq, max_freq, frame_size, sample_rate)),
+		  m_notes(m_table->notes.data()),
+		  m_notes_frac(m_table->notes_frac.data()),
+		  m_min_index(m_table->min_index),
+		  m_max_index(m_table->max_index),
+		  m_features(NUM_BANDS),
+		  m_consumer(consumer)
+	{
+	}
+
+	~BasicChroma() {}
 
 	bool interpolate() const {
 		return m_interpolate;
@@ -25,23 +72,107 @@ public:
 		m_interpolate = interpolate;
 	}
 
-	void Reset();
-	void Consume(const FFTFrame &frame);
+	size_t block_size() const {
+		return m_block_size;
+	}
+
+	void set_block_size(size_t block_size) {
+		Flush();
+		m_block_size = std::max(block_size, size_t(1));
+		m_block.resize(m_block_size * NUM_BANDS);
+	}
+
+	void Reset() {
+		m_block_rows = 0;
+	}
+
+	//! Pass the collected features to the consumer.
+	void Flush() {
+		if (m_block_rows > 0) {
+			const auto num_rows = m_block_rows;
+			m_block_rows = 0;
+			m_consumer->ConsumeBlock(m_block.data(), num_rows, NUM_BANDS);
+		}
+	}
+
+	void Consume(const BasicFFTFrame<T> &frame) override {
+		Accumulate([&](size_t i) { return frame[i]; });
+	}
+
+	/**
+	 * Calculate the features directly from the output of the transform
+	 * (an FFTLib), without going through the full power spectrum. Only the
+	 * bins that are mapped to notes are computed.
+	 */
+	template <typename FFTLibType>
+	void ConsumeTransform(const FFTLibType &lib) {
+		Accumulate([&](size_t i) { return lib.Power(i); });
+	}
 
 private:
-	CHROMAPRINT_DISABLE_COPY(Chroma);
+	CHROMAPRINT_DISABLE_COPY(BasicChroma);
 
-	void PrepareNotes(int min_freq, int max_freq, int frame_size, int sample_rate);
+	static const int NUM_BANDS = 12;
+
+	template <typename Spectrum>
+	void Accumulate(const Spectrum &spectrum)
+	{
+		if (m_block_size > 1) {
+			CalculateFeatures(spectrum, m_block.data() + m_block_rows * NUM_BANDS);
+			if (++m_block_rows == m_block_size) {
+				Flush();
+			}
+		} else {
+			CalculateFeatures(spectrum, m_features.data());
+			m_consumer->Consume(m_features);
+		}
+	}
+
+	template <typename Spectrum>
+	void CalculateFeatures(const Spectrum &spectrum, T *features)
+	{
+		std::fill(features, features + NUM_BANDS, T(0));
+		for (int i = m_min_index; i < m_max_index; i++) {
+			int note = m_notes[i];
+			T energy = spectrum(i);
+			if (m_interpolate) {
+				int note2 = note;
+				T a = 1;
+				if (m_notes_frac[i] < 0.5) {
+					note2 = (note + NUM_BANDS - 1) % NUM_BANDS;
+					a = 0.5 + m_notes_frac[i];
+				}
+				if (m_notes_frac[i] > 0.5) {
+					note2 = (note + 1) % NUM_BANDS;
+					a = 1.5 - m_notes_frac[i];
+				}
+				features[note] += energy * a; 
+				features[note2] += energy * (1 - a); 
+			}
+			else {
+				features[note] += energy; 
+			}
+		}
+	}
 
 	bool m_interpolate;
-	std::vector<char> m_notes;
-	std::vector<double> m_notes_frac;
+	std::shared_ptr<const ChromaNotes> m_table;
+	const char *m_notes;
+	const double *m_notes_frac;
 	int m_min_index;
 	int m_max_index;
-	std::vector<double> m_features;
-	FeatureVectorConsumer *m_consumer;
+	std::vector<T> m_features;
+	Vector<T> m_block;
+	size_t m_block_size = 1;
+	size_t m_block_rows = 0;
+	Consumer *m_consumer;
 };
 
+extern template class BasicChroma<float>;
+extern template class BasicChroma<double>;
+
+typedef BasicChroma<double> Chroma;
+
 }; // namespace chromaprint
 
 #endif
@@ -4,32 +4,101 @@
 #ifndef CHROMAPRINT_CHROMA_FILTER_H_
 #define CHROMAPRINT_CHROMA_FILTER_H_
 
+#include <cassert>
 #include <vector>
+#include <algorithm>
 #include "feature_vector_consumer.h"
 
 namespace chromaprint {
 	
-class ChromaFilter : public FeatureVectorConsumer {
+/**
+ * FIR filter applied to every band of the chroma features over time.
+ *
+ * Vectors passed to Consume() and ConsumeBlock() form one stream, the
+ * filter keeps the last length - 1 vectors between the calls.
+ */
+template <typename T, typename Consumer = BasicFeatureVectorConsumer<T>>
+class BasicChromaFilter final : public BasicFeatureVectorConsumer<T> {
 public:
-	ChromaFilter(const double *coefficients, int length, FeatureVectorConsumer *consumer);
-	~ChromaFilter();
+	BasicChromaFilter(const double *coefficients, int length, Consumer *consumer)
+		: m_coefficients(coefficients),
+		  m_length(length),
+		  m_consumer(consumer)
+	{
+		assert(length > 0);
+	}
 
-	void Reset();
-	void Consume(std::vector<double> &features);
+	~BasicChromaFilter() {}
 
-	FeatureVectorConsumer *consumer() { return m_consumer; }
-	void set_consumer(FeatureVectorConsumer *consumer) { m_consumer = consumer; }
+	void Reset()
+	{
+		m_input.clear();
+	}
+
+	void Consume(std::vector<T> &features) override
+	{
+		assert(features.size() == NUM_BANDS);
+		if (Filter(features.data(), 1) > 0) {
+			m_row.assign(m_output.begin(), m_output.end());
+			m_consumer->Consume(m_row);
+		}
+	}
+
+	void ConsumeBlock(T *features, size_t num_rows, size_t num_columns) override
+	{
+		assert(num_columns == NUM_BANDS);
+		const size_t num_output_rows = Filter(features, num_rows);
+		if (num_output_rows > 0) {
+			m_consumer->ConsumeBlock(m_output.data(), num_output_rows, NUM_BANDS);
+		}
+	}
+
+	Consumer *consumer() { return m_consumer; }
+	void set_consumer(Consumer *consumer) { m_consumer = consumer; }
 
 private:
+	static const size_t NUM_BANDS = 12;
+
+	// Append the rows to the input and filter all complete windows into
+	// m_output, returns the number of output rows.
+	size_t Filter(const T *features, size_t num_rows)
+	{
+		m_input.insert(m_input.end(), features, features + num_rows * NUM_BANDS);
+		const size_t length = m_length;
+		const size_t num_input_rows = m_input.size() / NUM_BANDS;
+		if (num_input_rows < length) {
+			return 0;
+		}
+		const size_t num_output_rows = num_input_rows - length + 1;
+		m_output.assign(num_output_rows * NUM_BANDS, T(0));
+		for (size_t row = 0; row < num_output_rows; row++) {
+			T *output = m_output.data() + row * NUM_BANDS;
+			for (size_t j = 0; j < length; j++) {
+				const T *input = m_input.data() + (row + j) * NUM_BANDS;
+				const T coefficient = T(m_coefficients[j]);
+				for (size_t i = 0; i < NUM_BANDS; i++) {
+					output[i] += input[i] * coefficient;
+				}
+			}
+		}
+		m_input.erase(m_input.begin(), m_input.begin() + num_output_rows * NUM_BANDS);
+		return num_output_rows;
+	}
+
 	const double *m_coefficients;
 	int m_length;
-	std::vector< std::vector<double> > m_buffer;
-	std::vector<double> m_result;
-	int m_buffer_offset;
-	int m_buffer_size;
-	FeatureVectorConsumer *m_consumer;
+	Vector<T> m_input;
+	Vector<T> m_output;
+	// single rows are passed on as std::vector, see Consume()
+	std::vector<T> m_row;
+	Consumer *m_consumer;
 };
 
+extern template class BasicChromaFilter<float>;
+extern template class BasicChromaFilter<double>;
+
+typedef BasicChromaFilter<double> ChromaFilter;
+
 }; // namespace chromaprint
 
 #endif
@@ -11,26 +11,38 @@
 
 namespace chromaprint {
 
-class ChromaNormalizer : public FeatureVectorConsumer {
+template <typename T, typename Consumer = BasicFeatureVectorConsumer<T>>
+class BasicChromaNormalizer final : public BasicFeatureVectorConsumer<T> {
 public:
-	ChromaNormalizer(FeatureVectorConsumer *consumer) : m_consumer(consumer) {}
-	~ChromaNormalizer() {}
+	BasicChromaNormalizer(Consumer *consumer) : m_consumer(consumer) {}
+	~BasicChromaNormalizer() {}
 	void Reset() {}
 
-	void Consume(std::vector<double> &features)
+	void Consume(std::vector<T> &features) override
 	{
 		NormalizeVector(features.begin(), features.end(),
-						chromaprint::EuclideanNorm<std::vector<double>::iterator>,
+						chromaprint::EuclideanNorm<typename std::vector<T>::iterator>,
 						0.01);
 		m_consumer->Consume(features);
 	}
 
+	void ConsumeBlock(T *features, size_t num_rows, size_t num_columns) override
+	{
+		for (size_t i = 0; i < num_rows; i++) {
+			T *row = features + i * num_columns;
+			NormalizeVector(row, row + num_columns, chromaprint::EuclideanNorm<T *>, 0.01);
+		}
+		m_consumer->ConsumeBlock(features, num_rows, num_columns);
+	}
+
 private:
-	CHROMAPRINT_DISABLE_COPY(ChromaNormalizer);
+	CHROMAPRINT_DISABLE_COPY(BasicChromaNormalizer);
 
-	FeatureVectorConsumer *m_consumer;
+	Consumer *m_consumer;
 };
 
+typedef BasicChromaNormalizer<double> ChromaNormalizer;
+
 }; // namespace chromaprint
 
 #endif
@@ -4,41 +4,150 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <cstring>
 #include <chromaprint.h>
 #include "fingerprinter.h"
+#include "multi_fingerprinter.h"
+#include "fingerprint_consumer.h"
+#include "fingerprint_window.h"
 #include "fingerprint_compressor.h"
 #include "fingerprint_decompressor.h"
 #include "fingerprint_matcher.h"
 #include "fingerprinter_configuration.h"
+#include "pipeline_stats.h"
+#include "utils/allocator.h"
 #include "utils/base64.h"
+#include "utils/thread_pool.h"
 #include "simhash.h"
 #include "debug.h"
 
 using namespace chromaprint;
 
-struct ChromaprintContextPrivate {
-	ChromaprintContextPrivate(int algorithm)
-		: algorithm(algorithm),
+class CallbackFingerprintConsumer : public FingerprintConsumer {
+public:
+	CallbackFingerprintConsumer(ChromaprintFingerprintCallback callback, void *user_data)
+		: m_callback(callback), m_user_data(user_data) {}
+
+	virtual void Consume(const uint32_t *fingerprint, size_t size, size_t offset) override {
+		m_callback(m_user_data, fingerprint, int(size), int(offset));
+	}
+
+private:
+	ChromaprintFingerprintCallback m_callback;
+	void *m_user_data;
+};
+
+struct ChromaprintContextPrivate : public Allocated {
+	// Takes over the reference to the counter, which must already be the
+	// current memory scope, so that the context itself is counted as well.
+	ChromaprintContextPrivate(int algorithm, MemoryCounter *memory)
+		: memory(memory),
+		  algorithm(algorithm),
 		  fingerprinter(CreateFingerprinterConfiguration(algorithm)) {}
+	~ChromaprintContextPrivate() {
+		memory->Unref();
+	}
+
+	static ChromaprintContextPrivate *Create(int algorithm) {
+		MemoryCounter *memory = MemoryCounter::Create();
+		MemoryScope scope(memory);
+		return new ChromaprintContextPrivate(algorithm, memory);
+	}
+
+	MemoryCounter *memory;
 	int algorithm;
 	Fingerprinter fingerprinter;
 	FingerprintCompressor compressor;
 	std::string tmp_fingerprint;
+	std::unique_ptr<CallbackFingerprintConsumer> fingerprint_consumer;
+	std::unique_ptr<FingerprintWindow> window;
+	std::unique_ptr<CallbackFingerprintConsumer> window_consumer;
+
+	// Items of audio that was already fed are included, even before finish().
+	const Vector<uint32_t> &GetFingerprint() {
+		if (window) {
+			fingerprinter.Flush();
+			return window->GetFingerprint();
+		}
+		return fingerprinter.GetFingerprint();
+	}
+
+	// Restore the options of a new context, but keep all allocated memory.
+	void Recycle() {
+		fingerprint_consumer.reset();
+		window.reset();
+		window_consumer.reset();
+		fingerprinter.SetFingerprintConsumer(nullptr);
+		fingerprinter.SetOption("silence_threshold", fingerprinter.config()->silence_threshold());
+		fingerprinter.SetOption("resampler", CHROMAPRINT_RESAMPLER_DEFAULT);
+		fingerprinter.SetOption("num_threads", 1);
+		fingerprinter.ClearFingerprint();
+		fingerprinter.stats()->Reset();
+		memory->ResetPeak();
+	}
+};
+
+struct ChromaprintContextPoolPrivate : public Allocated {
+	explicit ChromaprintContextPoolPrivate(int max_idle) : max_idle(size_t(max_idle)) {}
+	size_t max_idle;
+	std::mutex mutex;
+	std::map<int, std::vector<std::unique_ptr<ChromaprintContext>>> idle;
 };
 
-struct ChromaprintMatcherContextPrivate {
+struct ChromaprintMatcherContextPrivate : public Allocated {
 	int algorithm = -1;
 	std::unique_ptr<FingerprintMatcher> matcher;
 	std::vector<uint32_t> fp[2];
+	int fp_algorithm[2] = { -1, -1 };
 	FingerprintDecompressor decompressor;
+	std::string tmp_encoded;
+	std::string tmp_decoded;
+};
+
+struct ChromaprintBatchPrivate : public Allocated {
+	struct Job {
+		const int16_t *data;
+		int size;
+		int sample_rate;
+		int num_channels;
+		bool ok;
+		Vector<uint32_t> fingerprint;
+	};
+	ChromaprintBatchPrivate(int algorithm, int num_threads)
+		: algorithm(algorithm), pool(num_threads) {}
+	int algorithm;
+	ThreadPool pool;
+	std::vector<std::unique_ptr<Fingerprinter>> fingerprinters;
+	std::vector<Job> jobs;
+	FingerprintCompressor compressor;
+	std::string tmp_fingerprint;
+};
+
+struct ChromaprintMultiContextPrivate : public Allocated {
+	ChromaprintMultiContextPrivate(const int *algorithms, int num_algorithms)
+		: algorithms(algorithms, algorithms + num_algorithms),
+		  fingerprinter(algorithms, num_algorithms) {}
+	std::vector<int> algorithms;
+	MultiFingerprinter fingerprinter;
+	FingerprintCompressor compressor;
+	std::string tmp_fingerprint;
 };
 
 extern "C" {
 
 #define FAIL_IF(x, msg) if (x) { DEBUG(msg); return 0; }
 
+// Memory returned to the caller doesn't belong to any context, even if it's
+// allocated in a fingerprint callback.
+static void *AllocateResult(size_t size)
+{
+	MemoryScope scope(nullptr);
+	return Allocate(size);
+}
+
 #define STR(x) #x
 #define VERSION_STR(major, minor, patch) \
 	STR(major) "." STR(minor) "." STR(patch)
@@ -53,9 +162,15 @@ const char *chromaprint_get_version(void)
 	return version_str;
 }
 
+int chromaprint_set_allocator(const ChromaprintAllocator *allocator)
+{
+	FAIL_IF(!SetAllocator(allocator), "allocate and deallocate functions can't be NULL");
+	return 1;
+}
+
 ChromaprintContext *chromaprint_new(int algorithm)
 {
-	return new ChromaprintContextPrivate(algorithm);
+	return ChromaprintContextPrivate::Create(algorithm);
 }
 
 void chromaprint_free(ChromaprintContext *ctx)
@@ -65,6 +180,84 @@ void chromaprint_free(ChromaprintContext *ctx)
 	}
 }
 
+ChromaprintContextPool *chromaprint_pool_new(int max_idle)
+{
+	FAIL_IF(max_idle < 0, "maximum number of idle contexts can't be negative");
+	return new ChromaprintContextPoolPrivate(max_idle);
+}
+
+void chromaprint_pool_free(ChromaprintContextPool *pool)
+{
+	if (pool) {
+		delete pool;
+	}
+}
+
+int chromaprint_pool_reserve(ChromaprintContextPool *pool, int algorithm, int num_contexts, int sample_rate)
+{
+	FAIL_IF(!pool, "pool can't be NULL");
+	FAIL_IF(num_contexts < 0, "number of contexts can't be negative");
+	std::lock_guard<std::mutex> lock(pool->mutex);
+	auto &idle = pool->idle[algorithm];
+	const size_t size = std::min(std::max(idle.size(), size_t(num_contexts)), pool->max_idle);
+	idle.reserve(pool->max_idle);
+	while (idle.size() < size) {
+		std::unique_ptr<ChromaprintContext> ctx(ChromaprintContextPrivate::Create(algorithm));
+		// builds the resampler for the sample rate, which is reused for any other
+		MemoryScope scope(ctx->memory);
+		if (sample_rate > 0 && !ctx->fingerprinter.Start(sample_rate, 1)) {
+			return 0;
+		}
+		idle.push_back(std::move(ctx));
+	}
+	return 1;
+}
+
+int chromaprint_pool_get_num_idle(ChromaprintContextPool *pool, int algorithm, int *num_idle)
+{
+	FAIL_IF(!pool, "pool can't be NULL");
+	std::lock_guard<std::mutex> lock(pool->mutex);
+	auto it = pool->idle.find(algorithm);
+	*num_idle = it != pool->idle.end() ? int(it->second.size()) : 0;
+	return 1;
+}
+
+ChromaprintContext *chromaprint_pool_acquire(ChromaprintContextPool *pool, int algorithm)
+{
+	FAIL_IF(!pool, "pool can't be NULL");
+	{
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		auto it = pool->idle.find(algorithm);
+		if (it != pool->idle.end() && !it->second.empty()) {
+			ChromaprintContext *ctx = it->second.back().release();
+			it->second.pop_back();
+			return ctx;
+		}
+	}
+	return chromaprint_new(algorithm);
+}
+
+void chromaprint_pool_release(ChromaprintContextPool *pool, ChromaprintContext *ctx)
+{
+	if (!ctx) {
+		return;
+	}
+	std::unique_ptr<ChromaprintContext> owned(ctx);
+	if (!pool) {
+		return;
+	}
+	{
+		MemoryScope scope(owned->memory);
+		owned->Recycle();
+	}
+	std::lock_guard<std::mutex> lock(pool->mutex);
+	auto &idle = pool->idle[owned->algorithm];
+	if (idle.size() < pool->max_idle) {
+		idle.reserve(pool->max_idle);
+		idle.push_back(std::move(owned));
+	}
+}
+
 int chromaprint_get_algorithm(ChromaprintContext *ctx)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
@@ -74,6 +267,7 @@ int chromaprint_get_algorithm(ChromaprintContext *ctx)
 int chromaprint_set_option(ChromaprintContext *ctx, const char *name, int value)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
+	MemoryScope scope(ctx->memory);
 	return ctx->fingerprinter.SetOption(name, value) ? 1 : 0;
 }
 
@@ -110,19 +304,63 @@ int chromaprint_get_delay_ms(ChromaprintContext *ctx)
 int chromaprint_start(ChromaprintContext *ctx, int sample_rate, int num_channels)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
+	MemoryScope scope(ctx->memory);
+	if (ctx->window) {
+		ctx->window->Reset();
+	}
 	return ctx->fingerprinter.Start(sample_rate, num_channels) ? 1 : 0;
 }
 
 int chromaprint_feed(ChromaprintContext *ctx, const int16_t *data, int length)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
+	MemoryScope scope(ctx->memory);
 	ctx->fingerprinter.Consume(data, length);
 	return 1;
 }
 
+int chromaprint_feed_float(ChromaprintContext *ctx, const float *data, int length)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(length < 0, "length can't be negative");
+	MemoryScope scope(ctx->memory);
+	ctx->fingerprinter.Consume(data, length);
+	return 1;
+}
+
+int chromaprint_feed_int32(ChromaprintContext *ctx, const int32_t *data, int length)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(length < 0, "length can't be negative");
+	MemoryScope scope(ctx->memory);
+	ctx->fingerprinter.Consume(data, length);
+	return 1;
+}
+
+int chromaprint_feed_planar(ChromaprintContext *ctx, const int16_t *const *data, int length)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(!data, "data can't be NULL");
+	FAIL_IF(length < 0, "length can't be negative");
+	MemoryScope scope(ctx->memory);
+	ctx->fingerprinter.ConsumePlanar(data, length);
+	return 1;
+}
+
+int chromaprint_feed_float_planar(ChromaprintContext *ctx, const float *const *data, int length)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(!data, "data can't be NULL");
+	FAIL_IF(length < 0, "length can't be negative");
+	MemoryScope scope(ctx->memory);
+	ctx->fingerprinter.ConsumePlanar(data, length);
+	return 1;
+}
+
 int chromaprint_finish(ChromaprintContext *ctx)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
+	MemoryScope scope(ctx->memory);
 	ctx->fingerprinter.Finish();
 	return 1;
 }
@@ -130,8 +368,9 @@ int chromaprint_finish(ChromaprintContext *ctx)
 int chromaprint_get_fingerprint(ChromaprintContext *ctx, char **data)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
-	ctx->compressor.Compress(ctx->fingerprinter.GetFingerprint(), ctx->algorithm, ctx->tmp_fingerprint);
-	*data = (char *) malloc(GetBase64EncodedSize(ctx->tmp_fingerprint.size()) + 1);
+	MemoryScope scope(ctx->memory);
+	ctx->compressor.Compress(ctx->GetFingerprint(), ctx->algorithm, ctx->tmp_fingerprint);
+	*data = (char *) AllocateResult(GetBase64EncodedSize(ctx->tmp_fingerprint.size()) + 1);
 	FAIL_IF(!*data, "can't allocate memory for the result");
 	Base64Encode(ctx->tmp_fingerprint.begin(), ctx->tmp_fingerprint.end(), *data, true);
 	return 1;
@@ -140,8 +379,9 @@ int chromaprint_get_fingerprint(ChromaprintContext *ctx, char **data)
 int chromaprint_get_raw_fingerprint(ChromaprintContext *ctx, uint32_t **data, int *size)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
-	const auto fingerprint = ctx->fingerprinter.GetFingerprint();
-	*data = (uint32_t *) malloc(sizeof(uint32_t) * fingerprint.size());
+	MemoryScope scope(ctx->memory);
+	const auto &fingerprint = ctx->GetFingerprint();
+	*data = (uint32_t *) AllocateResult(sizeof(uint32_t) * fingerprint.size());
 	FAIL_IF(!*data, "can't allocate memory for the result");
 	*size = int(fingerprint.size());
 	std::copy(fingerprint.begin(), fingerprint.end(), *data);
@@ -151,7 +391,8 @@ int chromaprint_get_raw_fingerprint(ChromaprintContext *ctx, uint32_t **data, in
 int chromaprint_get_raw_fingerprint_size(ChromaprintContext *ctx, int *size)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
-	const auto fingerprint = ctx->fingerprinter.GetFingerprint();
+	MemoryScope scope(ctx->memory);
+	const auto &fingerprint = ctx->GetFingerprint();
 	*size = int(fingerprint.size());
 	return 1;
 }
@@ -159,17 +400,110 @@ int chromaprint_get_raw_fingerprint_size(ChromaprintContext *ctx, int *size)
 int chromaprint_get_fingerprint_hash(ChromaprintContext *ctx, uint32_t *hash)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
-	*hash = SimHash(ctx->fingerprinter.GetFingerprint());
+	MemoryScope scope(ctx->memory);
+	*hash = SimHash(ctx->GetFingerprint());
 	return 1;
 }
 
 int chromaprint_clear_fingerprint(ChromaprintContext *ctx)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
+	MemoryScope scope(ctx->memory);
 	ctx->fingerprinter.ClearFingerprint();
+	if (ctx->window) {
+		ctx->window->ClearFingerprint();
+	}
+	return 1;
+}
+
+int chromaprint_set_fingerprint_callback(ChromaprintContext *ctx, ChromaprintFingerprintCallback callback, void *user_data)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	MemoryScope scope(ctx->memory);
+	ctx->window.reset();
+	ctx->window_consumer.reset();
+	if (callback) {
+		ctx->fingerprint_consumer.reset(new CallbackFingerprintConsumer(callback, user_data));
+	} else {
+		ctx->fingerprint_consumer.reset();
+	}
+	ctx->fingerprinter.SetFingerprintConsumer(ctx->fingerprint_consumer.get());
 	return 1;
 }
 
+int chromaprint_set_sliding_window(ChromaprintContext *ctx, int window_ms, int step_ms, ChromaprintFingerprintCallback callback, void *user_data)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(window_ms < 0 || step_ms < 0, "window size and step can't be negative");
+	MemoryScope scope(ctx->memory);
+	ctx->fingerprint_consumer.reset();
+	ctx->window.reset();
+	ctx->window_consumer.reset();
+	if (window_ms > 0) {
+		const double item_duration_ms = ctx->fingerprinter.config()->item_duration_in_seconds() * 1000.0;
+		const size_t window_size = std::max(size_t(1), size_t(window_ms / item_duration_ms + 0.5));
+		const size_t window_step = step_ms > 0 ? std::max(size_t(1), size_t(step_ms / item_duration_ms + 0.5)) : 0;
+		if (callback) {
+			ctx->window_consumer.reset(new CallbackFingerprintConsumer(callback, user_data));
+		}
+		ctx->window.reset(new FingerprintWindow(window_size, window_step, ctx->window_consumer.get()));
+	}
+	ctx->fingerprinter.SetFingerprintConsumer(ctx->window.get());
+	return 1;
+}
+
+int chromaprint_get_stats(ChromaprintContext *ctx, ChromaprintStageStats *stats, int num_stages)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(!stats, "stats can't be NULL");
+	FAIL_IF(!PipelineStats::IsEnabled(), "statistics are not enabled, rebuild with ENABLE_STATS");
+	num_stages = std::min(num_stages, int(CHROMAPRINT_NUM_STAGES));
+	for (int i = 0; i < num_stages; i++) {
+		stats[i] = ctx->fingerprinter.stats()->GetStats(ChromaprintStage(i));
+	}
+	return 1;
+}
+
+int chromaprint_reset_stats(ChromaprintContext *ctx)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	ctx->fingerprinter.stats()->Reset();
+	return 1;
+}
+
+int chromaprint_get_memory_usage(ChromaprintContext *ctx, uint64_t *current, uint64_t *peak)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	if (current) {
+		*current = ctx->memory->current();
+	}
+	if (peak) {
+		*peak = ctx->memory->peak();
+	}
+	return 1;
+}
+
+const char *chromaprint_get_stage_name(int stage)
+{
+	switch (stage) {
+	case CHROMAPRINT_STAGE_AUDIO_PROCESSOR:
+		return "AudioProcessor";
+	case CHROMAPRINT_STAGE_SILENCE_REMOVER:
+		return "SilenceRemover";
+	case CHROMAPRINT_STAGE_FFT:
+		return "FFT";
+	case CHROMAPRINT_STAGE_CHROMA:
+		return "Chroma";
+	case CHROMAPRINT_STAGE_CHROMA_FILTER:
+		return "ChromaFilter";
+	case CHROMAPRINT_STAGE_CHROMA_NORMALIZER:
+		return "ChromaNormalizer";
+	case CHROMAPRINT_STAGE_FINGERPRINT_CALCULATOR:
+		return "FingerprintCalculator";
+	}
+	return NULL;
+}
+
 int chromaprint_encode_fingerprint(const uint32_t *fp, int size, int algorithm, char **encoded_fp, int *encoded_size, int base64)
 {
 	std::vector<uint32_t> uncompressed(fp, fp + size);
@@ -177,7 +511,7 @@ int chromaprint_encode_fingerprint(const uint32_t *fp, int size, int algorithm,
 	if (base64) {
 		encoded = Base64Encode(encoded);
 	}
-	*encoded_fp = (char *) malloc(encoded.size() + 1);
+	*encoded_fp = (char *) AllocateResult(encoded.size() + 1);
 	*encoded_size = int(encoded.size());
 	std::copy(encoded.data(), encoded.data() + encoded.size() + 1, *encoded_fp);
 	return 1;
@@ -200,7 +534,7 @@ int chromaprint_decode_fingerprint(const char *encoded_fp, int encoded_size, uin
 		}
 		return 0;
 	}
-	*fp = (uint32_t *) malloc(sizeof(uint32_t) * uncompressed.size());
+	*fp = (uint32_t *) AllocateResult(sizeof(uint32_t) * uncompressed.size());
 	*size = int(uncompressed.size());
 	if (algorithm) {
 		*algorithm = algo;
@@ -245,9 +579,284 @@ int chromaprint_hash_fingerprint(const uint32_t *fp, int size, uint32_t *hash)
 	return 1;
 }
 
+ChromaprintMatcherContext *chromaprint_matcher_new(void)
+{
+	return new ChromaprintMatcherContextPrivate();
+}
+
+void chromaprint_matcher_free(ChromaprintMatcherContext *ctx)
+{
+	if (ctx) {
+		delete ctx;
+	}
+}
+
+int chromaprint_matcher_set_fingerprint(ChromaprintMatcherContext *ctx, int idx, const uint32_t *fp, int size, int algorithm)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(idx != 0 && idx != 1, "fingerprint index must be 0 or 1");
+	FAIL_IF(!fp && size > 0, "fingerprint can't be NULL");
+	FAIL_IF(size < 0, "size can't be negative");
+	ctx->fp[idx].assign(fp, fp + size);
+	ctx->fp_algorithm[idx] = algorithm;
+	return 1;
+}
+
+int chromaprint_matcher_set_encoded_fingerprint(ChromaprintMatcherContext *ctx, int idx, const char *encoded_fp, int encoded_size, int base64)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(idx != 0 && idx != 1, "fingerprint index must be 0 or 1");
+	FAIL_IF(!encoded_fp || encoded_size < 0, "invalid encoded fingerprint");
+	ctx->tmp_encoded.assign(encoded_fp, encoded_size);
+	if (base64) {
+		Base64Decode(ctx->tmp_encoded, ctx->tmp_decoded);
+		std::swap(ctx->tmp_encoded, ctx->tmp_decoded);
+	}
+	FAIL_IF(!ctx->decompressor.Decompress(ctx->tmp_encoded), "invalid encoded fingerprint");
+	const auto &output = ctx->decompressor.GetOutput();
+	ctx->fp[idx].assign(output.begin(), output.end());
+	ctx->fp_algorithm[idx] = ctx->decompressor.GetAlgorithm();
+	return 1;
+}
+
+int chromaprint_matcher_run(ChromaprintMatcherContext *ctx)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	// a failed run must not report the segments of the previous one
+	if (ctx->matcher) {
+		ctx->matcher->ClearSegments();
+	}
+	FAIL_IF(ctx->fp_algorithm[0] != ctx->fp_algorithm[1], "fingerprints were calculated with different algorithms");
+	if (!ctx->matcher || ctx->algorithm != ctx->fp_algorithm[0]) {
+		auto config = CreateFingerprinterConfiguration(ctx->fp_algorithm[0]);
+		FAIL_IF(!config, "unknown algorithm");
+		ctx->matcher.reset(new FingerprintMatcher(config));
+		ctx->algorithm = ctx->fp_algorithm[0];
+	}
+	return ctx->matcher->Match(ctx->fp[0], ctx->fp[1]) ? 1 : 0;
+}
+
+int chromaprint_matcher_get_num_segments(ChromaprintMatcherContext *ctx, int *num_segments)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(!ctx->matcher, "no matching was done yet");
+	*num_segments = int(ctx->matcher->segments().size());
+	return 1;
+}
+
+int chromaprint_matcher_get_segment_position(ChromaprintMatcherContext *ctx, int idx, int *pos1, int *pos2, int *duration)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(!ctx->matcher, "no matching was done yet");
+	const auto &segments = ctx->matcher->segments();
+	FAIL_IF(idx < 0 || size_t(idx) >= segments.size(), "segment index out of range");
+	const auto &segment = segments[idx];
+	*pos1 = int(segment.pos1);
+	*pos2 = int(segment.pos2);
+	*duration = int(segment.duration);
+	return 1;
+}
+
+int chromaprint_matcher_get_segment_position_ms(ChromaprintMatcherContext *ctx, int idx, int *pos1, int *pos2, int *duration)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(!ctx->matcher, "no matching was done yet");
+	const auto &segments = ctx->matcher->segments();
+	FAIL_IF(idx < 0 || size_t(idx) >= segments.size(), "segment index out of range");
+	const auto &segment = segments[idx];
+	*pos1 = int(ctx->matcher->GetHashTime(segment.pos1) * 1000.0 + 0.5);
+	*pos2 = int(ctx->matcher->GetHashTime(segment.pos2) * 1000.0 + 0.5);
+	*duration = int(ctx->matcher->GetHashTime(segment.duration) * 1000.0 + 0.5);
+	return 1;
+}
+
+int chromaprint_matcher_get_segment_score(ChromaprintMatcherContext *ctx, int idx, int *score)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(!ctx->matcher, "no matching was done yet");
+	const auto &segments = ctx->matcher->segments();
+	FAIL_IF(idx < 0 || size_t(idx) >= segments.size(), "segment index out of range");
+	*score = segments[idx].public_score();
+	return 1;
+}
+
+ChromaprintBatch *chromaprint_batch_new(int algorithm, int num_threads)
+{
+	FAIL_IF(num_threads < 0, "number of threads can't be negative");
+	std::unique_ptr<FingerprinterConfiguration> config(CreateFingerprinterConfiguration(algorithm));
+	FAIL_IF(!config, "unknown algorithm");
+	return new ChromaprintBatchPrivate(algorithm, num_threads);
+}
+
+void chromaprint_batch_free(ChromaprintBatch *batch)
+{
+	if (batch) {
+		delete batch;
+	}
+}
+
+int chromaprint_batch_get_num_threads(ChromaprintBatch *batch)
+{
+	FAIL_IF(!batch, "batch can't be NULL");
+	return int(batch->pool.num_threads());
+}
+
+int chromaprint_batch_add(ChromaprintBatch *batch, const int16_t *data, int size, int sample_rate, int num_channels)
+{
+	FAIL_IF(!batch, "batch can't be NULL");
+	FAIL_IF(!data && size > 0, "data can't be NULL");
+	FAIL_IF(size < 0, "size can't be negative");
+	ChromaprintBatchPrivate::Job job;
+	job.data = data;
+	job.size = size;
+	job.sample_rate = sample_rate;
+	job.num_channels = num_channels;
+	job.ok = false;
+	batch->jobs.push_back(std::move(job));
+	return 1;
+}
+
+int chromaprint_batch_get_size(ChromaprintBatch *batch, int *size)
+{
+	FAIL_IF(!batch, "batch can't be NULL");
+	*size = int(batch->jobs.size());
+	return 1;
+}
+
+int chromaprint_batch_run(ChromaprintBatch *batch)
+{
+	FAIL_IF(!batch, "batch can't be NULL");
+
+	// Pipelines are created here, on the calling thread, because FFT plan
+	// creation is not thread-safe with some FFT libraries. They are kept
+	// for subsequent runs.
+	while (batch->fingerprinters.size() < batch->pool.num_threads()) {
+		batch->fingerprinters.emplace_back(new Fingerprinter(CreateFingerprinterConfiguration(batch->algorithm)));
+	}
+
+	batch->pool.Run(batch->jobs.size(), [batch](size_t thread_index, size_t task_index) {
+		auto &fingerprinter = *batch->fingerprinters[thread_index];
+		auto &job = batch->jobs[task_index];
+		job.ok = fingerprinter.Start(job.sample_rate, job.num_channels);
+		if (job.ok) {
+			fingerprinter.Consume(job.data, job.size);
+			fingerprinter.Finish();
+			job.fingerprint = fingerprinter.GetFingerprint();
+		} else {
+			job.fingerprint.clear();
+		}
+	});
+
+	for (const auto &job : batch->jobs) {
+		if (!job.ok) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int chromaprint_batch_get_fingerprint(ChromaprintBatch *batch, int index, char **data)
+{
+	FAIL_IF(!batch, "batch can't be NULL");
+	FAIL_IF(index < 0 || size_t(index) >= batch->jobs.size(), "index out of range");
+	const auto &job = batch->jobs[index];
+	FAIL_IF(!job.ok, "fingerprint was not calculated");
+	batch->compressor.Compress(job.fingerprint, batch->algorithm, batch->tmp_fingerprint);
+	*data = (char *) AllocateResult(GetBase64EncodedSize(batch->tmp_fingerprint.size()) + 1);
+	FAIL_IF(!*data, "can't allocate memory for the result");
+	Base64Encode(batch->tmp_fingerprint.begin(), batch->tmp_fingerprint.end(), *data, true);
+	return 1;
+}
+
+int chromaprint_batch_get_raw_fingerprint(ChromaprintBatch *batch, int index, uint32_t **data, int *size)
+{
+	FAIL_IF(!batch, "batch can't be NULL");
+	FAIL_IF(index < 0 || size_t(index) >= batch->jobs.size(), "index out of range");
+	const auto &job = batch->jobs[index];
+	FAIL_IF(!job.ok, "fingerprint was not calculated");
+	*data = (uint32_t *) AllocateResult(sizeof(uint32_t) * job.fingerprint.size());
+	FAIL_IF(!*data, "can't allocate memory for the result");
+	*size = int(job.fingerprint.size());
+	std::copy(job.fingerprint.begin(), job.fingerprint.end(), *data);
+	return 1;
+}
+
+int chromaprint_batch_clear(ChromaprintBatch *batch)
+{
+	FAIL_IF(!batch, "batch can't be NULL");
+	batch->jobs.clear();
+	return 1;
+}
+
+ChromaprintMultiContext *chromaprint_multi_new(const int *algorithms, int num_algorithms)
+{
+	FAIL_IF(!algorithms || num_algorithms <= 0, "at least one algorithm is required");
+	for (int i = 0; i < num_algorithms; i++) {
+		std::unique_ptr<FingerprinterConfiguration> config(CreateFingerprinterConfiguration(algorithms[i]));
+		FAIL_IF(!config, "unknown algorithm");
+	}
+	return new ChromaprintMultiContextPrivate(algorithms, num_algorithms);
+}
+
+void chromaprint_multi_free(ChromaprintMultiContext *ctx)
+{
+	if (ctx) {
+		delete ctx;
+	}
+}
+
+int chromaprint_multi_get_sample_rate(ChromaprintMultiContext *ctx)
+{
+	return ctx ? ctx->fingerprinter.config(0)->sample_rate() : 0;
+}
+
+int chromaprint_multi_start(ChromaprintMultiContext *ctx, int sample_rate, int num_channels)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	return ctx->fingerprinter.Start(sample_rate, num_channels) ? 1 : 0;
+}
+
+int chromaprint_multi_feed(ChromaprintMultiContext *ctx, const int16_t *data, int size)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(size < 0, "size can't be negative");
+	ctx->fingerprinter.Consume(data, size);
+	return 1;
+}
+
+int chromaprint_multi_finish(ChromaprintMultiContext *ctx)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	ctx->fingerprinter.Finish();
+	return 1;
+}
+
+int chromaprint_multi_get_fingerprint(ChromaprintMultiContext *ctx, int index, char **data)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(index < 0 || size_t(index) >= ctx->algorithms.size(), "index out of range");
+	ctx->compressor.Compress(ctx->fingerprinter.GetFingerprint(index), ctx->algorithms[index], ctx->tmp_fingerprint);
+	*data = (char *) AllocateResult(GetBase64EncodedSize(ctx->tmp_fingerprint.size()) + 1);
+	FAIL_IF(!*data, "can't allocate memory for the result");
+	Base64Encode(ctx->tmp_fingerprint.begin(), ctx->tmp_fingerprint.end(), *data, true);
+	return 1;
+}
+
+int chromaprint_multi_get_raw_fingerprint(ChromaprintMultiContext *ctx, int index, uint32_t **data, int *size)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(index < 0 || size_t(index) >= ctx->algorithms.size(), "index out of range");
+	const auto &fingerprint = ctx->fingerprinter.GetFingerprint(index);
+	*data = (uint32_t *) AllocateResult(sizeof(uint32_t) * fingerprint.size());
+	FAIL_IF(!*data, "can't allocate memory for the result");
+	*size = int(fingerprint.size());
+	std::copy(fingerprint.begin(), fingerprint.end(), *data);
+	return 1;
+}
+
 void chromaprint_dealloc(void *ptr)
 {
-	free(ptr);
+	Deallocate(ptr);
 }
 
 }; // extern "C"
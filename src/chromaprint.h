@@ -74,14 +74,37 @@ extern "C" {
 #   endif
 #endif
 
+#include <stddef.h>
 #include <stdint.h>
 
 struct ChromaprintContextPrivate;
 typedef struct ChromaprintContextPrivate ChromaprintContext;
 
+struct ChromaprintContextPoolPrivate;
+typedef struct ChromaprintContextPoolPrivate ChromaprintContextPool;
+
 struct ChromaprintMatcherContextPrivate;
 typedef struct ChromaprintMatcherContextPrivate ChromaprintMatcherContext;
 
+struct ChromaprintBatchPrivate;
+typedef struct ChromaprintBatchPrivate ChromaprintBatch;
+
+struct ChromaprintMultiContextPrivate;
+typedef struct ChromaprintMultiContextPrivate ChromaprintMultiContext;
+
+/**
+ * Callback receiving newly calculated parts of a raw fingerprint.
+ *
+ * @param user_data pointer passed to chromaprint_set_fingerprint_callback()
+ * @param fp pointer to an array of 32-bit integers with the new items, only
+ *        valid during the call
+ * @param size number of items in the array
+ * @param offset position of the first item in the whole fingerprint, counted
+ *        from chromaprint_start(); multiply by chromaprint_get_item_duration_ms()
+ *        to get the timestamp of the item
+ */
+typedef void (*ChromaprintFingerprintCallback)(void *user_data, const uint32_t *fp, int size, int offset);
+
 #define CHROMAPRINT_VERSION_MAJOR 1
 #define CHROMAPRINT_VERSION_MINOR 6
 #define CHROMAPRINT_VERSION_PATCH 1
@@ -95,17 +118,91 @@ enum ChromaprintAlgorithm {
 	CHROMAPRINT_ALGORITHM_DEFAULT = CHROMAPRINT_ALGORITHM_TEST2,
 };
 
+/**
+ * Resamplers for converting the audio to the sample rate of the algorithm,
+ * see the resampler option of chromaprint_set_option().
+ */
+enum ChromaprintResampler {
+	CHROMAPRINT_RESAMPLER_AVRESAMPLE = 0,          // internal copy of avresample
+	CHROMAPRINT_RESAMPLER_POLYPHASE,               // faster, for common sample rates
+	CHROMAPRINT_RESAMPLER_DEFAULT = CHROMAPRINT_RESAMPLER_AVRESAMPLE,
+};
+
+/**
+ * Stages of the fingerprinting pipeline, in the order in which they
+ * process the audio.
+ */
+enum ChromaprintStage {
+	CHROMAPRINT_STAGE_AUDIO_PROCESSOR = 0,         // downmixing and resampling
+	CHROMAPRINT_STAGE_SILENCE_REMOVER,             // only used by some algorithms
+	CHROMAPRINT_STAGE_FFT,
+	CHROMAPRINT_STAGE_CHROMA,
+	CHROMAPRINT_STAGE_CHROMA_FILTER,
+	CHROMAPRINT_STAGE_CHROMA_NORMALIZER,
+	CHROMAPRINT_STAGE_FINGERPRINT_CALCULATOR,
+	CHROMAPRINT_NUM_STAGES,
+};
+
+/**
+ * Statistics of one stage of the pipeline, see chromaprint_get_stats().
+ */
+typedef struct ChromaprintStageStats {
+	// time spent in the stage, not including the following stages (in seconds)
+	double time;
+	// number of times the stage was called
+	uint64_t calls;
+	// number of items processed by the stage, samples for the audio stages,
+	// frames for FFT and chroma vectors for the rest
+	uint64_t items;
+} ChromaprintStageStats;
+
+/**
+ * Functions for allocating memory, see chromaprint_set_allocator().
+ */
+typedef struct ChromaprintAllocator {
+	// allocate size bytes, aligned at least like malloc(), or return NULL
+	void *(*allocate)(void *user_data, size_t size);
+	// free memory returned by allocate or allocate_aligned
+	void (*deallocate)(void *user_data, void *ptr);
+	// optional, allocate size bytes aligned to alignment, a power of two,
+	// or return NULL; without it, aligned memory is taken from larger
+	// blocks returned by allocate
+	void *(*allocate_aligned)(void *user_data, size_t alignment, size_t size);
+	// passed to all the functions
+	void *user_data;
+} ChromaprintAllocator;
+
 /**
  * Return the version number of Chromaprint.
  */
 CHROMAPRINT_API const char *chromaprint_get_version(void);
 
+/**
+ * Set the functions used for allocating memory in the whole library.
+ *
+ * The allocator is used for the contexts and the pools, the buffers of the
+ * fingerprinting pipeline and the FFT, and for the memory returned by the
+ * API, which must still be freed with chromaprint_dealloc(). Small
+ * bookkeeping structures, tables shared by all contexts and memory
+ * allocated inside the external FFT libraries use the standard allocator.
+ *
+ * Memory is always freed by the allocator that allocated it, so the
+ * allocator can be replaced at any time, but the functions must work until
+ * all memory allocated by them is freed. They can be called from multiple
+ * threads at once.
+ *
+ * @param[in] allocator the functions to use, the structure is copied; NULL
+ *            restores malloc() and free()
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_set_allocator(const ChromaprintAllocator *allocator);
+
 /**
  * Allocate and initialize the Chromaprint context.
  *
- * Note that when Chromaprint is compiled with FFTW, this function is
- * not reentrant and you need to call it only from one thread at a time.
- * This is not a problem when using FFmpeg or vDSP.
+ * This function can be called from multiple threads at once, also when
+ * Chromaprint is compiled with FFTW.
  *
  * @param algorithm the fingerprint algorithm version you want to use, or
  *		CHROMAPRINT_ALGORITHM_DEFAULT for the default algorithm
@@ -117,14 +214,96 @@ CHROMAPRINT_API ChromaprintContext *chromaprint_new(int algorithm);
 /**
  * Deallocate the Chromaprint context.
  *
- * Note that when Chromaprint is compiled with FFTW, this function is
- * not reentrant and you need to call it only from one thread at a time.
- * This is not a problem when using FFmpeg or vDSP.
+ * This function can be called from multiple threads at once, also when
+ * Chromaprint is compiled with FFTW.
  *
  * @param[in] ctx Chromaprint context pointer
  */
 CHROMAPRINT_API void chromaprint_free(ChromaprintContext *ctx);
 
+/**
+ * Allocate and initialize a pool of reusable Chromaprint contexts.
+ *
+ * Creating a context allocates the whole fingerprinting pipeline, which is
+ * expensive if a new context is used for every short audio stream. Contexts
+ * released to the pool keep all their memory, and chromaprint_start() on a
+ * context acquired from the pool doesn't allocate any memory, unless the
+ * context has never resampled audio before, or the filters for the sample
+ * rate have to be built, which is only done once per process.
+ *
+ * The pool functions are thread-safe, but each context can still only be
+ * used by one thread at a time.
+ *
+ * @param max_idle maximum number of idle contexts kept for each algorithm,
+ *		contexts released beyond that are freed
+ *
+ * @return pool pointer, or NULL on error
+ */
+CHROMAPRINT_API ChromaprintContextPool *chromaprint_pool_new(int max_idle);
+
+/**
+ * Deallocate the pool and all idle contexts in it.
+ *
+ * Contexts acquired from the pool stay valid, they must be freed with
+ * chromaprint_free().
+ *
+ * @param[in] pool pool pointer
+ */
+CHROMAPRINT_API void chromaprint_pool_free(ChromaprintContextPool *pool);
+
+/**
+ * Create idle contexts in advance, so that they don't have to be created
+ * when they are first needed.
+ *
+ * @param[in] pool pool pointer
+ * @param algorithm the fingerprint algorithm version of the contexts
+ * @param num_contexts number of idle contexts the pool should have, at most max_idle
+ * @param sample_rate if not 0, the contexts are started with audio of this
+ *		sample rate (in Hz), so that they are ready to resample audio
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_pool_reserve(ChromaprintContextPool *pool, int algorithm, int num_contexts, int sample_rate);
+
+/**
+ * Return the number of idle contexts with the given algorithm in the pool.
+ *
+ * @param[in] pool pool pointer
+ * @param algorithm the fingerprint algorithm version
+ * @param[out] num_idle number of idle contexts
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_pool_get_num_idle(ChromaprintContextPool *pool, int algorithm, int *num_idle);
+
+/**
+ * Take an idle context from the pool, or allocate a new one if there is
+ * none. The context behaves exactly like one returned by chromaprint_new().
+ *
+ * The context must be returned with chromaprint_pool_release(), or freed
+ * with chromaprint_free().
+ *
+ * @param[in] pool pool pointer
+ * @param algorithm the fingerprint algorithm version you want to use, or
+ *		CHROMAPRINT_ALGORITHM_DEFAULT for the default algorithm
+ *
+ * @return ctx Chromaprint context pointer, or NULL on error
+ */
+CHROMAPRINT_API ChromaprintContext *chromaprint_pool_acquire(ChromaprintContextPool *pool, int algorithm);
+
+/**
+ * Return a context to the pool.
+ *
+ * The options, callbacks and sliding window of the context are reset to
+ * the defaults and the fingerprint is cleared. If the pool already has
+ * max_idle idle contexts with the same algorithm, the context is freed.
+ * Contexts created by chromaprint_new() can be released to a pool as well.
+ *
+ * @param[in] pool pool pointer
+ * @param[in] ctx Chromaprint context pointer, it must not be used after this call
+ */
+CHROMAPRINT_API void chromaprint_pool_release(ChromaprintContextPool *pool, ChromaprintContext *ctx);
+
 /**
  * Return the fingerprint algorithm this context is configured to use.
  * @param[in] ctx Chromaprint context pointer
@@ -140,6 +319,18 @@ CHROMAPRINT_API int chromaprint_get_algorithm(ChromaprintContext *ctx);
  *
  * Possible options:
  *  - silence_threshold: threshold for detecting silence, 0-32767
+ *  - num_threads: number of threads used to process long audio streams,
+ *    0 means one per CPU core and 1 (the default) disables threading. The
+ *    fingerprint is the same, but the audio is processed in larger chunks.
+ *    While a fingerprint callback or sliding window is set, the chunks are
+ *    only a few seconds long, so that new items are not delayed much, but
+ *    fewer threads are used. Must be set before chromaprint_start().
+ *  - resampler: one of ChromaprintResampler. The polyphase resampler is
+ *    much faster, but its output is not exactly the same as from
+ *    avresample, so it can change a few bits of the fingerprint. It is only
+ *    used for sample rates with a simple ratio to the target sample rate,
+ *    like 44100 or 48000 Hz, others are resampled with avresample. Must be
+ *    set before chromaprint_start().
  *
  * @param[in] ctx Chromaprint context pointer
  * @param[in] name option name
@@ -234,6 +425,66 @@ CHROMAPRINT_API int chromaprint_start(ChromaprintContext *ctx, int sample_rate,
  */
 CHROMAPRINT_API int chromaprint_feed(ChromaprintContext *ctx, const int16_t *data, int size);
 
+/**
+ * Send floating point audio data to the fingerprint calculator.
+ *
+ * The samples are downmixed, resampled and windowed in floating point,
+ * without rounding them to 16 bits, so this is more precise than
+ * converting the data before calling chromaprint_feed(). Only the
+ * avresample resampler works with 16-bit samples, with it the samples are
+ * rounded once after downmixing.
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[in] data raw audio data, should point to an array of interleaved
+ *          samples in the range from -1.0 to 1.0
+ * @param[in] size size of the data buffer (in samples)
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_feed_float(ChromaprintContext *ctx, const float *data, int size);
+
+/**
+ * Send 32-bit integer audio data to the fingerprint calculator.
+ *
+ * Like with chromaprint_feed_float(), the samples are not rounded to 16 bits.
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[in] data raw audio data, should point to an array of interleaved
+ *          32-bit signed integers in native byte-order
+ * @param[in] size size of the data buffer (in samples)
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_feed_int32(ChromaprintContext *ctx, const int32_t *data, int size);
+
+/**
+ * Send planar audio data to the fingerprint calculator.
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[in] data array of pointers to the data of each channel, should
+ *          have as many items as the number of channels passed to
+ *          chromaprint_start(), each pointing to an array of 16-bit signed
+ *          integers in native byte-order
+ * @param[in] size number of samples in each channel
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_feed_planar(ChromaprintContext *ctx, const int16_t *const *data, int size);
+
+/**
+ * Send planar floating point audio data to the fingerprint calculator.
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[in] data array of pointers to the data of each channel, should
+ *          have as many items as the number of channels passed to
+ *          chromaprint_start(), each pointing to an array of samples in the
+ *          range from -1.0 to 1.0
+ * @param[in] size number of samples in each channel
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_feed_float_planar(ChromaprintContext *ctx, const float *const *data, int size);
+
 /**
  * Process any remaining buffered audio data.
  *
@@ -246,6 +497,9 @@ CHROMAPRINT_API int chromaprint_finish(ChromaprintContext *ctx);
 /**
  * Return the calculated fingerprint as a compressed string.
  *
+ * Before chromaprint_finish() is called, the fingerprint covers all audio
+ * fed so far, except the last few frames that are still buffered.
+ *
  * The caller is responsible for freeing the returned pointer using
  * chromaprint_dealloc().
  *
@@ -307,6 +561,110 @@ CHROMAPRINT_API int chromaprint_get_fingerprint_hash(ChromaprintContext *ctx, ui
  */
 CHROMAPRINT_API int chromaprint_clear_fingerprint(ChromaprintContext *ctx);
 
+/**
+ * Deliver the fingerprint incrementally through a callback.
+ *
+ * When a callback is set, every new item of the fingerprint is passed to it
+ * as soon as it is calculated, from within chromaprint_feed() or
+ * chromaprint_finish(), and the items are not accumulated in the context.
+ * This keeps the memory usage constant when fingerprinting long streams.
+ * Functions returning the accumulated fingerprint will only return items
+ * calculated while no callback was set.
+ *
+ * Setting a callback disables the sliding window mode, see
+ * chromaprint_set_sliding_window().
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[in] callback function to call with new items, or NULL to switch back
+ *            to accumulating the fingerprint
+ * @param[in] user_data pointer passed to the callback
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_set_fingerprint_callback(ChromaprintContext *ctx, ChromaprintFingerprintCallback callback, void *user_data);
+
+/**
+ * Keep only the most recent part of the fingerprint, for continuous
+ * fingerprinting of endless streams in constant memory.
+ *
+ * In the sliding window mode, the context only remembers the fingerprint
+ * of the last window_ms milliseconds of audio, and the functions returning
+ * the fingerprint return the contents of that window. Additionally, if a
+ * callback is given, it is called with the whole window every time the
+ * window moves by step_ms milliseconds, starting when the window is full
+ * for the first time. The windows overlap if step_ms is smaller than
+ * window_ms. The offset passed to the callback is the position of the
+ * first item of the window, counted from chromaprint_start().
+ *
+ * Setting the sliding window disables the callback set by
+ * chromaprint_set_fingerprint_callback().
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[in] window_ms length of the window (in milliseconds), or 0 to
+ *            switch back to accumulating the whole fingerprint
+ * @param[in] step_ms how often to pass the window to the callback (in
+ *            milliseconds), or 0 to never call it
+ * @param[in] callback function to call with the window, can be NULL
+ * @param[in] user_data pointer passed to the callback
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_set_sliding_window(ChromaprintContext *ctx, int window_ms, int step_ms, ChromaprintFingerprintCallback callback, void *user_data);
+
+/**
+ * Get the cumulative processing time and item counts of the individual
+ * stages of the fingerprinting pipeline.
+ *
+ * The statistics are collected for all audio processed by the context
+ * since it was created or since the last call to chromaprint_reset_stats().
+ * They are only available if the library was built with the ENABLE_STATS
+ * option, otherwise this function fails.
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[out] stats array that will be filled with the statistics, indexed
+ *             by ChromaprintStage
+ * @param[in] num_stages number of items in the array, at most
+ *            CHROMAPRINT_NUM_STAGES are filled
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_get_stats(ChromaprintContext *ctx, ChromaprintStageStats *stats, int num_stages);
+
+/**
+ * Reset the statistics returned by chromaprint_get_stats().
+ *
+ * @param[in] ctx Chromaprint context pointer
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_reset_stats(ChromaprintContext *ctx);
+
+/**
+ * Get the amount of memory used by the context.
+ *
+ * Only memory allocated with the allocator set by chromaprint_set_allocator()
+ * is included, but no memory returned to the caller. Memory allocated by
+ * worker threads of the context is included as well.
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[out] current number of bytes that are currently allocated, can be NULL
+ * @param[out] peak highest number of bytes that were allocated at the same
+ *             time since the context was created or last released to a pool,
+ *             can be NULL
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_get_memory_usage(ChromaprintContext *ctx, uint64_t *current, uint64_t *peak);
+
+/**
+ * Get the name of a stage of the fingerprinting pipeline.
+ *
+ * @param[in] stage one of the ChromaprintStage values
+ *
+ * @return name of the stage, or NULL if the stage is not valid
+ */
+CHROMAPRINT_API const char *chromaprint_get_stage_name(int stage);
+
 /**
  * Compress and optionally base64-encode a raw fingerprint
  *
@@ -392,6 +750,331 @@ CHROMAPRINT_API int chromaprint_decode_fingerprint_header(const char *encoded_fp
  */
 CHROMAPRINT_API int chromaprint_hash_fingerprint(const uint32_t *fp, int size, uint32_t *hash);
 
+/**
+ * Allocate and initialize a context for comparing two fingerprints.
+ *
+ * The context keeps its internal buffers between comparisons, so when
+ * comparing many pairs of fingerprints, you should reuse one context
+ * instead of creating a new one for every pair.
+ *
+ * @return matcher context pointer, or NULL on error
+ */
+CHROMAPRINT_API ChromaprintMatcherContext *chromaprint_matcher_new(void);
+
+/**
+ * Deallocate the matcher context.
+ *
+ * @param[in] ctx matcher context pointer
+ */
+CHROMAPRINT_API void chromaprint_matcher_free(ChromaprintMatcherContext *ctx);
+
+/**
+ * Set one of the two fingerprints to be compared from a raw fingerprint.
+ *
+ * The data is copied, so the caller can release it after the call.
+ *
+ * @param[in] ctx matcher context pointer
+ * @param[in] idx which fingerprint to set, 0 or 1
+ * @param[in] fp pointer to an array of 32-bit integers representing the raw
+ *        fingerprint
+ * @param[in] size number of items in the raw fingerprint
+ * @param[in] algorithm Chromaprint algorithm version which was used to generate the
+ *               raw fingerprint
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_matcher_set_fingerprint(ChromaprintMatcherContext *ctx, int idx, const uint32_t *fp, int size, int algorithm);
+
+/**
+ * Set one of the two fingerprints to be compared from a compressed fingerprint.
+ *
+ * @param[in] ctx matcher context pointer
+ * @param[in] idx which fingerprint to set, 0 or 1
+ * @param[in] encoded_fp pointer to an encoded fingerprint
+ * @param[in] encoded_size size of the encoded fingerprint in bytes
+ * @param[in] base64 Whether the encoded_fp parameter contains binary data or
+ *            base64-encoded ASCII data
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_matcher_set_encoded_fingerprint(ChromaprintMatcherContext *ctx, int idx, const char *encoded_fp, int encoded_size, int base64);
+
+/**
+ * Compare the two fingerprints and find the matching segments.
+ *
+ * Both fingerprints must have been calculated with the same algorithm.
+ *
+ * @param[in] ctx matcher context pointer
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_matcher_run(ChromaprintMatcherContext *ctx);
+
+/**
+ * Return the number of matching segments found by the last call to
+ * chromaprint_matcher_run().
+ *
+ * @param[in] ctx matcher context pointer
+ * @param[out] num_segments number of segments
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_matcher_get_num_segments(ChromaprintMatcherContext *ctx, int *num_segments);
+
+/**
+ * Return the position of a matching segment in both fingerprints (in items).
+ *
+ * @param[in] ctx matcher context pointer
+ * @param[in] idx index of the segment
+ * @param[out] pos1 start of the segment in the first fingerprint
+ * @param[out] pos2 start of the segment in the second fingerprint
+ * @param[out] duration length of the segment
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_matcher_get_segment_position(ChromaprintMatcherContext *ctx, int idx, int *pos1, int *pos2, int *duration);
+
+/**
+ * Return the position of a matching segment in both fingerprints (in milliseconds).
+ *
+ * @param[in] ctx matcher context pointer
+ * @param[in] idx index of the segment
+ * @param[out] pos1 start of the segment in the first fingerprint
+ * @param[out] pos2 start of the segment in the second fingerprint
+ * @param[out] duration length of the segment
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_matcher_get_segment_position_ms(ChromaprintMatcherContext *ctx, int idx, int *pos1, int *pos2, int *duration);
+
+/**
+ * Return the score of a matching segment.
+ *
+ * The score is the average number of differing bits per item, multiplied
+ * by 100. Lower is better, 0 means the segments are identical.
+ *
+ * @param[in] ctx matcher context pointer
+ * @param[in] idx index of the segment
+ * @param[out] score score of the segment
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_matcher_get_segment_score(ChromaprintMatcherContext *ctx, int idx, int *score);
+
+/**
+ * Allocate and initialize a batch for fingerprinting many independent
+ * audio buffers in parallel.
+ *
+ * The batch owns a pool of worker threads and one fingerprinting pipeline
+ * per thread. The pipelines are reused for all the audio buffers processed
+ * by the batch, so it is much cheaper to keep one batch around and run it
+ * repeatedly than to create a context for every audio buffer.
+ *
+ * @param algorithm the fingerprint algorithm version you want to use, or
+ *		CHROMAPRINT_ALGORITHM_DEFAULT for the default algorithm
+ * @param num_threads number of threads to use, or 0 to use one thread per
+ *		CPU core
+ *
+ * @return batch pointer, or NULL on error
+ */
+CHROMAPRINT_API ChromaprintBatch *chromaprint_batch_new(int algorithm, int num_threads);
+
+/**
+ * Deallocate the batch, stopping its worker threads.
+ *
+ * @param[in] batch batch pointer
+ */
+CHROMAPRINT_API void chromaprint_batch_free(ChromaprintBatch *batch);
+
+/**
+ * Return the number of threads the batch uses for fingerprinting.
+ *
+ * @param[in] batch batch pointer
+ *
+ * @return number of threads, 0 on error
+ */
+CHROMAPRINT_API int chromaprint_batch_get_num_threads(ChromaprintBatch *batch);
+
+/**
+ * Add an audio buffer to the batch.
+ *
+ * The audio data is not copied, the buffer must stay valid until
+ * chromaprint_batch_run() returns. Buffers are numbered from 0 in the order
+ * in which they were added.
+ *
+ * @param[in] batch batch pointer
+ * @param[in] data raw audio data, should point to an array of 16-bit signed
+ *          integers in native byte-order
+ * @param[in] size size of the data buffer (in samples)
+ * @param[in] sample_rate sample rate of the audio (in Hz)
+ * @param[in] num_channels numbers of channels in the audio
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_batch_add(ChromaprintBatch *batch, const int16_t *data, int size, int sample_rate, int num_channels);
+
+/**
+ * Return the number of audio buffers in the batch.
+ *
+ * @param[in] batch batch pointer
+ * @param[out] size number of audio buffers
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_batch_get_size(ChromaprintBatch *batch, int *size);
+
+/**
+ * Calculate fingerprints of all audio buffers in the batch.
+ *
+ * This function blocks until all fingerprints are calculated.
+ *
+ * @param[in] batch batch pointer
+ *
+ * @return 0 if any of the fingerprints could not be calculated, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_batch_run(ChromaprintBatch *batch);
+
+/**
+ * Return the fingerprint of one audio buffer in the batch as a compressed string.
+ *
+ * The caller is responsible for freeing the returned pointer using
+ * chromaprint_dealloc().
+ *
+ * @param[in] batch batch pointer
+ * @param[in] index index of the audio buffer
+ * @param[out] fingerprint pointer to a pointer, where a pointer to the allocated array
+ *                 will be stored
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_batch_get_fingerprint(ChromaprintBatch *batch, int index, char **fingerprint);
+
+/**
+ * Return the fingerprint of one audio buffer in the batch as an array of 32-bit integers.
+ *
+ * The caller is responsible for freeing the returned pointer using
+ * chromaprint_dealloc().
+ *
+ * @param[in] batch batch pointer
+ * @param[in] index index of the audio buffer
+ * @param[out] fingerprint pointer to a pointer, where a pointer to the allocated array
+ *                 will be stored
+ * @param[out] size number of items in the returned raw fingerprint
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_batch_get_raw_fingerprint(ChromaprintBatch *batch, int index, uint32_t **fingerprint, int *size);
+
+/**
+ * Remove all audio buffers and results from the batch, so that it can be
+ * reused for another set of audio buffers.
+ *
+ * @param[in] batch batch pointer
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_batch_clear(ChromaprintBatch *batch);
+
+/**
+ * Allocate and initialize a context for calculating fingerprints of the
+ * same audio with several algorithms at once.
+ *
+ * The audio is decoded and resampled only once, and the algorithms share
+ * all processing stages up to the first one whose configuration differs,
+ * so this is faster than feeding the audio to a separate context for each
+ * algorithm. The fingerprints are exactly the same.
+ *
+ * The audio must be mono at the sample rate returned by
+ * chromaprint_multi_get_sample_rate() to avoid resampling, otherwise it
+ * is converted like in chromaprint_feed().
+ *
+ * @param algorithms array of fingerprint algorithm versions, fingerprints
+ *		are identified by the index in this array
+ * @param num_algorithms number of items in the array
+ *
+ * @return context pointer, or NULL on error
+ */
+CHROMAPRINT_API ChromaprintMultiContext *chromaprint_multi_new(const int *algorithms, int num_algorithms);
+
+/**
+ * Deallocate the multi-algorithm context.
+ *
+ * @param[in] ctx context pointer
+ */
+CHROMAPRINT_API void chromaprint_multi_free(ChromaprintMultiContext *ctx);
+
+/**
+ * Return the sample rate the audio is resampled to, the same for all algorithms.
+ *
+ * @param[in] ctx context pointer
+ *
+ * @return sample rate, 0 on error
+ */
+CHROMAPRINT_API int chromaprint_multi_get_sample_rate(ChromaprintMultiContext *ctx);
+
+/**
+ * Restart the computation of the fingerprints with a new audio stream.
+ *
+ * @param[in] ctx context pointer
+ * @param[in] sample_rate sample rate of the audio stream (in Hz)
+ * @param[in] num_channels numbers of channels in the audio stream
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_multi_start(ChromaprintMultiContext *ctx, int sample_rate, int num_channels);
+
+/**
+ * Send audio data to the fingerprint calculator.
+ *
+ * @param[in] ctx context pointer
+ * @param[in] data raw audio data, should point to an array of 16-bit signed
+ *          integers in native byte-order
+ * @param[in] size size of the data buffer (in samples)
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_multi_feed(ChromaprintMultiContext *ctx, const int16_t *data, int size);
+
+/**
+ * Process any remaining buffered audio data.
+ *
+ * @param[in] ctx context pointer
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_multi_finish(ChromaprintMultiContext *ctx);
+
+/**
+ * Return the fingerprint of one of the algorithms as a compressed string.
+ *
+ * The caller is responsible for freeing the returned pointer using
+ * chromaprint_dealloc().
+ *
+ * @param[in] ctx context pointer
+ * @param[in] index index of the algorithm in the array passed to chromaprint_multi_new()
+ * @param[out] fingerprint pointer to a pointer, where a pointer to the allocated array
+ *                 will be stored
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_multi_get_fingerprint(ChromaprintMultiContext *ctx, int index, char **fingerprint);
+
+/**
+ * Return the fingerprint of one of the algorithms as an array of 32-bit integers.
+ *
+ * The caller is responsible for freeing the returned pointer using
+ * chromaprint_dealloc().
+ *
+ * @param[in] ctx context pointer
+ * @param[in] index index of the algorithm in the array passed to chromaprint_multi_new()
+ * @param[out] fingerprint pointer to a pointer, where a pointer to the allocated array
+ *                 will be stored
+ * @param[out] size number of items in the returned raw fingerprint
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_multi_get_raw_fingerprint(ChromaprintMultiContext *ctx, int index, uint32_t **fingerprint, int *size);
+
 /**
  * Free memory allocated by any function from the Chromaprint API.
  *
@@ -0,0 +1,218 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "classifier_program.h"
+#include "debug.h"
+
+#ifdef CHROMAPRINT_ARCH_X86
+#include <immintrin.h>
+#endif
+
+namespace chromaprint {
+
+ClassifierProgram::ClassifierProgram(const Classifier *classifiers, size_t num_classifiers)
+{
+	m_classifiers.reserve(num_classifiers);
+	for (size_t i = 0; i < num_classifiers; i++) {
+		const auto &filter = classifiers[i].filter();
+		const auto &quantizer = classifiers[i].quantizer();
+		const int x = 0, y = filter.y(), w = filter.width(), h = filter.height();
+		m_max_filter_width = std::max(m_max_filter_width, size_t(w));
+
+		// Same areas as in Filter0 - Filter5, in the same order. Empty areas
+		// are skipped, adding 0.0 does not change the sum.
+		CompiledClassifier c;
+		c.begin = m_areas.size();
+		c.num_a = 0;
+		c.num_b = 0;
+		switch (filter.type()) {
+			case 0:
+				AddArea(x, y, x + w, y + h, c.num_a);
+				break;
+			case 1:
+				AddArea(x, y + h / 2, x + w, y + h, c.num_a);
+				AddArea(x, y, x + w, y + h / 2, c.num_b);
+				break;
+			case 2:
+				AddArea(x + w / 2, y, x + w, y + h, c.num_a);
+				AddArea(x, y, x + w / 2, y + h, c.num_b);
+				break;
+			case 3:
+				AddArea(x, y + h / 2, x + w / 2, y + h, c.num_a);
+				AddArea(x + w / 2, y, x + w, y + h / 2, c.num_a);
+				AddArea(x, y, x + w / 2, y + h / 2, c.num_b);
+				AddArea(x + w / 2, y + h / 2, x + w, y + h, c.num_b);
+				break;
+			case 4:
+				AddArea(x, y + h / 3, x + w, y + 2 * (h / 3), c.num_a);
+				AddArea(x, y, x + w, y + h / 3, c.num_b);
+				AddArea(x, y + 2 * (h / 3), x + w, y + h, c.num_b);
+				break;
+			case 5:
+				AddArea(x + w / 3, y, x + 2 * (w / 3), y + h, c.num_a);
+				AddArea(x, y, x + w / 3, y + h, c.num_b);
+				AddArea(x + 2 * (w / 3), y, x + w, y + h, c.num_b);
+				break;
+		}
+
+		c.thresholds[0] = LogThreshold(quantizer.t0());
+		c.thresholds[1] = LogThreshold(quantizer.t1());
+		c.thresholds[2] = LogThreshold(quantizer.t2());
+		m_classifiers.push_back(c);
+	}
+
+	m_rows.resize(m_max_filter_width + 1);
+	m_index.resize((m_max_filter_width + 1) * 4);
+}
+
+void ClassifierProgram::AddArea(int x1, int y1, int x2, int y2, int &count)
+{
+	if (x1 == x2 || y1 == y2) {
+		return;
+	}
+	m_areas.push_back({ x1, x2, y1, y2 });
+	count++;
+}
+
+// log() is monotonic, so log(x) < t is the same as x < LogThreshold(t). The
+// threshold is searched for around exp(t), which is at most a few steps away.
+double ClassifierProgram::LogThreshold(double threshold)
+{
+	double x = std::exp(threshold);
+	if (std::log(x) >= threshold) {
+		while (x > 0.0) {
+			const double prev = std::nextafter(x, 0.0);
+			if (std::log(prev) < threshold) {
+				break;
+			}
+			x = prev;
+		}
+	} else {
+		do {
+			x = std::nextafter(x, std::numeric_limits<double>::infinity());
+		} while (std::log(x) < threshold);
+	}
+	return x;
+}
+
+void ClassifierProgram::Run_Generic(const RollingIntegralImage &image, size_t begin, size_t end, uint32_t *output) const
+{
+	auto &rows = m_rows;
+	for (size_t offset = begin; offset < end; offset++) {
+		for (size_t i = 0; i < rows.size(); i++) {
+			rows[i] = image.RowSums(offset + i);
+		}
+		uint32_t bits = 0;
+		for (const auto &c : m_classifiers) {
+			double sums[2] = { 0.0, 0.0 };
+			const Area *area = m_areas.data() + c.begin;
+			for (int i = 0; i < c.num_a + c.num_b; i++, area++) {
+				const double *row1 = rows[area->x1];
+				const double *row2 = rows[area->x2];
+				sums[i >= c.num_a] += row2[area->y2] - row1[area->y2] - row2[area->y1] + row1[area->y1];
+			}
+			const double ratio = (1.0 + sums[0]) / (1.0 + sums[1]);
+			// the logarithm of a negative ratio is NaN, which quantizes to 3
+			int value = 3;
+			if (ratio >= 0.0) {
+				value -= (ratio < c.thresholds[0]) + (ratio < c.thresholds[1]) + (ratio < c.thresholds[2]);
+			}
+			bits = (bits << 2) | GrayCode(value);
+		}
+		*output++ = bits;
+	}
+}
+
+#ifdef CHROMAPRINT_ARCH_X86
+
+// Same as _mm256_i32gather_pd(), the explicit source and mask only keep
+// GCC from warning that the source of the gather may be uninitialized.
+CHROMAPRINT_TARGET("avx2")
+static inline __m256d Gather(const double *data, __m128i index)
+{
+	const __m256d mask = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+	return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), data, index, mask, 8);
+}
+
+CHROMAPRINT_TARGET("avx2")
+void ClassifierProgram::Run_AVX2(const RollingIntegralImage &image, size_t begin, size_t end, uint32_t *output) const
+{
+	// Four offsets are processed at once, the row sums needed for them are
+	// gathered from the image using a table of row positions, with the
+	// positions for row i of all four offsets at index[i * 4].
+	const double *data = image.data();
+	const __m256d one = _mm256_set1_pd(1.0);
+	const __m256d zero = _mm256_setzero_pd();
+	const __m256i three = _mm256_set1_epi64x(3);
+	const __m256i pack = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+	auto &index = m_index;
+
+	size_t offset = begin;
+	for (; offset + 4 <= end; offset += 4) {
+		for (size_t i = 0; i <= m_max_filter_width; i++) {
+			for (size_t j = 0; j < 4; j++) {
+				index[i * 4 + j] = int32_t(image.RowSumsIndex(offset + j + i));
+			}
+		}
+
+		__m256i bits = _mm256_setzero_si256();
+		for (const auto &c : m_classifiers) {
+			__m256d sums[2] = { zero, zero };
+			const Area *area = m_areas.data() + c.begin;
+			for (int i = 0; i < c.num_a + c.num_b; i++, area++) {
+				const __m128i row1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&index[area->x1 * 4]));
+				const __m128i row2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&index[area->x2 * 4]));
+				const __m128i y1 = _mm_set1_epi32(area->y1);
+				const __m128i y2 = _mm_set1_epi32(area->y2);
+				__m256d value = Gather(data, _mm_add_epi32(row2, y2));
+				value = _mm256_sub_pd(value, Gather(data, _mm_add_epi32(row1, y2)));
+				value = _mm256_sub_pd(value, Gather(data, _mm_add_epi32(row2, y1)));
+				value = _mm256_add_pd(value, Gather(data, _mm_add_epi32(row1, y1)));
+				sums[i >= c.num_a] = _mm256_add_pd(sums[i >= c.num_a], value);
+			}
+			const __m256d ratio = _mm256_div_pd(_mm256_add_pd(one, sums[0]), _mm256_add_pd(one, sums[1]));
+			// comparison masks are -1, so adding them counts the thresholds above the ratio
+			const __m256d valid = _mm256_cmp_pd(ratio, zero, _CMP_GE_OQ);
+			__m256i value = three;
+			for (int i = 0; i < 3; i++) {
+				const __m256d below = _mm256_and_pd(valid, _mm256_cmp_pd(ratio, _mm256_set1_pd(c.thresholds[i]), _CMP_LT_OQ));
+				value = _mm256_add_epi64(value, _mm256_castpd_si256(below));
+			}
+			const __m256i gray = _mm256_xor_si256(value, _mm256_srli_epi64(value, 1));
+			bits = _mm256_or_si256(_mm256_slli_epi64(bits, 2), gray);
+		}
+		const __m256i packed = _mm256_permutevar8x32_epi32(bits, pack);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output + (offset - begin)), _mm256_castsi256_si128(packed));
+	}
+
+	Run_Generic(image, offset, end, output + (offset - begin));
+}
+
+#endif
+
+namespace {
+
+typedef void (ClassifierProgram::*RunFunc)(const RollingIntegralImage &image, size_t begin, size_t end, uint32_t *output) const;
+
+RunFunc SelectRun()
+{
+#ifdef CHROMAPRINT_ARCH_X86
+	if (GetCpuFeatures().avx2) {
+		return &ClassifierProgram::Run_AVX2;
+	}
+#endif
+	return &ClassifierProgram::Run_Generic;
+}
+
+}; // namespace
+
+void ClassifierProgram::Run(const RollingIntegralImage &image, size_t begin, size_t end, uint32_t *output) const
+{
+	static const RunFunc func = SelectRun();
+	(this->*func)(image, begin, end, output);
+}
+
+}; // namespace chromaprint
@@ -0,0 +1,89 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_CLASSIFIER_PROGRAM_H_
+#define CHROMAPRINT_CLASSIFIER_PROGRAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "classifier.h"
+#include "utils.h"
+#include "utils/cpu_features.h"
+#include "utils/rolling_integral_image.h"
+
+namespace chromaprint {
+
+/**
+ * Classifiers of a configuration compiled into a flat list of areas and
+ * thresholds, which calculates fingerprint items for many offsets at once.
+ *
+ * Every filter is expanded into the areas it adds and subtracts, relative
+ * to the offset, so there is no switch on the filter type and no modulo
+ * per area lookup. Instead of quantizing log((1 + a) / (1 + b)), the ratio
+ * itself is compared with the smallest values whose logarithm reaches the
+ * quantizer thresholds, which are found when the program is built. The
+ * areas and the ratio are calculated with exactly the same operations as
+ * Classifier::Classify(), so the results are identical.
+ *
+ * The best implementation available on the CPU is selected at runtime.
+ * Run() uses scratch buffers of the program, so a program can only be run
+ * by one thread at a time.
+ */
+class ClassifierProgram
+{
+public:
+	ClassifierProgram(const Classifier *classifiers, size_t num_classifiers);
+
+	size_t num_classifiers() const { return m_classifiers.size(); }
+	size_t max_filter_width() const { return m_max_filter_width; }
+
+	/**
+	 * Calculate fingerprint items for offsets [begin, end) of the image,
+	 * all rows from begin to end + max_filter_width() - 1 must be available.
+	 */
+	void Run(const RollingIntegralImage &image, size_t begin, size_t end, uint32_t *output) const;
+
+	// Individual implementations, only exposed for testing and benchmarking.
+	// The caller is responsible for checking that the CPU supports them.
+	void Run_Generic(const RollingIntegralImage &image, size_t begin, size_t end, uint32_t *output) const;
+#ifdef CHROMAPRINT_ARCH_X86
+	void Run_AVX2(const RollingIntegralImage &image, size_t begin, size_t end, uint32_t *output) const;
+#endif
+
+	//! Smallest value whose natural logarithm is not less than threshold.
+	static double LogThreshold(double threshold);
+
+private:
+	CHROMAPRINT_DISABLE_COPY(ClassifierProgram);
+
+	// Rectangle of the image, rows are relative to the offset.
+	struct Area {
+		int x1, x2;
+		int y1, y2;
+	};
+
+	struct CompiledClassifier {
+		// m_areas[begin, begin + num_a) are summed into a,
+		// the following num_b areas into b
+		size_t begin;
+		int num_a;
+		int num_b;
+		double thresholds[3];
+	};
+
+	void AddArea(int x1, int y1, int x2, int y2, int &count);
+
+	std::vector<Area> m_areas;
+	std::vector<CompiledClassifier> m_classifiers;
+	size_t m_max_filter_width = 0;
+
+	// Row sums of the current offset, used by Run_Generic().
+	mutable std::vector<const double *> m_rows;
+	// Positions of the row sums of four offsets, used by Run_AVX2().
+	mutable std::vector<int32_t> m_index;
+};
+
+}; // namespace chromaprint
+
+#endif
@@ -0,0 +1,107 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+#include "classifier_program.h"
+#include "fingerprinter_configuration.h"
+
+namespace chromaprint {
+
+namespace {
+
+typedef void (ClassifierProgram::*RunFunc)(const RollingIntegralImage &image, size_t begin, size_t end, uint32_t *output) const;
+
+uint32_t Classify(const Classifier *classifiers, size_t num_classifiers, const RollingIntegralImage &image, size_t offset)
+{
+	uint32_t bits = 0;
+	for (size_t i = 0; i < num_classifiers; i++) {
+		bits = (bits << 2) | GrayCode(classifiers[i].Classify(image, offset));
+	}
+	return bits;
+}
+
+void CheckClassifiers(RunFunc func, const Classifier *classifiers, size_t num_classifiers)
+{
+	ClassifierProgram program(classifiers, num_classifiers);
+	const size_t width = program.max_filter_width();
+
+	// the image wraps around several times, offset 0 reads the zero row
+	RollingIntegralImage image(64);
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<double> dist(0.0, 1.0);
+	for (size_t num_rows = 1; num_rows <= 300; num_rows++) {
+		std::vector<double> row(12);
+		for (auto &x : row) {
+			// some exact zeros to get ratios of exactly 1
+			x = num_rows % 7 == 0 ? 0.0 : dist(rng);
+		}
+		image.AddRow(row);
+		if (num_rows < width) {
+			continue;
+		}
+		const size_t end = num_rows - width + 1;
+		const size_t begin = end > 64 - width ? end - (64 - width) : 0;
+		std::vector<uint32_t> output(end - begin);
+		(program.*func)(image, begin, end, output.data());
+		for (size_t offset = begin; offset < end; offset++) {
+			ASSERT_EQ(Classify(classifiers, num_classifiers, image, offset), output[offset - begin])
+				<< "num_rows=" << num_rows << " offset=" << offset;
+		}
+	}
+}
+
+void CheckImplementation(RunFunc func)
+{
+	for (int algorithm = CHROMAPRINT_ALGORITHM_TEST1; algorithm <= CHROMAPRINT_ALGORITHM_TEST5; algorithm++) {
+		SCOPED_TRACE("algorithm " + std::to_string(algorithm + 1));
+		std::unique_ptr<FingerprinterConfiguration> config(CreateFingerprinterConfiguration(algorithm));
+		CheckClassifiers(func, config->classifiers(), config->num_classifiers());
+	}
+
+	// filters with empty areas and an unknown filter type
+	const Classifier classifiers[] = {
+		Classifier(Filter(1, 3, 1, 5), Quantizer(-0.1, 0.0, 0.1)),
+		Classifier(Filter(3, 2, 1, 1), Quantizer(-0.1, 0.0, 0.1)),
+		Classifier(Filter(4, 0, 2, 3), Quantizer(-0.5, 0.0, 0.5)),
+		Classifier(Filter(5, 7, 5, 2), Quantizer(-0.5, 0.0, 0.5)),
+		Classifier(Filter(6, 0, 2, 2), Quantizer(-0.5, 0.0, 0.5)),
+		Classifier(Filter(0, 11, 1, 1), Quantizer(0.0, 0.0, 0.0)),
+	};
+	SCOPED_TRACE("special filters");
+	CheckClassifiers(func, classifiers, sizeof(classifiers) / sizeof(classifiers[0]));
+}
+
+}; // namespace
+
+TEST(ClassifierProgramTest, LogThreshold) {
+	for (double t : { -1.03809, -0.0771619, -0.00568076, 0.0, 1e-300, 0.0152227, 2.69414, -800.0, 800.0 }) {
+		const double x = ClassifierProgram::LogThreshold(t);
+		ASSERT_GE(std::log(x), t) << "t=" << t;
+		ASSERT_LT(std::log(std::nextafter(x, 0.0)), t) << "t=" << t;
+	}
+}
+
+TEST(ClassifierProgramTest, Generic) {
+	CheckImplementation(&ClassifierProgram::Run_Generic);
+}
+
+TEST(ClassifierProgramTest, Dispatch) {
+	CheckImplementation(&ClassifierProgram::Run);
+}
+
+#ifdef CHROMAPRINT_ARCH_X86
+
+TEST(ClassifierProgramTest, AVX2) {
+	if (!GetCpuFeatures().avx2) {
+		GTEST_SKIP() << "AVX2 not supported";
+	}
+	CheckImplementation(&ClassifierProgram::Run_AVX2);
+}
+
+#endif
+
+}; // namespace chromaprint
@@ -1,11 +1,23 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <cstdarg>
 #include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <algorithm>
+#include <functional>
 #include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <chromaprint.h>
 #include "audio/ffmpeg_audio_reader.h"
 #include "utils/scope_exit.h"
+#include "utils/spsc_queue.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -30,6 +42,10 @@ static bool g_raw = false;
 static bool g_signed = false;
 static bool g_abs_ts = false;
 static bool g_ignore_errors = false;
+static int g_num_threads = 1;
+static int g_num_jobs = 1;
+static bool g_unordered = false;
+static bool g_decode_thread = std::thread::hardware_concurrency() > 1;
 static ChromaprintAlgorithm g_algorithm = CHROMAPRINT_ALGORITHM_DEFAULT;
 
 
@@ -45,6 +61,11 @@ const char *g_help =
 	"  -length SECS   Restrict the duration of the processed input audio (default 120)\n"
 	"  -chunk SECS    Split the input audio into chunks of this duration\n"
 	"  -algorithm NUM Set the algorithm method (default 2)\n"
+	"  -threads NUM   Use this many threads to fingerprint long files, 0 means one per CPU core (default 1)\n"
+	"  -jobs NUM      Process this many files at the same time, 0 means one per CPU core (default 1)\n"
+	"  -j NUM         Same as -jobs\n"
+	"  -unordered     With -jobs, print the results as soon as they are ready, with the file names\n"
+	"  -sync-decode   Decode the audio on the same thread that calculates the fingerprint (always with -jobs)\n"
 	"  -overlap       Overlap the chunks slightly to make sure audio on the edges is fingerprinted\n"
 	"  -ts            Output UNIX timestamps for chunked results, useful when fingerprinting real-time audio stream\n"
 	"  -raw           Output fingerprints in the uncompressed format\n"
@@ -109,6 +130,28 @@ static void ParseOptions(int &argc, char **argv) {
                 exit(2);
             }
             i++;
+		} else if (!strcmp(argv[i], "-threads") && i + 1 < argc) {
+			auto value = atoi(argv[i + 1]);
+			if (value >= 0) {
+				g_num_threads = value;
+			} else {
+				fprintf(stderr, "ERROR: The argument for %s must be a positive number\n", argv[i]);
+				exit(2);
+			}
+			i++;
+		} else if ((!strcmp(argv[i], "-jobs") || !strcmp(argv[i], "-j")) && i + 1 < argc) {
+			auto value = atoi(argv[i + 1]);
+			if (value >= 0) {
+				g_num_jobs = value;
+			} else {
+				fprintf(stderr, "ERROR: The argument for %s must be a positive number\n", argv[i]);
+				exit(2);
+			}
+			i++;
+		} else if (!strcmp(argv[i], "-unordered")) {
+			g_unordered = true;
+		} else if (!strcmp(argv[i], "-sync-decode")) {
+			g_decode_thread = false;
 		} else if (!strcmp(argv[i], "-text")) {
 			g_format = TEXT;
 		} else if (!strcmp(argv[i], "-json")) {
@@ -153,22 +196,104 @@ static void ParseOptions(int &argc, char **argv) {
 	argc = j;
 }
 
-void PrintResult(ChromaprintContext *ctx, FFmpegAudioReader &reader, bool first, double timestamp, double duration) {
+// Output of one file. Unless it is buffered, everything is printed right
+// away, which is needed for live streams.
+class FileOutput {
+public:
+	FileOutput(const char *file_name, bool buffered) : m_file_name(file_name), m_buffered(buffered) {}
+
+	const char *file_name() const { return m_file_name; }
+
+	void Print(const std::string &text) {
+		if (m_buffered) {
+			m_output += text;
+		} else {
+			fputs(text.c_str(), stdout);
+			fflush(stdout);
+		}
+	}
+
+	void Error(const std::string &message) {
+		std::string text = "ERROR: ";
+		if (m_buffered) {
+			// results of multiple files can be mixed, say which file failed
+			text += m_file_name;
+			text += ": ";
+		}
+		text += message;
+		text += "\n";
+		if (m_buffered) {
+			m_errors += text;
+		} else {
+			fputs(text.c_str(), stderr);
+		}
+	}
+
+	//! Print the buffered output.
+	void Flush() {
+		fputs(m_output.c_str(), stdout);
+		fflush(stdout);
+		fputs(m_errors.c_str(), stderr);
+		m_output.clear();
+		m_errors.clear();
+	}
+
+private:
+	const char *m_file_name;
+	bool m_buffered;
+	std::string m_output;
+	std::string m_errors;
+};
+
+static std::string StringPrintf(const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	va_list args2;
+	va_copy(args2, args);
+	const int size = vsnprintf(nullptr, 0, format, args);
+	va_end(args);
+	std::string result;
+	if (size > 0) {
+		result.resize(size + 1);
+		vsnprintf(&result[0], result.size(), format, args2);
+		result.resize(size);
+	}
+	va_end(args2);
+	return result;
+}
+
+static std::string JsonEscape(const char *str) {
+	std::string result;
+	for (; *str; str++) {
+		const unsigned char c = *str;
+		if (c == '"' || c == '\\') {
+			result += '\\';
+			result += c;
+		} else if (c < 0x20) {
+			result += StringPrintf("\\u%04x", c);
+		} else {
+			result += c;
+		}
+	}
+	return result;
+}
+
+bool PrintResult(ChromaprintContext *ctx, FFmpegAudioReader &reader, FileOutput &output, bool first, double timestamp, double duration) {
 	std::string tmp_fp;
 	const char *fp;
 	bool dealloc_fp = false;
 
 	int size;
 	if (!chromaprint_get_raw_fingerprint_size(ctx, &size)) {
-		fprintf(stderr, "ERROR: Could not get the fingerprinting size\n");
-		exit(2);
+		output.Error("Could not get the fingerprinting size");
+		return false;
 	}
 	if (size <= 0) {
 		if (first) {
-			fprintf(stderr, "ERROR: Empty fingerprint\n");
-			exit(2);
+			output.Error("Empty fingerprint");
+			return false;
 		}
-		return;
+		return true;
 	}
 
 	if (g_raw) {
@@ -176,8 +301,8 @@ void PrintResult(ChromaprintContext *ctx, FFmpegAudioReader &reader, bool first,
 		uint32_t *raw_fp_data = nullptr;
 		int raw_fp_size = 0;
 		if (!chromaprint_get_raw_fingerprint(ctx, &raw_fp_data, &raw_fp_size)) {
-			fprintf(stderr, "ERROR: Could not get the fingerprinting\n");
-			exit(2);
+			output.Error("Could not get the fingerprinting");
+			return false;
 		}
 		SCOPE_EXIT(chromaprint_dealloc(raw_fp_data));
 		for (int i = 0; i < raw_fp_size; i++) {
@@ -195,8 +320,8 @@ void PrintResult(ChromaprintContext *ctx, FFmpegAudioReader &reader, bool first,
 	} else {
 		char *tmp_fp2;
 		if (!chromaprint_get_fingerprint(ctx, &tmp_fp2)) {
-			fprintf(stderr, "ERROR: Could not get the fingerprinting\n");
-			exit(2);
+			output.Error("Could not get the fingerprinting");
+			return false;
 		}
 		fp = tmp_fp2;
 		dealloc_fp = true;
@@ -212,63 +337,234 @@ void PrintResult(ChromaprintContext *ctx, FFmpegAudioReader &reader, bool first,
 		}
 	}
 
+	std::string file_field;
 	switch (g_format) {
 		case TEXT:
 			if (!first) {
-				printf("\n");
+				output.Print("\n");
+			}
+			if (g_unordered) {
+				output.Print(StringPrintf("FILE=%s\n", output.file_name()));
 			}
 			if (g_abs_ts) {
-				printf("TIMESTAMP=%.2f\n", timestamp);
+				output.Print(StringPrintf("TIMESTAMP=%.2f\n", timestamp));
 			}
-			printf("DURATION=%d\nFINGERPRINT=%s\n", int(duration), fp);
+			output.Print(StringPrintf("DURATION=%d\nFINGERPRINT=%s\n", int(duration), fp));
 			break;
 		case JSON:
+			if (g_unordered) {
+				file_field = "\"file\": \"" + JsonEscape(output.file_name()) + "\", ";
+			}
 			if (g_max_chunk_duration != 0) {
 				if (g_raw) {
-					printf("{\"timestamp\": %.2f, \"duration\": %.2f, \"fingerprint\": [%s]}\n", timestamp, duration, fp);
+					output.Print(StringPrintf("{%s\"timestamp\": %.2f, \"duration\": %.2f, \"fingerprint\": [%s]}\n", file_field.c_str(), timestamp, duration, fp));
 				} else {
-					printf("{\"timestamp\": %.2f, \"duration\": %.2f, \"fingerprint\": \"%s\"}\n", timestamp, duration, fp);
+					output.Print(StringPrintf("{%s\"timestamp\": %.2f, \"duration\": %.2f, \"fingerprint\": \"%s\"}\n", file_field.c_str(), timestamp, duration, fp));
 				}
 			} else {
 				if (g_raw) {
-					printf("{\"duration\": %.2f, \"fingerprint\": [%s]}\n", duration, fp);
+					output.Print(StringPrintf("{%s\"duration\": %.2f, \"fingerprint\": [%s]}\n", file_field.c_str(), duration, fp));
 				} else {
-					printf("{\"duration\": %.2f, \"fingerprint\": \"%s\"}\n", duration, fp);
+					output.Print(StringPrintf("{%s\"duration\": %.2f, \"fingerprint\": \"%s\"}\n", file_field.c_str(), duration, fp));
 				}
 			}
 			break;
 		case PLAIN:
-			printf("%s\n", fp);
+			if (g_unordered) {
+				output.Print(StringPrintf("%s\t%s\n", output.file_name(), fp));
+			} else {
+				output.Print(StringPrintf("%s\n", fp));
+			}
 			break;
 	}
 
-	fflush(stdout);
+	return true;
 }
 
+// Reads audio from the reader, optionally decoding it on a separate thread,
+// so that decoding the next part of the file overlaps with fingerprinting.
+// The decoded audio is passed through a bounded queue of sample buffers,
+// which are reused once the fingerprinting thread is done with them. The
+// queue itself doesn't block, a thread only waits on the condition variable
+// if the queue is empty or full.
+class AudioSource {
+public:
+	AudioSource(FFmpegAudioReader &reader, bool threaded) : m_reader(reader), m_queue(DECODE_QUEUE_SIZE), m_threaded(threaded) {
+		if (threaded) {
+			m_thread = std::thread(&AudioSource::Decode, this);
+		}
+	}
+
+	~AudioSource() {
+		Stop();
+	}
+
+	//! Stop decoding, the reader can be used by this thread again.
+	void Stop() {
+		if (m_thread.joinable()) {
+			m_stop = true;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_cond.notify_all();
+			}
+			m_thread.join();
+		}
+	}
+
+	bool IsFinished() const {
+		if (!m_threaded) {
+			return m_reader.IsFinished();
+		}
+		return m_finished;
+	}
+
+	bool Read(const int16_t **data, size_t *size) {
+		if (!m_threaded) {
+			return m_reader.Read(data, size);
+		}
+		if (!m_queue.TryPop(m_block)) {
+			Wait([this]() { return m_queue.TryPop(m_block); });
+		}
+		Notify();
+		if (m_block.last) {
+			m_finished = true;
+			if (!m_block.error.empty()) {
+				return false;
+			}
+		}
+		*data = m_block.samples.data();
+		*size = m_block.samples.size() / m_reader.GetChannels();
+		return true;
+	}
+
+	std::string GetError() const {
+		if (!m_threaded) {
+			return m_reader.GetError();
+		}
+		return m_block.error;
+	}
+
+private:
+	CHROMAPRINT_DISABLE_COPY(AudioSource);
+
+	// Number of decoded blocks the decoder can be ahead of the fingerprinting.
+	static const size_t DECODE_QUEUE_SIZE = 16;
+
+	// Decoded frames are collected into blocks of at least this many samples.
+	static const size_t DECODE_BLOCK_SIZE = 16384;
+
+	struct Block {
+		std::vector<int16_t> samples;
+		std::string error;
+		bool last = false;
+
+		void swap(Block &other) {
+			samples.swap(other.samples);
+			error.swap(other.error);
+			std::swap(last, other.last);
+		}
+		friend void swap(Block &a, Block &b) { a.swap(b); }
+	};
+
+	// Wake up the other thread, if it's waiting for the queue.
+	void Notify() {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_num_waiting.load(std::memory_order_relaxed) > 0) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_cond.notify_all();
+		}
+	}
+
+	// Block until the condition is true. The waiting thread is registered
+	// before the condition is checked again, so it can't miss a Notify().
+	template <typename Condition>
+	void Wait(Condition condition) {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_num_waiting.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		m_cond.wait(lock, condition);
+		m_num_waiting.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	void Decode() {
+		Block block;
+		bool failed = false;
+		std::string error;
+		while (!m_stop) {
+			block.samples.clear();
+			block.error.clear();
+			block.last = false;
+			while (!failed && block.samples.size() < DECODE_BLOCK_SIZE) {
+				if (m_reader.IsFinished()) {
+					block.last = true;
+					break;
+				}
+				const int16_t *frame_data = nullptr;
+				size_t frame_size = 0;
+				if (!m_reader.Read(&frame_data, &frame_size)) {
+					failed = true;
+					error = m_reader.GetError();
+					break;
+				}
+				block.samples.insert(block.samples.end(), frame_data, frame_data + frame_size * m_reader.GetChannels());
+			}
+			// The samples decoded before an error are delivered first, the
+			// error follows in a separate empty block.
+			if (failed && block.samples.empty()) {
+				block.error = error;
+				block.last = true;
+			}
+			if (!m_queue.TryPush(block)) {
+				Wait([&]() { return m_stop || m_queue.TryPush(block); });
+				if (m_stop) {
+					return;
+				}
+			}
+			Notify();
+			if (block.last) {
+				break;
+			}
+		}
+	}
+
+	FFmpegAudioReader &m_reader;
+	SpscQueue<Block> m_queue;
+	Block m_block;
+	bool m_threaded;
+	bool m_finished = false;
+	std::atomic<bool> m_stop { false };
+	std::atomic<int> m_num_waiting { 0 };
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+	std::thread m_thread;
+};
+
 double GetCurrentTimestamp() {
 	const auto now = std::chrono::system_clock::now();
 	const auto usec = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch());
 	return usec.count() / 1000000.0;
 }
 
-void ProcessFile(ChromaprintContext *ctx, FFmpegAudioReader &reader, const char *file_name) {
+// Returns the exit code, 0 if the processing can continue with the next file.
+int ProcessFile(ChromaprintContext *ctx, FFmpegAudioReader &reader, FileOutput &output) {
 	double ts = 0.0;
 	if (g_abs_ts) {
 		ts = GetCurrentTimestamp();
 	}
 
+	const char *file_name = output.file_name();
 	if (!strcmp(file_name, "-")) {
 		file_name = "pipe:0";
 	}
 
 	if (!reader.Open(file_name)) {
-		fprintf(stderr, "ERROR: %s\n", reader.GetError().c_str());
-		exit(2);
+		output.Error(reader.GetError());
+		return 2;
 	}
 
 	if (!chromaprint_start(ctx, reader.GetSampleRate(), reader.GetChannels())) {
-		fprintf(stderr, "ERROR: Could not initialize the fingerprinting process\n");
-		exit(2);
+		output.Error("Could not initialize the fingerprinting process");
+		return 2;
 	}
 
 	size_t stream_size = 0;
@@ -288,11 +584,13 @@ void ProcessFile(ChromaprintContext *ctx, FFmpegAudioReader &reader, const char
 	bool read_failed = false;
 	bool got_results = false;
 
-	while (!reader.IsFinished()) {
+	AudioSource source(reader, g_decode_thread);
+
+	while (!source.IsFinished()) {
 		const int16_t *frame_data = nullptr;
 		size_t frame_size = 0;
-		if (!reader.Read(&frame_data, &frame_size)) {
-			fprintf(stderr, "ERROR: %s\n", reader.GetError().c_str());
+		if (!source.Read(&frame_data, &frame_size)) {
+			output.Error(source.GetError());
 			read_failed = true;
 			break;
 		}
@@ -326,20 +624,22 @@ void ProcessFile(ChromaprintContext *ctx, FFmpegAudioReader &reader, const char
 		}
 
 		if (!chromaprint_feed(ctx, frame_data, first_part_size * reader.GetChannels())) {
-			fprintf(stderr, "ERROR: Could not process audio data\n");
-			exit(2);
+			output.Error("Could not process audio data");
+			return 2;
 		}
 
 		chunk_size += first_part_size;
 
 		if (chunk_done) {
 			if (!chromaprint_finish(ctx)) {
-				fprintf(stderr, "ERROR: Could not finish the fingerprinting process\n");
-				exit(2);
+				output.Error("Could not finish the fingerprinting process");
+				return 2;
 			}
 
 			const auto chunk_duration = (chunk_size - extra_chunk_limit) * 1.0 / reader.GetSampleRate() + overlap;
-			PrintResult(ctx, reader, first_chunk, ts, chunk_duration);
+			if (!PrintResult(ctx, reader, output, first_chunk, ts, chunk_duration)) {
+				return 2;
+			}
 			got_results = true;
 
 			if (g_abs_ts) {
@@ -350,14 +650,14 @@ void ProcessFile(ChromaprintContext *ctx, FFmpegAudioReader &reader, const char
 
 			if (g_overlap) {
 				if (!chromaprint_clear_fingerprint(ctx)) {
-					fprintf(stderr, "ERROR: Could not initialize the fingerprinting process\n");
-					exit(2);
+					output.Error("Could not initialize the fingerprinting process");
+					return 2;
 				}
 				ts -= overlap;
 			} else {
 				if (!chromaprint_start(ctx, reader.GetSampleRate(), reader.GetChannels())) {
-					fprintf(stderr, "ERROR: Could not initialize the fingerprinting process\n");
-					exit(2);
+					output.Error("Could not initialize the fingerprinting process");
+					return 2;
 				}
 			}
 
@@ -374,8 +674,8 @@ void ProcessFile(ChromaprintContext *ctx, FFmpegAudioReader &reader, const char
 
 		if (frame_size > 0) {
 			if (!chromaprint_feed(ctx, frame_data, frame_size * reader.GetChannels())) {
-				fprintf(stderr, "ERROR: Could not process audio data\n");
-				exit(2);
+				output.Error("Could not process audio data");
+				return 2;
 			}
 		}
 
@@ -386,58 +686,193 @@ void ProcessFile(ChromaprintContext *ctx, FFmpegAudioReader &reader, const char
 		}
 	}
 
+	source.Stop();
+
 	if (!chromaprint_finish(ctx)) {
-		fprintf(stderr, "ERROR: Could not finish the fingerprinting process\n");
-		exit(2);
+		output.Error("Could not finish the fingerprinting process");
+		return 2;
 	}
 
 	if (chunk_size > 0) {
 		const auto chunk_duration = (chunk_size - extra_chunk_limit) * 1.0 / reader.GetSampleRate() + overlap;
-		PrintResult(ctx, reader, first_chunk, ts, chunk_duration);
+		if (!PrintResult(ctx, reader, output, first_chunk, ts, chunk_duration)) {
+			return 2;
+		}
 		got_results = true;
 	} else if (first_chunk) {
-		fprintf(stderr, "ERROR: Not enough audio data\n");
-		exit(2);
+		output.Error("Not enough audio data");
+		return 2;
 	}
 
 	if (!g_ignore_errors) {
 		if (read_failed) {
-			exit(got_results ? 3 : 2);
+			return got_results ? 3 : 2;
 		}
 	}
+	return 0;
 }
 
-int fpcalc_main(int argc, char **argv) {
-	ParseOptions(argc, argv);
-
-	FFmpegAudioReader reader;
+static bool SetupReader(FFmpegAudioReader &reader, ChromaprintContext *ctx) {
 	if (g_input_format) {
 		if (!reader.SetInputFormat(g_input_format)) {
 			fprintf(stderr, "ERROR: Invalid format\n");
-			return 2;
+			return false;
 		}
 	}
 	if (g_input_channels) {
 		if (!reader.SetInputChannels(g_input_channels)) {
 			fprintf(stderr, "ERROR: Invalid number of channels\n");
-			return 2;
+			return false;
 		}
 	}
 	if (g_input_sample_rate) {
 		if (!reader.SetInputSampleRate(g_input_sample_rate)) {
 			fprintf(stderr, "ERROR: Invalid sample rate\n");
+			return false;
+		}
+	}
+	reader.SetOutputChannels(chromaprint_get_num_channels(ctx));
+	reader.SetOutputSampleRate(chromaprint_get_sample_rate(ctx));
+	return true;
+}
+
+static ChromaprintContext *CreateContext() {
+	ChromaprintContext *ctx = chromaprint_new(g_algorithm);
+	// The fingerprint is the same, threads only help with long files, e.g. with -length 0.
+	if (g_num_threads != 1) {
+		chromaprint_set_option(ctx, "num_threads", g_num_threads);
+	}
+	return ctx;
+}
+
+// Files are processed by worker threads, each with its own reader and
+// context, while this thread prints the results. The contexts are created
+// and freed by this thread, FFT plans can't be created concurrently with
+// some FFT libraries. In the ordered mode the
+// results are printed in the order of the files, the workers are at most
+// a few files ahead of the printed output, so that the results don't pile
+// up in memory. The processing stops at the first error that would stop
+// the sequential processing, after printing the results before it.
+static int ProcessFilesInParallel(char **file_names, size_t num_files) {
+	size_t num_jobs = g_num_jobs;
+	if (num_jobs == 0) {
+		num_jobs = std::max(1u, std::thread::hardware_concurrency());
+	}
+	num_jobs = std::min(num_jobs, num_files);
+	const size_t max_pending = num_jobs * 4;
+
+	// The jobs already keep the cores busy, a decode thread per job would
+	// only double the number of threads competing for them.
+	if (num_jobs > 1) {
+		g_decode_thread = false;
+	}
+
+	struct Result {
+		std::unique_ptr<FileOutput> output;
+		int exit_code = 0;
+		bool done = false;
+	};
+	std::vector<Result> results(num_files);
+	std::deque<size_t> finished;
+	size_t next_file = 0;
+	size_t num_printed = 0;
+	bool stop = false;
+	std::mutex mutex;
+	std::condition_variable cond;
+
+	std::vector<ChromaprintContext *> contexts;
+	SCOPE_EXIT(for (auto ctx : contexts) chromaprint_free(ctx));
+	std::vector<std::unique_ptr<FFmpegAudioReader>> readers;
+	for (size_t i = 0; i < num_jobs; i++) {
+		contexts.push_back(CreateContext());
+		readers.emplace_back(new FFmpegAudioReader());
+		if (!SetupReader(*readers.back(), contexts.back())) {
 			return 2;
 		}
 	}
 
-	ChromaprintContext *chromaprint_ctx = chromaprint_new(g_algorithm);
+	auto worker = [&](ChromaprintContext *ctx, FFmpegAudioReader &reader) {
+		while (true) {
+			size_t i;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				cond.wait(lock, [&]() { return stop || next_file >= num_files || next_file < num_printed + max_pending; });
+				if (stop || next_file >= num_files) {
+					break;
+				}
+				i = next_file++;
+			}
+			std::unique_ptr<FileOutput> output(new FileOutput(file_names[i], true));
+			const int exit_code = ProcessFile(ctx, reader, *output);
+			reader.Close();
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				results[i].output = std::move(output);
+				results[i].exit_code = exit_code;
+				results[i].done = true;
+				finished.push_back(i);
+			}
+			cond.notify_all();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < num_jobs; i++) {
+		threads.emplace_back(worker, contexts[i], std::ref(*readers[i]));
+	}
+
+	int exit_code = 0;
+	for (size_t n = 0; n < num_files && exit_code == 0; n++) {
+		std::unique_ptr<FileOutput> output;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			size_t i;
+			if (g_unordered) {
+				cond.wait(lock, [&]() { return !finished.empty(); });
+				i = finished.front();
+				finished.pop_front();
+			} else {
+				i = n;
+				cond.wait(lock, [&]() { return results[i].done; });
+			}
+			output = std::move(results[i].output);
+			exit_code = results[i].exit_code;
+			num_printed++;
+			if (exit_code != 0) {
+				stop = true;
+			}
+		}
+		cond.notify_all();
+		output->Flush();
+	}
+
+	for (auto &thread : threads) {
+		thread.join();
+	}
+	return exit_code;
+}
+
+int fpcalc_main(int argc, char **argv) {
+	ParseOptions(argc, argv);
+
+	if (g_num_jobs != 1 && argc > 2) {
+		return ProcessFilesInParallel(argv + 1, argc - 1);
+	}
+
+	ChromaprintContext *chromaprint_ctx = CreateContext();
 	SCOPE_EXIT(chromaprint_free(chromaprint_ctx));
 
-	reader.SetOutputChannels(chromaprint_get_num_channels(chromaprint_ctx));
-	reader.SetOutputSampleRate(chromaprint_get_sample_rate(chromaprint_ctx));
+	FFmpegAudioReader reader;
+	if (!SetupReader(reader, chromaprint_ctx)) {
+		return 2;
+	}
 
 	for (int i = 1; i < argc; i++) {
-		ProcessFile(chromaprint_ctx, reader, argv[i]);
+		FileOutput output(argv[i], false);
+		const int exit_code = ProcessFile(chromaprint_ctx, reader, output);
+		if (exit_code != 0) {
+			return exit_code;
+		}
 	}
 
 	return 0;
@@ -0,0 +1,181 @@
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <chromaprint.h>
+#include "fingerprint_index.h"
+#include "fingerprint_decompressor.h"
+#include "utils/base64.h"
+
+using namespace chromaprint;
+
+static char *g_output = nullptr;
+static bool g_raw = false;
+static ChromaprintAlgorithm g_algorithm = CHROMAPRINT_ALGORITHM_DEFAULT;
+
+const char *g_help =
+	"Usage: %s [OPTIONS] -o INDEX [FILE...]\n"
+	"\n"
+	"Build a fingerprint index file.\n"
+	"\n"
+	"Reads fingerprints from the input files (or standard input), one per line\n"
+	"in the format \"ID FINGERPRINT\", where ID is a 32-bit unsigned integer and\n"
+	"FINGERPRINT is the compressed fingerprint as printed by fpcalc.\n"
+	"\n"
+	"Options:\n"
+	"  -o FILE        Write the index to this file\n"
+	"  -raw           Fingerprints are in the uncompressed format, as printed by fpcalc -raw\n"
+	"  -algorithm NUM Algorithm of the index, compressed fingerprints must match it (default 2)\n"
+	"  -version       Print version information\n"
+	;
+
+static void ParseOptions(int &argc, char **argv) {
+	int j = 1;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--")) {
+			while (++i < argc) {
+				argv[j++] = argv[i];
+			}
+		} else if ((!strcmp(argv[i], "-output") || !strcmp(argv[i], "-o")) && i + 1 < argc) {
+			g_output = argv[++i];
+		} else if ((!strcmp(argv[i], "-algorithm") || !strcmp(argv[i], "-a")) && i + 1 < argc) {
+			auto value = atoi(argv[i + 1]);
+			if (value >= 1 && value <= 5) {
+				g_algorithm = (ChromaprintAlgorithm)(value - 1);
+			} else {
+				fprintf(stderr, "ERROR: The argument for %s must be 1 - 5\n", argv[i]);
+				exit(2);
+			}
+			i++;
+		} else if (!strcmp(argv[i], "-raw")) {
+			g_raw = true;
+		} else if (!strcmp(argv[i], "-v") || !strcmp(argv[i], "-version")) {
+			fprintf(stdout, "fpindex version %s\n", chromaprint_get_version());
+			exit(0);
+		} else if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "-help") || !strcmp(argv[i], "--help")) {
+			fprintf(stdout, g_help, argv[0]);
+			exit(0);
+		} else {
+			const auto len = strlen(argv[i]);
+			if (len > 1 && argv[i][0] == '-') {
+				fprintf(stderr, "ERROR: Unknown option %s\n", argv[i]);
+				exit(2);
+			} else {
+				argv[j++] = argv[i];
+			}
+		}
+	}
+	if (!g_output) {
+		fprintf(stderr, "ERROR: No output file\n");
+		exit(2);
+	}
+	argc = j;
+}
+
+static bool ParseRawFingerprint(const std::string &input, std::vector<uint32_t> &fp) {
+	fp.clear();
+	std::istringstream stream(input);
+	std::string item;
+	while (std::getline(stream, item, ',')) {
+		char *end;
+		const auto value = strtoll(item.c_str(), &end, 10);
+		if (end == item.c_str() || *end != '\0') {
+			return false;
+		}
+		fp.push_back(uint32_t(value));
+	}
+	return !fp.empty();
+}
+
+static bool ParseId(const std::string &input, uint32_t &id) {
+	if (input.empty() || input.find_first_not_of("0123456789") != std::string::npos) {
+		return false;
+	}
+	errno = 0;
+	const auto value = strtoull(input.c_str(), nullptr, 10);
+	if (errno == ERANGE || value > UINT32_MAX) {
+		return false;
+	}
+	id = uint32_t(value);
+	return true;
+}
+
+static bool ProcessInput(FingerprintIndex &index, std::istream &input, const char *name) {
+	FingerprintDecompressor decompressor;
+	std::vector<uint32_t> fp;
+	std::string line, id_str, fp_str;
+	size_t line_no = 0;
+	while (std::getline(input, line)) {
+		line_no++;
+		if (line.empty()) {
+			continue;
+		}
+		std::istringstream stream(line);
+		uint32_t id;
+		if (!(stream >> id_str >> fp_str) || !ParseId(id_str, id)) {
+			fprintf(stderr, "ERROR: Invalid line %s:%zu\n", name, line_no);
+			return false;
+		}
+		if (g_raw) {
+			if (!ParseRawFingerprint(fp_str, fp)) {
+				fprintf(stderr, "ERROR: Invalid fingerprint on line %s:%zu\n", name, line_no);
+				return false;
+			}
+		} else {
+			if (!decompressor.Decompress(Base64Decode(fp_str))) {
+				fprintf(stderr, "ERROR: Invalid fingerprint on line %s:%zu\n", name, line_no);
+				return false;
+			}
+			if (decompressor.GetAlgorithm() != index.algorithm()) {
+				fprintf(stderr, "ERROR: Fingerprint on line %s:%zu was calculated with algorithm %d, expected %d\n",
+					name, line_no, decompressor.GetAlgorithm() + 1, index.algorithm() + 1);
+				return false;
+			}
+			fp = decompressor.GetOutput();
+		}
+		index.Add(id, fp);
+	}
+	return true;
+}
+
+int fpindex_main(int argc, char **argv) {
+	ParseOptions(argc, argv);
+
+	FingerprintIndex index(g_algorithm);
+
+	if (argc < 2) {
+		if (!ProcessInput(index, std::cin, "<stdin>")) {
+			return 1;
+		}
+	}
+	for (int i = 1; i < argc; i++) {
+		std::ifstream file(argv[i]);
+		if (!file) {
+			fprintf(stderr, "ERROR: Could not open %s\n", argv[i]);
+			return 1;
+		}
+		if (!ProcessInput(index, file, argv[i])) {
+			return 1;
+		}
+	}
+
+	index.Build();
+	if (!index.Save(g_output)) {
+		fprintf(stderr, "ERROR: Could not write %s\n", g_output);
+		return 1;
+	}
+
+	fprintf(stderr, "Indexed %zu fingerprints\n", index.num_fingerprints());
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	return fpindex_main(argc, argv);
+}
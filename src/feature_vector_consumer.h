@@ -4,16 +4,38 @@
 #ifndef CHROMAPRINT_FEATURE_VECTOR_CONSUMER_H_
 #define CHROMAPRINT_FEATURE_VECTOR_CONSUMER_H_
 
+#include <cstddef>
 #include <vector>
+#include "utils/allocator.h"
 
 namespace chromaprint {
 
-class FeatureVectorConsumer {
+//! Number of chroma vectors passed between the stages after chroma at once.
+static const size_t FEATURE_BLOCK_SIZE = 64;
+
+template <typename T>
+class BasicFeatureVectorConsumer : public Allocated {
 public:
-	virtual ~FeatureVectorConsumer() {}
-	virtual void Consume(std::vector<double> &features) = 0;
+	virtual ~BasicFeatureVectorConsumer() {}
+	virtual void Consume(std::vector<T> &features) = 0;
+
+	/**
+	 * Consume a block of feature vectors, stored one after another in
+	 * num_rows * num_columns elements. The consumer is free to modify the
+	 * data. The default implementation passes the vectors to Consume() one
+	 * by one.
+	 */
+	virtual void ConsumeBlock(T *features, size_t num_rows, size_t num_columns) {
+		std::vector<T> row;
+		for (size_t i = 0; i < num_rows; i++) {
+			row.assign(features + i * num_columns, features + (i + 1) * num_columns);
+			Consume(row);
+		}
+	}
 };
 
+typedef BasicFeatureVectorConsumer<double> FeatureVectorConsumer;
+
 }; // namespace chromaprint
 
 #endif
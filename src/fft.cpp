@@ -5,25 +5,56 @@
 #include "utils.h"
 #include "fft_lib.h"
 #include "fft.h"
+#include "fingerprint_pipeline.h"
 #include "debug.h"
 
 namespace chromaprint {
 
-FFT::FFT(size_t frame_size, size_t overlap, FFTFrameConsumer *consumer)
-	: m_frame(1 + frame_size / 2), m_slicer(frame_size, frame_size - overlap), m_lib(new FFTLib(frame_size)), m_consumer(consumer) {}
+template <typename T, typename Chroma>
+BasicFFT<T, Chroma>::BasicFFT(size_t frame_size, size_t overlap, BasicFFTFrameConsumer<T> *consumer)
+	: m_frame(1 + frame_size / 2), m_slicer(frame_size, frame_size - overlap), m_lib(new FFTLib(frame_size)), m_consumer(consumer), m_chroma(nullptr) {}
 
-FFT::~FFT() {}
+template <typename T, typename Chroma>
+BasicFFT<T, Chroma>::BasicFFT(size_t frame_size, size_t overlap, Chroma *chroma)
+	: m_slicer(frame_size, frame_size - overlap), m_lib(new FFTLib(frame_size)), m_consumer(nullptr), m_chroma(chroma) {}
 
-void FFT::Reset() {
+template <typename T, typename Chroma>
+BasicFFT<T, Chroma>::~BasicFFT() {}
+
+template <typename T, typename Chroma>
+void BasicFFT<T, Chroma>::Reset() {
 	m_slicer.Reset();
 }
 
-void FFT::Consume(const int16_t *input, int length) {
-	m_slicer.Process(input, input + length, [&](const int16_t *b1, const int16_t *e1, const int16_t *b2, const int16_t *e2) {
+template <typename T, typename Chroma>
+void BasicFFT<T, Chroma>::Consume(const int16_t *input, int length) {
+	Process(input, length);
+}
+
+template <typename T, typename Chroma>
+void BasicFFT<T, Chroma>::ConsumeFloat(const float *input, int length) {
+	Process(input, length);
+}
+
+template <typename T, typename Chroma>
+template <typename Sample>
+void BasicFFT<T, Chroma>::Process(const Sample *input, int length) {
+	// the frame is either in the buffer of the slicer, followed by the input, or all in the input
+	m_slicer.Process(input, input + length, [&](auto b1, auto e1, auto b2, auto e2) {
 		m_lib->Load(b1, e1, b2, e2);
-		m_lib->Compute(m_frame);
-		m_consumer->Consume(m_frame);
+		if (m_chroma) {
+			m_lib->Transform();
+			m_chroma->ConsumeTransform(*m_lib);
+		} else {
+			m_lib->Compute(m_frame);
+			m_consumer->Consume(m_frame);
+		}
 	});
 }
 
+template class BasicFFT<float>;
+template class BasicFFT<double>;
+template class BasicFFT<float, StaticFingerprintPipeline<float>::Chroma>;
+template class BasicFFT<double, StaticFingerprintPipeline<double>::Chroma>;
+
 }; // namespace chromaprint
@@ -11,16 +11,24 @@
 #include "fft_frame_consumer.h"
 #include "audio_consumer.h"
 #include "audio/audio_slicer.h"
+#include "chroma.h"
 
 namespace chromaprint {
 
 class FFTLib;
 
-class FFT : public AudioConsumer
+template <typename T, typename Chroma = BasicChroma<T>>
+class BasicFFT : public AudioConsumer
 {
 public:
-	FFT(size_t frame_size, size_t overlap, FFTFrameConsumer *consumer);
-	~FFT();
+	BasicFFT(size_t frame_size, size_t overlap, BasicFFTFrameConsumer<T> *consumer);
+
+	/**
+	 * Pass the output of the transform directly to the chroma stage, which
+	 * computes only the bins it needs, instead of delivering full frames.
+	 */
+	BasicFFT(size_t frame_size, size_t overlap, Chroma *chroma);
+	~BasicFFT();
 
 	size_t frame_size() const {
 		return m_slicer.size();
@@ -36,16 +44,24 @@ public:
 
 	void Reset();
 	void Consume(const int16_t *input, int length) override;
+	void ConsumeFloat(const float *input, int length) override;
 
 private:
-	CHROMAPRINT_DISABLE_COPY(FFT);
+	CHROMAPRINT_DISABLE_COPY(BasicFFT);
+
+	template <typename Sample>
+	void Process(const Sample *input, int length);
 
-	FFTFrame m_frame;
-	AudioSlicer<int16_t> m_slicer;
+	BasicFFTFrame<T> m_frame;
+	// 16-bit samples are stored as floats exactly, so both inputs can share a frame
+	AudioSlicer<float> m_slicer;
 	std::unique_ptr<FFTLib> m_lib;
-	FFTFrameConsumer *m_consumer;
+	BasicFFTFrameConsumer<T> *m_consumer;
+	Chroma *m_chroma;
 };
 
+typedef BasicFFT<double> FFT;
+
 }; // namespace chromaprint
 
 #endif
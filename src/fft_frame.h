@@ -8,7 +8,10 @@
 
 namespace chromaprint {
 
-typedef std::vector<double> FFTFrame;
+template <typename T>
+using BasicFFTFrame = std::vector<T>;
+
+typedef BasicFFTFrame<double> FFTFrame;
 
 }; // namespace chromaprint
 
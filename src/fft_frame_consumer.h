@@ -5,16 +5,20 @@
 #define CHROMAPRINT_FFT_FRAME_CONSUMER_H_
 
 #include "fft_frame.h"
+#include "utils/allocator.h"
 
 namespace chromaprint {
 
-class FFTFrameConsumer
+template <typename T>
+class BasicFFTFrameConsumer : public Allocated
 {
 public:
-	virtual ~FFTFrameConsumer() {}
-	virtual void Consume(const FFTFrame &frame) = 0;
+	virtual ~BasicFFTFrameConsumer() {}
+	virtual void Consume(const BasicFFTFrame<T> &frame) = 0;
 };
 
+typedef BasicFFTFrameConsumer<double> FFTFrameConsumer;
+
 }; // namespace chromaprint
 
 #endif
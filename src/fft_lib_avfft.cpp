@@ -6,9 +6,8 @@
 namespace chromaprint {
 
 FFTLib::FFTLib(size_t frame_size) : m_frame_size(frame_size) {
-	m_window = (FFTSample *) av_malloc(sizeof(FFTSample) * frame_size);
-	m_input = (FFTSample *) av_malloc(sizeof(FFTSample) * frame_size);
-	PrepareHammingWindow(m_window, m_window + frame_size, 1.0 / INT16_MAX);
+	m_input = (FFTSample *) AllocateOrThrow(sizeof(FFTSample) * frame_size, SIMD_ALIGNMENT);
+	m_window = GetHammingWindow<FFTSample>(frame_size, 1.0 / INT16_MAX);
 	int bits = -1;
 	while (frame_size) {
 		bits++;
@@ -19,19 +18,16 @@ FFTLib::FFTLib(size_t frame_size) : m_frame_size(frame_size) {
 
 FFTLib::~FFTLib() {
 	av_rdft_end(m_rdft_ctx);
-	av_free(m_input);
-	av_free(m_window);
+	Deallocate(m_input);
 }
 
-void FFTLib::Load(const int16_t *b1, const int16_t *e1, const int16_t *b2, const int16_t *e2) {
-	auto window = m_window;
-	auto output = m_input;
-	ApplyWindow(b1, e1, window, output);
-	ApplyWindow(b2, e2, window, output);
+void FFTLib::Transform() {
+	av_rdft_calc(m_rdft_ctx, m_input);
 }
 
-void FFTLib::Compute(FFTFrame &frame) {
-	av_rdft_calc(m_rdft_ctx, m_input);
+template <typename T>
+void FFTLib::Compute(BasicFFTFrame<T> &frame) {
+	Transform();
 	auto input = m_input;
 	auto output = frame.begin();
 	output[0] = input[0] * input[0];
@@ -44,4 +40,7 @@ void FFTLib::Compute(FFTFrame &frame) {
 	}
 }
 
+template void FFTLib::Compute(BasicFFTFrame<float> &frame);
+template void FFTLib::Compute(BasicFFTFrame<double> &frame);
+
 }; // namespace chromaprint
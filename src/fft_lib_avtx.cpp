@@ -1,15 +1,15 @@
 // Copyright (C) 2010-2016  Lukas Lalinsky
 // Distributed under the MIT license, see the LICENSE file for details.
 
+#include <cstring>
 #include "fft_lib_avtx.h"
 
 namespace chromaprint {
 
 FFTLib::FFTLib(size_t frame_size) : m_frame_size(frame_size) {
-	m_window = (float *) av_malloc(sizeof(float) * frame_size);
-	m_input = (float *) av_malloc(sizeof(float) * frame_size);
-	m_output = (AVComplexFloat *) av_malloc(sizeof(AVComplexFloat) * (frame_size / 2 + 1));
-	PrepareHammingWindow(m_window, m_window + frame_size, 1.0 / INT16_MAX);
+	m_input = (float *) AllocateOrThrow(sizeof(float) * frame_size, SIMD_ALIGNMENT);
+	m_output = (AVComplexFloat *) AllocateOrThrow(sizeof(AVComplexFloat) * (frame_size / 2 + 1), SIMD_ALIGNMENT);
+	m_window = GetHammingWindow<float>(frame_size, 1.0 / INT16_MAX);
 	
 	// Initialize the RDFT transform context
 	// For real-to-complex transform: inv=0, no scaling, no special flags
@@ -23,27 +23,25 @@ FFTLib::FFTLib(size_t frame_size) : m_frame_size(frame_size) {
 
 FFTLib::~FFTLib() {
 	av_tx_uninit(&m_tx_ctx);
-	av_free(m_output);
-	av_free(m_input);
-	av_free(m_window);
+	Deallocate(m_output);
+	Deallocate(m_input);
 }
 
-void FFTLib::Load(const int16_t *b1, const int16_t *e1, const int16_t *b2, const int16_t *e2) {
-	auto window = m_window;
-	auto output = m_input;
-	ApplyWindow(b1, e1, window, output);
-	ApplyWindow(b2, e2, window, output);
-}
-
-void FFTLib::Compute(FFTFrame &frame) {
+void FFTLib::Transform() {
 	if (!m_tx_ctx || !m_tx_fn) {
 		// Transform context initialization failed
+		memset(m_output, 0, sizeof(AVComplexFloat) * (m_frame_size / 2 + 1));
 		return;
 	}
 	
 	// Perform the real-to-complex FFT
 	// stride parameter: spacing between input samples in bytes
 	m_tx_fn(m_tx_ctx, m_output, m_input, sizeof(float));
+}
+
+template <typename T>
+void FFTLib::Compute(BasicFFTFrame<T> &frame) {
+	Transform();
 	
 	// Convert complex output to power spectrum
 	auto input = m_output;
@@ -64,4 +62,7 @@ void FFTLib::Compute(FFTFrame &frame) {
 	}
 }
 
+template void FFTLib::Compute(BasicFFTFrame<float> &frame);
+template void FFTLib::Compute(BasicFFTFrame<double> &frame);
+
 }; // namespace chromaprint
\ No newline at end of file
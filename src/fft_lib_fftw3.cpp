@@ -1,34 +1,64 @@
 // Copyright (C) 2010-2016  Lukas Lalinsky
 // Distributed under the MIT license, see the LICENSE file for details.
 
+#include <mutex>
 #include "fft_lib_fftw3.h"
+#include "utils/shared_cache.h"
 
 namespace chromaprint {
 
+namespace {
+
+// Only plan execution is thread-safe in FFTW, plans must be created and
+// destroyed by one thread at a time.
+std::mutex g_planner_mutex;
+
+}; // namespace
+
+// Plans are shared by all FFTs of the same size and executed with the
+// arrays of each FFT, which are SIMD-aligned like the ones from fftw_malloc().
+struct FFTLib::Plan {
+	explicit Plan(size_t frame_size) {
+		FFTW_SCALAR *input = (FFTW_SCALAR *) fftw_malloc(sizeof(FFTW_SCALAR) * frame_size);
+		FFTW_SCALAR *output = (FFTW_SCALAR *) fftw_malloc(sizeof(FFTW_SCALAR) * frame_size);
+		{
+			std::lock_guard<std::mutex> lock(g_planner_mutex);
+			plan = fftw_plan_r2r_1d(frame_size, input, output, FFTW_R2HC, FFTW_ESTIMATE);
+		}
+		fftw_free(output);
+		fftw_free(input);
+	}
+
+	~Plan() {
+		std::lock_guard<std::mutex> lock(g_planner_mutex);
+		fftw_destroy_plan(plan);
+	}
+
+	fftw_plan plan;
+};
+
 FFTLib::FFTLib(size_t frame_size) : m_frame_size(frame_size) {
-	m_window = (FFTW_SCALAR *) fftw_malloc(sizeof(FFTW_SCALAR) * frame_size);
-	m_input = (FFTW_SCALAR *) fftw_malloc(sizeof(FFTW_SCALAR) * frame_size);
-	m_output = (FFTW_SCALAR *) fftw_malloc(sizeof(FFTW_SCALAR) * frame_size);
-	PrepareHammingWindow(m_window, m_window + frame_size, 1.0 / INT16_MAX);
-	m_plan = fftw_plan_r2r_1d(frame_size, m_input, m_output, FFTW_R2HC, FFTW_ESTIMATE);
+	m_input = (FFTW_SCALAR *) AllocateOrThrow(sizeof(FFTW_SCALAR) * frame_size, SIMD_ALIGNMENT);
+	m_output = (FFTW_SCALAR *) AllocateOrThrow(sizeof(FFTW_SCALAR) * frame_size, SIMD_ALIGNMENT);
+	m_window = GetHammingWindow<FFTW_SCALAR>(frame_size, 1.0 / INT16_MAX);
+	static SharedCache<size_t, Plan> cache;
+	m_plan = cache.Get(frame_size, [&]() {
+		return std::make_shared<Plan>(frame_size);
+	});
 }
 
 FFTLib::~FFTLib() {
-	fftw_destroy_plan(m_plan);
-	fftw_free(m_output);
-	fftw_free(m_input);
-	fftw_free(m_window);
+	Deallocate(m_output);
+	Deallocate(m_input);
 }
 
-void FFTLib::Load(const int16_t *b1, const int16_t *e1, const int16_t *b2, const int16_t *e2) {
-	auto window = m_window;
-	auto output = m_input;
-	ApplyWindow(b1, e1, window, output);
-	ApplyWindow(b2, e2, window, output);
+void FFTLib::Transform() {
+	fftw_execute_r2r(m_plan->plan, m_input, m_output);
 }
 
-void FFTLib::Compute(FFTFrame &frame) {
-	fftw_execute(m_plan);
+template <typename T>
+void FFTLib::Compute(BasicFFTFrame<T> &frame) {
+	Transform();
 	auto output = frame.data();
 	auto in_ptr = m_output;
 	auto rev_in_ptr = m_output + m_frame_size - 1;
@@ -43,4 +73,7 @@ void FFTLib::Compute(FFTFrame &frame) {
 	}
 }
 
+template void FFTLib::Compute(BasicFFTFrame<float> &frame);
+template void FFTLib::Compute(BasicFFTFrame<double> &frame);
+
 }; // namespace chromaprint
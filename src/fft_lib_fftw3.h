@@ -8,12 +8,15 @@
 
 #include "fft_frame.h"
 #include "utils.h"
+#include "fft_window.h"
+#include "utils/allocator.h"
 
 #ifdef USE_FFTW3F
 #define FFTW_SCALAR float
 #define fftw_plan fftwf_plan
 #define fftw_plan_r2r_1d fftwf_plan_r2r_1d
 #define fftw_execute fftwf_execute
+#define fftw_execute_r2r fftwf_execute_r2r
 #define fftw_destroy_plan fftwf_destroy_plan
 #define fftw_malloc fftwf_malloc
 #define fftw_free fftwf_free
@@ -23,22 +26,43 @@
 
 namespace chromaprint {
 
-class FFTLib {
+class FFTLib : public Allocated {
 public:
 	FFTLib(size_t frame_size);
 	~FFTLib();
 
-	void Load(const int16_t *begin1, const int16_t *end1, const int16_t *begin2, const int16_t *end2);
-	void Compute(FFTFrame &frame);
+	//! Load a frame given in two parts, as 16-bit samples or floats in the same range, and apply the window.
+	template <typename S1, typename S2>
+	void Load(const S1 *begin1, const S1 *end1, const S2 *begin2, const S2 *end2) {
+		auto window = m_window->data();
+		auto output = m_input;
+		ApplyWindow(begin1, end1, window, output);
+		ApplyWindow(begin2, end2, window, output);
+	}
+
+	template <typename T>
+	void Compute(BasicFFTFrame<T> &frame);
+
+	//! Run the transform without calculating the power spectrum, use Power() to get individual bins.
+	void Transform();
+
+	FFTW_SCALAR Power(size_t i) const {
+		if (i == 0 || i == m_frame_size / 2) {
+			return m_output[i] * m_output[i];
+		}
+		return m_output[i] * m_output[i] + m_output[m_frame_size - i] * m_output[m_frame_size - i];
+	}
 
 private:
 	CHROMAPRINT_DISABLE_COPY(FFTLib);
 
+	struct Plan;
+
 	size_t m_frame_size;
-	FFTW_SCALAR *m_window;
+	std::shared_ptr<const std::vector<FFTW_SCALAR>> m_window;
 	FFTW_SCALAR *m_input;
 	FFTW_SCALAR *m_output;
-	fftw_plan m_plan;
+	std::shared_ptr<const Plan> m_plan;
 };
 
 }; // namespace chromaprint
@@ -8,22 +8,40 @@
 
 #include "fft_frame.h"
 #include "utils.h"
+#include "fft_window.h"
+#include "utils/allocator.h"
 
 namespace chromaprint {
 
-class FFTLib {
+class FFTLib : public Allocated {
 public:
 	FFTLib(size_t frame_size);
 	~FFTLib();
 
-	void Load(const int16_t *begin1, const int16_t *end1, const int16_t *begin2, const int16_t *end2);
-	void Compute(FFTFrame &frame);
+	//! Load a frame given in two parts, as 16-bit samples or floats in the same range, and apply the window.
+	template <typename S1, typename S2>
+	void Load(const S1 *begin1, const S1 *end1, const S2 *begin2, const S2 *end2) {
+		auto window = m_window->data();
+		auto output = m_input;
+		ApplyWindow(begin1, end1, window, output);
+		ApplyWindow(begin2, end2, window, output);
+	}
+
+	template <typename T>
+	void Compute(BasicFFTFrame<T> &frame);
+
+	//! Run the transform without calculating the power spectrum, use Power() to get individual bins.
+	void Transform();
+
+	kiss_fft_scalar Power(size_t i) const {
+		return m_output[i].r * m_output[i].r + m_output[i].i * m_output[i].i;
+	}
 
 private:
 	CHROMAPRINT_DISABLE_COPY(FFTLib);
 
 	size_t m_frame_size;
-	kiss_fft_scalar *m_window;
+	std::shared_ptr<const std::vector<kiss_fft_scalar>> m_window;
 	kiss_fft_scalar *m_input;
 	kiss_fft_cpx *m_output;
 	kiss_fftr_cfg m_cfg;
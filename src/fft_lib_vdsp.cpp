@@ -10,32 +10,28 @@ FFTLib::FFTLib(size_t frame_size) : m_frame_size(frame_size) {
 	double log2n = log2(frame_size);
 	assert(log2n == int(log2n));
 	m_log2n = int(log2n);
-	m_window = new float[frame_size];
-	m_input = new float[frame_size];
-	m_a.realp = new float[frame_size / 2];
-	m_a.imagp = new float[frame_size / 2];
-	PrepareHammingWindow(m_window, m_window + frame_size, 0.5 / INT16_MAX);
+	m_input = (float *) AllocateOrThrow(sizeof(float) * frame_size, SIMD_ALIGNMENT);
+	m_a.realp = (float *) AllocateOrThrow(sizeof(float) * (frame_size / 2), SIMD_ALIGNMENT);
+	m_a.imagp = (float *) AllocateOrThrow(sizeof(float) * (frame_size / 2), SIMD_ALIGNMENT);
+	m_window = GetHammingWindow<float>(frame_size, 0.5 / INT16_MAX);
 	m_setup = vDSP_create_fftsetup(m_log2n, 0);
 }
 
 FFTLib::~FFTLib() {
 	vDSP_destroy_fftsetup(m_setup);
-	delete[] m_a.realp;
-	delete[] m_a.imagp;
-	delete[] m_input;
-	delete[] m_window;
+	Deallocate(m_a.realp);
+	Deallocate(m_a.imagp);
+	Deallocate(m_input);
 }
 
-void FFTLib::Load(const int16_t *b1, const int16_t *e1, const int16_t *b2, const int16_t *e2) {
-	auto window = m_window;
-	auto output = m_input;
-	ApplyWindow(b1, e1, window, output);
-	ApplyWindow(b2, e2, window, output);
-}
-
-void FFTLib::Compute(FFTFrame &frame) {
+void FFTLib::Transform() {
 	vDSP_ctoz((DSPComplex *) m_input, 2, &m_a, 1, m_frame_size / 2); 
 	vDSP_fft_zrip(m_setup, &m_a, 1, m_log2n, FFT_FORWARD);
+}
+
+template <typename T>
+void FFTLib::Compute(BasicFFTFrame<T> &frame) {
+	Transform();
 	auto output = frame.data();
 	output[0] = m_a.realp[0] * m_a.realp[0];
 	output[m_frame_size / 2] = m_a.imagp[0] * m_a.imagp[0];
@@ -45,4 +41,7 @@ void FFTLib::Compute(FFTFrame &frame) {
 	}
 }
 
+template void FFTLib::Compute(BasicFFTFrame<float> &frame);
+template void FFTLib::Compute(BasicFFTFrame<double> &frame);
+
 }; // namespace chromaprint
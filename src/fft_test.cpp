@@ -5,6 +5,7 @@
 #include <functional>
 #include <gtest/gtest.h>
 #include "fft.h"
+#include "chroma.h"
 #include "test_utils.h"
 
 namespace chromaprint {
@@ -18,6 +19,13 @@ struct Collector : public FFTFrameConsumer {
 	std::vector<FFTFrame> frames;
 };
 
+struct FeatureCollector : public FeatureVectorConsumer {
+	virtual void Consume(std::vector<double> &features) override {
+		features_list.push_back(features);
+	}
+	std::vector<std::vector<double>> features_list;
+};
+
 };
 
 TEST(FFTTest, Sine) {
@@ -134,4 +142,63 @@ TEST(FFTTest, DC) {
 	}
 }
 
+TEST(FFTTest, ConsumeFloat) {
+	const size_t frame_size = 32;
+	const size_t overlap = 8;
+
+	std::vector<int16_t> input(frame_size * 4);
+	for (size_t i = 0; i < input.size(); i++) {
+		input[i] = int16_t(1000 * sin(i * 0.3));
+	}
+	std::vector<float> float_input(input.begin(), input.end());
+
+	Collector expected;
+	FFT fft1(frame_size, overlap, &expected);
+	fft1.Consume(input.data(), input.size());
+
+	// 16-bit samples passed as floats give the same frames, also when the
+	// frames are split between calls with different sample types
+	Collector actual;
+	FFT fft2(frame_size, overlap, &actual);
+	fft2.ConsumeFloat(float_input.data(), 40);
+	fft2.Consume(input.data() + 40, 30);
+	fft2.ConsumeFloat(float_input.data() + 70, float_input.size() - 70);
+
+	ASSERT_FALSE(expected.frames.empty());
+	ASSERT_EQ(expected.frames, actual.frames);
+
+	// fractions of 16-bit samples are not rounded away
+	for (auto &value : float_input) {
+		value += 0.25f;
+	}
+	Collector shifted;
+	FFT fft3(frame_size, overlap, &shifted);
+	fft3.ConsumeFloat(float_input.data(), float_input.size());
+	ASSERT_EQ(expected.frames.size(), shifted.frames.size());
+	ASSERT_NE(expected.frames[0][0], shifted.frames[0][0]);
+}
+
+TEST(FFTTest, FusedChroma) {
+	const auto input = LoadAudioFile("data/test_mono_11025.raw");
+	const size_t frame_size = 4096;
+	const size_t overlap = frame_size - frame_size / 3;
+
+	for (bool interpolate : { false, true }) {
+		FeatureCollector expected;
+		Chroma chroma1(28, 3520, frame_size, 11025, &expected);
+		chroma1.set_interpolate(interpolate);
+		FFT fft1(frame_size, overlap, static_cast<FFTFrameConsumer *>(&chroma1));
+		fft1.Consume(input.data(), input.size());
+
+		FeatureCollector actual;
+		Chroma chroma2(28, 3520, frame_size, 11025, &actual);
+		chroma2.set_interpolate(interpolate);
+		FFT fft2(frame_size, overlap, &chroma2);
+		fft2.Consume(input.data(), input.size());
+
+		ASSERT_FALSE(expected.features_list.empty());
+		ASSERT_EQ(expected.features_list, actual.features_list);
+	}
+}
+
 }; // namespace chromaprint
@@ -0,0 +1,33 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_FFT_WINDOW_H_
+#define CHROMAPRINT_FFT_WINDOW_H_
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "utils.h"
+#include "utils/shared_cache.h"
+
+namespace chromaprint {
+
+/**
+ * Get a Hamming window of the given size, multiplied by scale. Windows are
+ * immutable and shared by all FFTs that use the same size and scale.
+ */
+template <typename T>
+std::shared_ptr<const std::vector<T>> GetHammingWindow(size_t size, double scale)
+{
+	static SharedCache<std::pair<size_t, double>, std::vector<T>> cache;
+	return cache.Get(std::make_pair(size, scale), [&]() {
+		std::shared_ptr<std::vector<T>> window(new std::vector<T>(size));
+		PrepareHammingWindow(window->begin(), window->end(), scale);
+		return window;
+	});
+}
+
+}; // namespace chromaprint
+
+#endif
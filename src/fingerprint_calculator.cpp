@@ -2,50 +2,38 @@
 // Distributed under the MIT license, see the LICENSE file for details.
 
 #include "fingerprint_calculator.h"
+#include "fingerprint_consumer.h"
 #include "classifier.h"
 #include "debug.h"
 #include "utils.h"
 
 namespace chromaprint {
 
-FingerprintCalculator::FingerprintCalculator(const Classifier *classifiers, size_t num_classifiers)
-	: m_classifiers(classifiers), m_num_classifiers(num_classifiers), m_image(256)
+template <typename T>
+BasicFingerprintCalculator<T>::BasicFingerprintCalculator(const Classifier *classifiers, size_t num_classifiers)
+	: m_program(classifiers, num_classifiers), m_max_filter_width(m_program.max_filter_width()), m_image(MAX_IMAGE_ROWS)
 {
-	m_max_filter_width = 0;
-	for (size_t i = 0; i < num_classifiers; i++) {
-		m_max_filter_width = std::max(m_max_filter_width, (size_t) classifiers[i].filter().width());
-	}
 	assert(m_max_filter_width > 0);
-	assert(m_max_filter_width < 256);
+	assert(m_max_filter_width < MAX_IMAGE_ROWS);
 }
 
-uint32_t FingerprintCalculator::CalculateSubfingerprint(size_t offset)
-{
-	uint32_t bits = 0;
-	for (size_t i = 0; i < m_num_classifiers; i++) {
-		bits = (bits << 2) | GrayCode(m_classifiers[i].Classify(m_image, offset));
-	}
-	return bits;
-}
-
-void FingerprintCalculator::Reset() {
+template <typename T>
+void BasicFingerprintCalculator<T>::Reset() {
 	m_image.Reset();
 	m_fingerprint.clear();
 }
 
-void FingerprintCalculator::Consume(std::vector<double> &features) {
-	m_image.AddRow(features);
-	if (m_image.num_rows() >= m_max_filter_width) {
-		m_fingerprint.push_back(CalculateSubfingerprint(m_image.num_rows() - m_max_filter_width));
-	}
-}
-
-const std::vector<uint32_t> &FingerprintCalculator::GetFingerprint() const {
+template <typename T>
+const Vector<uint32_t> &BasicFingerprintCalculator<T>::GetFingerprint() const {
 	return m_fingerprint;
 }
 
-void FingerprintCalculator::ClearFingerprint() {
+template <typename T>
+void BasicFingerprintCalculator<T>::ClearFingerprint() {
 	m_fingerprint.clear();
 }
 
+template class BasicFingerprintCalculator<float>;
+template class BasicFingerprintCalculator<double>;
+
 }; // namespace chromaprint
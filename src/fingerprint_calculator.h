@@ -6,23 +6,69 @@
 
 #include <cstdint>
 #include <vector>
+#include <algorithm>
 #include "feature_vector_consumer.h"
+#include "fingerprint_consumer.h"
+#include "classifier.h"
+#include "classifier_program.h"
+#include "utils.h"
 #include "utils/rolling_integral_image.h"
 
 namespace chromaprint {
 
-class Classifier;
-class Image;
-class IntegralImage;
-
-class FingerprintCalculator : public FeatureVectorConsumer {
+template <typename T>
+class BasicFingerprintCalculator final : public BasicFeatureVectorConsumer<T> {
 public:
-	FingerprintCalculator(const Classifier *classifiers, size_t num_classifiers);
+	BasicFingerprintCalculator(const Classifier *classifiers, size_t num_classifiers);
+
+	virtual void Consume(std::vector<T> &features) override {
+		m_image.AddRow(features);
+		if (m_image.num_rows() >= m_max_filter_width) {
+			const size_t offset = m_image.num_rows() - m_max_filter_width;
+			uint32_t subfingerprint;
+			m_program.Run(m_image, offset, offset + 1, &subfingerprint);
+			if (m_consumer) {
+				m_consumer->Consume(&subfingerprint, 1, offset);
+			} else {
+				m_fingerprint.push_back(subfingerprint);
+			}
+		}
+	}
+
+	/**
+	 * Process a block of feature vectors. All rows are added to the image
+	 * first and then the classifiers are evaluated for all new offsets at once.
+	 */
+	virtual void ConsumeBlock(T *features, size_t num_rows, size_t num_columns) override {
+		// The rows needed by the first new offset must stay in the rolling image.
+		const size_t max_chunk_rows = MAX_IMAGE_ROWS - m_max_filter_width;
+		while (num_rows > 0) {
+			const size_t chunk_rows = std::min(num_rows, max_chunk_rows);
+			const size_t begin_row = m_image.num_rows();
+			for (size_t i = 0; i < chunk_rows; i++) {
+				m_image.AddRow(features + i * num_columns, features + (i + 1) * num_columns);
+			}
+			features += chunk_rows * num_columns;
+			num_rows -= chunk_rows;
 
-	virtual void Consume(std::vector<double> &features) override;
+			const size_t end_row = m_image.num_rows();
+			if (end_row < m_max_filter_width) {
+				continue;
+			}
+			const size_t begin_offset = std::max(begin_row + 1, m_max_filter_width) - m_max_filter_width;
+			const size_t end_offset = end_row - m_max_filter_width + 1;
+			m_block_fingerprint.resize(end_offset - begin_offset);
+			m_program.Run(m_image, begin_offset, end_offset, m_block_fingerprint.data());
+			if (m_consumer) {
+				m_consumer->Consume(m_block_fingerprint.data(), m_block_fingerprint.size(), begin_offset);
+			} else {
+				m_fingerprint.insert(m_fingerprint.end(), m_block_fingerprint.begin(), m_block_fingerprint.end());
+			}
+		}
+	}
 
 	//! Get the fingerprint generate from data up to this point.
-	const std::vector<uint32_t> &GetFingerprint() const;
+	const Vector<uint32_t> &GetFingerprint() const;
 
 	//! Clear the generated fingerprint, but allow more features to be processed.
 	void ClearFingerprint();
@@ -30,16 +76,30 @@ public:
 	//! Reset all internal state.
 	void Reset();
 
+	/**
+	 * Deliver every new item of the fingerprint to the consumer as soon as
+	 * it is calculated, instead of accumulating them. Passing NULL switches
+	 * back to accumulating the fingerprint.
+	 */
+	void set_consumer(FingerprintConsumer *consumer) { m_consumer = consumer; }
+	FingerprintConsumer *consumer() const { return m_consumer; }
+
 private:
-	uint32_t CalculateSubfingerprint(size_t offset);
+	static const size_t MAX_IMAGE_ROWS = 256;
 
-	const Classifier *m_classifiers;
-	size_t m_num_classifiers;
+	ClassifierProgram m_program;
 	size_t m_max_filter_width;
 	RollingIntegralImage m_image;
-	std::vector<uint32_t> m_fingerprint;
+	Vector<uint32_t> m_fingerprint;
+	Vector<uint32_t> m_block_fingerprint;
+	FingerprintConsumer *m_consumer = nullptr;
 };
 
+extern template class BasicFingerprintCalculator<float>;
+extern template class BasicFingerprintCalculator<double>;
+
+typedef BasicFingerprintCalculator<double> FingerprintCalculator;
+
 }; // namespace chromaprint
 
 #endif
@@ -36,10 +36,8 @@ void FingerprintCompressor::ProcessSubfingerprint(uint32_t x)
 	m_normal_bits.push_back(0);
 }
 
-void FingerprintCompressor::Compress(const std::vector<uint32_t> &data, int algorithm, std::string &output)
+void FingerprintCompressor::Compress(const uint32_t *data, size_t size, int algorithm, std::string &output)
 {
-	const auto size = data.size();
-
 	m_normal_bits.clear();
 	m_exceptional_bits.clear();
 
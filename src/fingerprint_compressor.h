@@ -15,13 +15,19 @@ class FingerprintCompressor
 public:
 	FingerprintCompressor();
 
-	std::string Compress(const std::vector<uint32_t> &fingerprint, int algorithm = 0) {
+	template <typename Alloc>
+	std::string Compress(const std::vector<uint32_t, Alloc> &fingerprint, int algorithm = 0) {
 		std::string tmp;
-		Compress(fingerprint, algorithm, tmp);
+		Compress(fingerprint.data(), fingerprint.size(), algorithm, tmp);
 		return tmp;
 	}
 
-	void Compress(const std::vector<uint32_t> &fingerprint, int algorithm, std::string &output);
+	template <typename Alloc>
+	void Compress(const std::vector<uint32_t, Alloc> &fingerprint, int algorithm, std::string &output) {
+		Compress(fingerprint.data(), fingerprint.size(), algorithm, output);
+	}
+
+	void Compress(const uint32_t *fingerprint, size_t size, int algorithm, std::string &output);
 
 private:
 	void ProcessSubfingerprint(uint32_t);
@@ -29,7 +35,8 @@ private:
 	std::vector<unsigned char> m_exceptional_bits;
 };
 
-inline std::string CompressFingerprint(const std::vector<uint32_t> &data, int algorithm = 0)
+template <typename Alloc>
+inline std::string CompressFingerprint(const std::vector<uint32_t, Alloc> &data, int algorithm = 0)
 {
 	FingerprintCompressor compressor;
 	return compressor.Compress(data, algorithm);
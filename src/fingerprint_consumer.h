@@ -0,0 +1,28 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_FINGERPRINT_CONSUMER_H_
+#define CHROMAPRINT_FINGERPRINT_CONSUMER_H_
+
+#include <cstdint>
+#include <cstddef>
+#include "utils/allocator.h"
+
+namespace chromaprint {
+
+class FingerprintConsumer : public Allocated {
+public:
+	virtual ~FingerprintConsumer() {}
+
+	/**
+	 * Receive newly calculated items of the fingerprint.
+	 *
+	 * The offset is the position of the first item in the whole fingerprint,
+	 * counted from the last reset.
+	 */
+	virtual void Consume(const uint32_t *fingerprint, size_t size, size_t offset) = 0;
+};
+
+}; // namespace chromaprint
+
+#endif
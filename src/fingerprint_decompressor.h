@@ -17,7 +17,7 @@ public:
 	bool DecompressHeader(const std::string &fingerprint);
 	bool Decompress(const std::string &fingerprint);
 
-	std::vector<uint32_t> GetOutput() const { return m_output; }
+	const std::vector<uint32_t> &GetOutput() const { return m_output; }
 	size_t GetSize() const { return m_size; }
 	int GetAlgorithm() const { return m_algorithm; }
 
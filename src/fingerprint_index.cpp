@@ -0,0 +1,541 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include "fingerprint_index.h"
+#include "fingerprint_matcher.h"
+#include "fingerprint_matcher_settings.h"
+#include "fingerprint_compressor.h"
+#include "fingerprinter_configuration.h"
+#include "utils/mapped_file.h"
+#include "debug.h"
+
+namespace chromaprint {
+
+namespace {
+
+const int kKeyShift = 32 - ACOUSTID_QUERY_BITS;
+const int kDirectoryShift = ACOUSTID_QUERY_BITS - 16;
+const size_t kDirectorySize = (1u << 16) + 1;
+
+inline uint32_t GetKey(uint32_t x)
+{
+	return ACOUSTID_QUERY_STRIP(x) >> kKeyShift;
+}
+
+inline void WriteVarInt(std::vector<uint8_t> &output, uint32_t value)
+{
+	while (value >= 0x80) {
+		output.push_back(uint8_t(value | 0x80));
+		value >>= 7;
+	}
+	output.push_back(uint8_t(value));
+}
+
+inline uint32_t ReadVarInt(const uint8_t *&input)
+{
+	uint32_t value = 0;
+	int shift = 0;
+	uint8_t byte;
+	do {
+		byte = *input++;
+		value |= uint32_t(byte & 0x7f) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+	return value;
+}
+
+// Index file layout, all integers are in native byte order:
+//
+//   header
+//   directory          uint32_t[kDirectorySize]
+//   directory offsets  uint64_t[kDirectorySize]
+//   keys               uint32_t[num_keys]
+//   key offsets        uint32_t[num_keys]
+//   postings           uint8_t[]
+//   documents          FileDocument[num_docs]
+//   fingerprints       compressed fingerprints, see FingerprintCompressor
+//
+// Every section starts at a multiple of 8 bytes.
+
+const char kFileMagic[8] = { 'C', 'P', 'I', 'N', 'D', 'E', 'X', '\0' };
+const uint32_t kFileVersion = 1;
+const uint32_t kFileByteOrderMark = 0x01020304;
+
+enum {
+	SECTION_DIRECTORY = 0,
+	SECTION_DIRECTORY_OFFSETS,
+	SECTION_KEYS,
+	SECTION_KEY_OFFSETS,
+	SECTION_POSTINGS,
+	SECTION_DOCUMENTS,
+	SECTION_FINGERPRINTS,
+	NUM_SECTIONS,
+};
+
+struct FileSection {
+	uint64_t offset;
+	uint64_t size;
+};
+
+struct FileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t algorithm;
+	uint32_t key_bits;
+	uint64_t num_keys;
+	uint64_t num_docs;
+	uint64_t file_size;
+	FileSection sections[NUM_SECTIONS];
+};
+
+inline uint64_t AlignFileOffset(uint64_t offset)
+{
+	return (offset + 7) & ~uint64_t(7);
+}
+
+}; // namespace
+
+struct FingerprintIndex::FileDocument {
+	uint32_t id;
+	uint32_t num_items;
+	uint64_t offset;
+	uint32_t size;
+	uint32_t reserved;
+};
+
+FingerprintIndex::FingerprintIndex(int algorithm)
+	: m_algorithm(algorithm)
+{
+	auto config = CreateFingerprinterConfiguration(algorithm);
+	if (config) {
+		m_matcher.reset(new FingerprintMatcher(config));
+	}
+	m_directory.assign(kDirectorySize, 0);
+	m_directory_offsets.assign(kDirectorySize, 0);
+	UpdateView();
+}
+
+FingerprintIndex::~FingerprintIndex()
+{
+}
+
+void FingerprintIndex::UpdateView()
+{
+	m_view = View();
+	m_view.directory = m_directory.data();
+	m_view.directory_offsets = m_directory_offsets.data();
+	m_view.keys = m_keys.data();
+	m_view.key_offsets = m_key_offsets.data();
+	m_view.postings = m_postings.data();
+	m_view.num_keys = m_keys.size();
+	m_view.postings_size = m_postings.size();
+	m_view.num_docs = m_docs.size() - m_num_pending_docs;
+}
+
+bool FingerprintIndex::Add(uint32_t id, const uint32_t *fp, size_t size)
+{
+	if (is_read_only()) {
+		DEBUG("chromaprint::FingerprintIndex::Add() -- Index loaded from a file can't be modified.");
+		return false;
+	}
+
+	const auto doc = uint32_t(m_docs.size());
+	m_docs.push_back({ id, m_fingerprints.size(), size });
+	m_fingerprints.insert(m_fingerprints.end(), fp, fp + size);
+
+	// Only the first occurrence of each key in a fingerprint is indexed.
+	const auto first = m_pending.size();
+	for (size_t i = 0; i < size; i++) {
+		m_pending.push_back({ GetKey(fp[i]), doc, uint32_t(i) });
+	}
+	std::sort(m_pending.begin() + first, m_pending.end());
+	auto last = std::unique(m_pending.begin() + first, m_pending.end(), [](const Posting &a, const Posting &b) {
+		return a.key == b.key;
+	});
+	m_pending.erase(last, m_pending.end());
+	m_num_pending_docs++;
+	return true;
+}
+
+void FingerprintIndex::DecodePostings(std::vector<Posting> &postings) const
+{
+	for (size_t i = 0; i < m_view.num_keys; i++) {
+		const uint8_t *ptr = LookupKey(m_view.keys[i]);
+		const uint32_t count = ReadVarInt(ptr);
+		uint32_t doc = 0;
+		for (uint32_t j = 0; j < count; j++) {
+			doc += ReadVarInt(ptr);
+			const uint32_t pos = ReadVarInt(ptr);
+			postings.push_back({ m_view.keys[i], doc, pos });
+		}
+	}
+}
+
+bool FingerprintIndex::Build()
+{
+	if (is_read_only()) {
+		DEBUG("chromaprint::FingerprintIndex::Build() -- Index loaded from a file can't be modified.");
+		return false;
+	}
+
+	if (m_pending.empty()) {
+		m_num_pending_docs = 0;
+		UpdateView();
+		return true;
+	}
+
+	std::vector<Posting> postings;
+	postings.reserve(m_pending.size() + m_postings.size() / 2);
+	DecodePostings(postings);
+	postings.insert(postings.end(), m_pending.begin(), m_pending.end());
+	std::vector<Posting>().swap(m_pending);
+	std::sort(postings.begin(), postings.end());
+
+	m_keys.clear();
+	m_key_offsets.clear();
+	m_postings.clear();
+	m_directory.assign(kDirectorySize, 0);
+	m_directory_offsets.assign(kDirectorySize, 0);
+
+	auto it = postings.cbegin();
+	while (it != postings.cend()) {
+		const uint32_t key = it->key;
+		auto end = it;
+		while (end != postings.cend() && end->key == key) {
+			++end;
+		}
+		const auto dir = key >> kDirectoryShift;
+		if (m_directory[dir + 1] == 0) {
+			m_directory_offsets[dir] = m_postings.size();
+		}
+		m_keys.push_back(key);
+		m_key_offsets.push_back(uint32_t(m_postings.size() - m_directory_offsets[dir]));
+		m_directory[dir + 1]++;
+		WriteVarInt(m_postings, uint32_t(end - it));
+		uint32_t last_doc = 0;
+		for (; it != end; ++it) {
+			WriteVarInt(m_postings, it->doc - last_doc);
+			WriteVarInt(m_postings, it->pos);
+			last_doc = it->doc;
+		}
+	}
+	for (size_t i = 1; i < kDirectorySize; i++) {
+		m_directory[i] += m_directory[i - 1];
+	}
+
+	m_keys.shrink_to_fit();
+	m_key_offsets.shrink_to_fit();
+	m_postings.shrink_to_fit();
+	m_num_pending_docs = 0;
+	UpdateView();
+	return true;
+}
+
+const uint8_t *FingerprintIndex::LookupKey(uint32_t key) const
+{
+	const auto dir = key >> kDirectoryShift;
+	const auto first = m_view.keys + m_view.directory[dir];
+	const auto last = m_view.keys + m_view.directory[dir + 1];
+	const auto it = std::lower_bound(first, last, key);
+	if (it == last || *it != key) {
+		return nullptr;
+	}
+	return m_view.postings + m_view.directory_offsets[dir] + m_view.key_offsets[it - m_view.keys];
+}
+
+bool FingerprintIndex::GetFingerprint(size_t doc, uint32_t &id, const uint32_t *&data, size_t &size)
+{
+	if (!m_view.file_docs) {
+		const auto &document = m_docs[doc];
+		id = document.id;
+		data = m_fingerprints.data() + document.begin;
+		size = document.size;
+		return true;
+	}
+
+	const auto &document = m_view.file_docs[doc];
+	id = document.id;
+	if (!m_verify) {
+		data = nullptr;
+		size = document.num_items;
+		return true;
+	}
+	const auto compressed = reinterpret_cast<const char *>(m_view.file_fingerprints + document.offset);
+	m_tmp_compressed.assign(compressed, document.size);
+	if (!m_decompressor.Decompress(m_tmp_compressed)) {
+		DEBUG("chromaprint::FingerprintIndex::GetFingerprint() -- Invalid fingerprint in the index file.");
+		return false;
+	}
+	data = m_decompressor.GetOutput().data();
+	size = m_decompressor.GetOutput().size();
+	return true;
+}
+
+bool FingerprintIndex::Search(const uint32_t *query, size_t query_size, size_t max_results, std::vector<FingerprintIndexResult> &results)
+{
+	results.clear();
+	if (m_verify && !m_matcher) {
+		DEBUG("chromaprint::FingerprintIndex::Search() -- Unknown algorithm, can't verify the results.");
+		return false;
+	}
+
+	m_votes.clear();
+	for (size_t i = 0; i < query_size; i++) {
+		const uint8_t *ptr = LookupKey(GetKey(query[i]));
+		if (!ptr) {
+			continue;
+		}
+		const uint32_t count = ReadVarInt(ptr);
+		if (m_max_posting_list_size > 0 && count > m_max_posting_list_size) {
+			continue;
+		}
+		uint32_t doc = 0;
+		for (uint32_t j = 0; j < count; j++) {
+			doc += ReadVarInt(ptr);
+			const uint32_t pos = ReadVarInt(ptr);
+			const uint32_t offset = pos - uint32_t(i);
+			m_votes[(uint64_t(doc) << 32) | offset]++;
+		}
+	}
+
+	// Pick the best offset of each candidate.
+	m_candidates.clear();
+	for (const auto &item : m_votes) {
+		if (item.second >= m_min_votes) {
+			const auto doc = uint32_t(item.first >> 32);
+			const auto offset = int32_t(uint32_t(item.first));
+			m_candidates.push_back({ doc, offset, item.second, -1.0, 0 });
+		}
+	}
+	std::sort(m_candidates.begin(), m_candidates.end(), [](const FingerprintIndexResult &a, const FingerprintIndexResult &b) {
+		if (a.id != b.id) return a.id < b.id;
+		if (a.votes != b.votes) return a.votes > b.votes;
+		return a.offset < b.offset;
+	});
+	m_candidates.erase(std::unique(m_candidates.begin(), m_candidates.end(), [](const FingerprintIndexResult &a, const FingerprintIndexResult &b) {
+		return a.id == b.id;
+	}), m_candidates.end());
+	std::stable_sort(m_candidates.begin(), m_candidates.end(), [](const FingerprintIndexResult &a, const FingerprintIndexResult &b) {
+		return a.votes > b.votes;
+	});
+
+	for (auto &candidate : m_candidates) {
+		if (results.size() >= max_results) {
+			break;
+		}
+		const uint32_t *fp;
+		size_t fp_size;
+		if (!GetFingerprint(candidate.id, candidate.id, fp, fp_size)) {
+			continue;
+		}
+		if (m_verify) {
+			if (!m_matcher->Match(query, query_size, fp, fp_size)) {
+				continue;
+			}
+			const auto &segments = m_matcher->segments();
+			if (segments.empty()) {
+				continue;
+			}
+			double total_score = 0.0;
+			size_t total_duration = 0;
+			for (const auto &segment : segments) {
+				total_score += segment.score * segment.duration;
+				total_duration += segment.duration;
+			}
+			candidate.score = total_score / total_duration;
+			candidate.duration = total_duration;
+		}
+		results.push_back(candidate);
+	}
+
+	// The verified results are ordered by how well they match, the number
+	// of votes only decides between equal scores.
+	if (m_verify) {
+		std::stable_sort(results.begin(), results.end(), [](const FingerprintIndexResult &a, const FingerprintIndexResult &b) {
+			return a.score < b.score;
+		});
+	}
+
+	return true;
+}
+
+bool FingerprintIndex::Save(const std::string &file_name) const
+{
+	if (is_read_only()) {
+		DEBUG("chromaprint::FingerprintIndex::Save() -- Index loaded from a file can't be saved.");
+		return false;
+	}
+
+	const size_t num_docs = m_view.num_docs;
+
+	std::vector<FileDocument> docs(num_docs);
+	std::string fingerprints;
+	{
+		FingerprintCompressor compressor;
+		std::vector<uint32_t> fp;
+		std::string compressed;
+		for (size_t i = 0; i < num_docs; i++) {
+			const auto &doc = m_docs[i];
+			fp.assign(m_fingerprints.begin() + doc.begin, m_fingerprints.begin() + doc.begin + doc.size);
+			compressor.Compress(fp, m_algorithm, compressed);
+			docs[i].id = doc.id;
+			docs[i].num_items = uint32_t(doc.size);
+			docs[i].offset = fingerprints.size();
+			docs[i].size = uint32_t(compressed.size());
+			docs[i].reserved = 0;
+			fingerprints.append(compressed);
+		}
+	}
+
+	const void *section_data[NUM_SECTIONS] = {
+		m_directory.data(),
+		m_directory_offsets.data(),
+		m_keys.data(),
+		m_key_offsets.data(),
+		m_postings.data(),
+		docs.data(),
+		fingerprints.data(),
+	};
+
+	FileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+	header.version = kFileVersion;
+	header.byte_order = kFileByteOrderMark;
+	header.algorithm = uint32_t(m_algorithm);
+	header.key_bits = ACOUSTID_QUERY_BITS;
+	header.num_keys = m_keys.size();
+	header.num_docs = num_docs;
+	header.sections[SECTION_DIRECTORY].size = m_directory.size() * sizeof(uint32_t);
+	header.sections[SECTION_DIRECTORY_OFFSETS].size = m_directory_offsets.size() * sizeof(uint64_t);
+	header.sections[SECTION_KEYS].size = m_keys.size() * sizeof(uint32_t);
+	header.sections[SECTION_KEY_OFFSETS].size = m_key_offsets.size() * sizeof(uint32_t);
+	header.sections[SECTION_POSTINGS].size = m_postings.size();
+	header.sections[SECTION_DOCUMENTS].size = docs.size() * sizeof(FileDocument);
+	header.sections[SECTION_FINGERPRINTS].size = fingerprints.size();
+	uint64_t offset = AlignFileOffset(sizeof(header));
+	for (int i = 0; i < NUM_SECTIONS; i++) {
+		header.sections[i].offset = offset;
+		offset = AlignFileOffset(offset + header.sections[i].size);
+	}
+	header.file_size = offset;
+
+	std::ofstream file(file_name.c_str(), std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+	if (!file) {
+		DEBUG("chromaprint::FingerprintIndex::Save() -- Could not open " << file_name);
+		return false;
+	}
+	const char padding[8] = { 0 };
+	file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	uint64_t written = sizeof(header);
+	for (int i = 0; i < NUM_SECTIONS; i++) {
+		file.write(padding, std::streamsize(header.sections[i].offset - written));
+		file.write(static_cast<const char *>(section_data[i]), std::streamsize(header.sections[i].size));
+		written = header.sections[i].offset + header.sections[i].size;
+	}
+	file.write(padding, std::streamsize(header.file_size - written));
+	file.close();
+	if (!file) {
+		DEBUG("chromaprint::FingerprintIndex::Save() -- Could not write " << file_name);
+		return false;
+	}
+	return true;
+}
+
+bool FingerprintIndex::Load(const std::string &file_name)
+{
+	std::unique_ptr<MappedFile> file(new MappedFile());
+	if (!file->Open(file_name)) {
+		return false;
+	}
+
+	FileHeader header;
+	if (file->size() < sizeof(header)) {
+		DEBUG("chromaprint::FingerprintIndex::Load() -- Invalid index file (too short).");
+		return false;
+	}
+	memcpy(&header, file->data(), sizeof(header));
+	if (memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0) {
+		DEBUG("chromaprint::FingerprintIndex::Load() -- Invalid index file (bad magic).");
+		return false;
+	}
+	if (header.version != kFileVersion) {
+		DEBUG("chromaprint::FingerprintIndex::Load() -- Unsupported index file version " << header.version << ".");
+		return false;
+	}
+	if (header.byte_order != kFileByteOrderMark) {
+		DEBUG("chromaprint::FingerprintIndex::Load() -- Index file was created on a platform with different byte order.");
+		return false;
+	}
+	if (header.key_bits != ACOUSTID_QUERY_BITS || header.file_size != file->size()) {
+		DEBUG("chromaprint::FingerprintIndex::Load() -- Invalid index file (bad header).");
+		return false;
+	}
+
+	const uint64_t expected_sizes[NUM_SECTIONS] = {
+		kDirectorySize * sizeof(uint32_t),
+		kDirectorySize * sizeof(uint64_t),
+		header.num_keys * sizeof(uint32_t),
+		header.num_keys * sizeof(uint32_t),
+		header.sections[SECTION_POSTINGS].size,
+		header.num_docs * sizeof(FileDocument),
+		header.sections[SECTION_FINGERPRINTS].size,
+	};
+	for (int i = 0; i < NUM_SECTIONS; i++) {
+		const auto &section = header.sections[i];
+		if (section.size != expected_sizes[i] || section.offset % 8 != 0 ||
+			section.offset > header.file_size || section.size > header.file_size - section.offset) {
+			DEBUG("chromaprint::FingerprintIndex::Load() -- Invalid index file (bad section " << i << ").");
+			return false;
+		}
+	}
+
+	auto section = [&](int i) {
+		return file->data() + header.sections[i].offset;
+	};
+
+	m_algorithm = int(header.algorithm);
+	auto config = CreateFingerprinterConfiguration(m_algorithm);
+	m_matcher.reset(config ? new FingerprintMatcher(config) : nullptr);
+
+	m_docs.clear();
+	m_fingerprints.clear();
+	m_pending.clear();
+	m_num_pending_docs = 0;
+	m_directory.clear();
+	m_directory_offsets.clear();
+	m_keys.clear();
+	m_key_offsets.clear();
+	m_postings.clear();
+
+	m_view = View();
+	m_view.directory = reinterpret_cast<const uint32_t *>(section(SECTION_DIRECTORY));
+	m_view.directory_offsets = reinterpret_cast<const uint64_t *>(section(SECTION_DIRECTORY_OFFSETS));
+	m_view.keys = reinterpret_cast<const uint32_t *>(section(SECTION_KEYS));
+	m_view.key_offsets = reinterpret_cast<const uint32_t *>(section(SECTION_KEY_OFFSETS));
+	m_view.postings = section(SECTION_POSTINGS);
+	m_view.num_keys = size_t(header.num_keys);
+	m_view.postings_size = size_t(header.sections[SECTION_POSTINGS].size);
+	m_view.num_docs = size_t(header.num_docs);
+	m_view.file_docs = reinterpret_cast<const FileDocument *>(section(SECTION_DOCUMENTS));
+	m_view.file_fingerprints = section(SECTION_FINGERPRINTS);
+	m_file = std::move(file);
+	return true;
+}
+
+size_t FingerprintIndex::memory_usage() const
+{
+	return m_directory.capacity() * sizeof(uint32_t) +
+		m_directory_offsets.capacity() * sizeof(uint64_t) +
+		m_keys.capacity() * sizeof(uint32_t) +
+		m_key_offsets.capacity() * sizeof(uint32_t) +
+		m_postings.capacity() +
+		m_docs.capacity() * sizeof(Document) +
+		m_fingerprints.capacity() * sizeof(uint32_t);
+}
+
+}; // namespace chromaprint
@@ -0,0 +1,197 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_FINGERPRINT_INDEX_H_
+#define CHROMAPRINT_FINGERPRINT_INDEX_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <string>
+#include "utils.h"
+#include "fingerprint_decompressor.h"
+
+namespace chromaprint {
+
+class FingerprintMatcher;
+class MappedFile;
+
+struct FingerprintIndexResult
+{
+	// Id of the indexed fingerprint, as passed to FingerprintIndex::Add().
+	uint32_t id;
+
+	// Position of the start of the query in the indexed fingerprint (in
+	// items), can be negative if the query starts before it.
+	int offset;
+
+	// Number of query items that voted for this offset.
+	uint32_t votes;
+
+	// Average number of differing bits in all segments found by
+	// FingerprintMatcher, weighted by their duration, or -1 if the result
+	// was not verified.
+	double score;
+
+	// Length of the matching segments found by FingerprintMatcher (in items).
+	size_t duration;
+};
+
+/**
+ * In-memory inverted index of raw fingerprints for one-to-many lookups.
+ *
+ * Every distinct sub-fingerprint (the top ACOUSTID_QUERY_BITS bits of an
+ * item) of an indexed fingerprint is stored in a posting list together
+ * with its position. Posting lists are sorted by key and stored as
+ * delta-encoded varints in a single buffer, with a small directory on the
+ * top 16 bits of the key to speed up the lookups. With random data this
+ * takes about 4 bytes per posting plus 8 bytes per distinct key, in
+ * addition to the raw fingerprints kept for verification.
+ *
+ * A search looks up all items of the query, votes on (fingerprint, offset)
+ * pairs and passes the best candidates to FingerprintMatcher to verify
+ * them. Fingerprints added to the index are only searchable after
+ * calling Build().
+ *
+ * A built index can be saved to a file with Save(), and opened later with
+ * Load(). Loading maps the file into memory and searches it in place, so
+ * opening even a large index is instant and processes using the same file
+ * share its memory. Fingerprints are stored compressed in the file and
+ * decompressed when a candidate is verified. Indexes loaded from a file
+ * are read-only. Index files are not fully validated when loaded, only
+ * load files you trust.
+ *
+ * The index is not thread-safe, Search() uses internal scratch buffers.
+ */
+class FingerprintIndex
+{
+public:
+	FingerprintIndex(int algorithm);
+	~FingerprintIndex();
+
+	//! Add a fingerprint to the index, it becomes searchable after the next call to Build().
+	bool Add(uint32_t id, const uint32_t *fp, size_t size);
+	bool Add(uint32_t id, const std::vector<uint32_t> &fp) { return Add(id, fp.data(), fp.size()); }
+
+	//! Merge all fingerprints added since the last call into the searchable index.
+	bool Build();
+
+	//! Write the searchable index to a file.
+	bool Save(const std::string &file_name) const;
+
+	//! Replace the contents of the index with an index file written by Save().
+	bool Load(const std::string &file_name);
+
+	//! Whether the index was loaded from a file.
+	bool is_read_only() const { return m_file != nullptr; }
+
+	/**
+	 * Find indexed fingerprints matching the query.
+	 *
+	 * The candidates with the most votes are returned, at most max_results.
+	 * Verified results are ordered by their score, from the best match,
+	 * otherwise they are ordered by the number of votes.
+	 */
+	bool Search(const uint32_t *query, size_t query_size, size_t max_results, std::vector<FingerprintIndexResult> &results);
+	bool Search(const std::vector<uint32_t> &query, size_t max_results, std::vector<FingerprintIndexResult> &results) {
+		return Search(query.data(), query.size(), max_results, results);
+	}
+
+	// Candidates with fewer votes than this are ignored.
+	void set_min_votes(uint32_t n) { m_min_votes = n; }
+	uint32_t min_votes() const { return m_min_votes; }
+
+	// Posting lists longer than this are ignored when searching, 0 means no
+	// limit. Such sub-fingerprints are usually silence and carry no information.
+	void set_max_posting_list_size(size_t n) { m_max_posting_list_size = n; }
+	size_t max_posting_list_size() const { return m_max_posting_list_size; }
+
+	// Whether the candidates should be verified with FingerprintMatcher. If
+	// enabled, candidates without any matching segment are dropped.
+	void set_verify(bool verify) { m_verify = verify; }
+	bool verify() const { return m_verify; }
+
+	int algorithm() const { return m_algorithm; }
+
+	//! Number of fingerprints in the searchable index.
+	size_t num_fingerprints() const { return m_view.num_docs; }
+
+	//! Approximate memory used by the searchable index (in bytes), not counting mapped files.
+	size_t memory_usage() const;
+
+private:
+	CHROMAPRINT_DISABLE_COPY(FingerprintIndex);
+
+	struct Document {
+		uint32_t id;
+		size_t begin;
+		size_t size;
+	};
+
+	struct Posting {
+		uint32_t key;
+		uint32_t doc;
+		uint32_t pos;
+		bool operator<(const Posting &other) const {
+			if (key != other.key) return key < other.key;
+			if (doc != other.doc) return doc < other.doc;
+			return pos < other.pos;
+		}
+	};
+
+	struct FileDocument;
+
+	// Pointers to the searchable data, either in the vectors below or in
+	// the mapped file.
+	struct View {
+		const uint32_t *directory = nullptr;
+		const uint64_t *directory_offsets = nullptr;
+		const uint32_t *keys = nullptr;
+		const uint32_t *key_offsets = nullptr;
+		const uint8_t *postings = nullptr;
+		size_t num_keys = 0;
+		size_t postings_size = 0;
+		size_t num_docs = 0;
+		const FileDocument *file_docs = nullptr;
+		const uint8_t *file_fingerprints = nullptr;
+	};
+
+	void UpdateView();
+	void DecodePostings(std::vector<Posting> &postings) const;
+	const uint8_t *LookupKey(uint32_t key) const;
+	bool GetFingerprint(size_t doc, uint32_t &id, const uint32_t *&data, size_t &size);
+
+	int m_algorithm;
+	uint32_t m_min_votes = 2;
+	size_t m_max_posting_list_size = 0;
+	bool m_verify = true;
+
+	std::vector<Document> m_docs;
+	std::vector<uint32_t> m_fingerprints;
+	std::vector<Posting> m_pending;
+	size_t m_num_pending_docs = 0;
+
+	// For each value of the top 16 bits of the key, the range of keys in
+	// m_keys and the start of their posting lists in m_postings. Offsets in
+	// m_key_offsets are relative to that, so they fit in 32 bits.
+	std::vector<uint32_t> m_directory;
+	std::vector<uint64_t> m_directory_offsets;
+	std::vector<uint32_t> m_keys;
+	std::vector<uint32_t> m_key_offsets;
+	std::vector<uint8_t> m_postings;
+
+	std::unique_ptr<MappedFile> m_file;
+	View m_view;
+
+	std::unique_ptr<FingerprintMatcher> m_matcher;
+	FingerprintDecompressor m_decompressor;
+	std::string m_tmp_compressed;
+	std::unordered_map<uint64_t, uint32_t> m_votes;
+	std::vector<FingerprintIndexResult> m_candidates;
+};
+
+}; // namespace chromaprint
+
+#endif
@@ -5,23 +5,16 @@
 #include <numeric>
 #include <iostream>
 #include "fingerprint_matcher.h"
+#include "fingerprint_matcher_settings.h"
 #include "fingerprinter_configuration.h"
 #include "utils.h"
 #include "utils/gaussian_filter.h"
 #include "utils/gradient.h"
+#include "utils/bit_errors.h"
 #include "debug.h"
 
 namespace chromaprint {
 
-/* fingerprint matcher settings */
-#define ACOUSTID_MAX_BIT_ERROR 2
-#define ACOUSTID_MAX_ALIGN_OFFSET 120
-#define ACOUSTID_QUERY_START 80
-#define ACOUSTID_QUERY_LENGTH 120
-#define ACOUSTID_QUERY_BITS 28
-#define ACOUSTID_QUERY_MASK (((1<<ACOUSTID_QUERY_BITS)-1)<<(32-ACOUSTID_QUERY_BITS))
-#define ACOUSTID_QUERY_STRIP(x) ((x) & ACOUSTID_QUERY_MASK)
-
 #define ALIGN_BITS 12
 #define ALIGN_MASK ((1 << ALIGN_BITS) - 1)
 #define ALIGN_STRIP(x) ((uint32_t)(x) >> (32 - ALIGN_BITS))
@@ -43,27 +36,13 @@ double FingerprintMatcher::GetHashDuration(size_t i) const {
 	return GetHashTime(i) + m_config->delay_in_seconds();
 }
 
-bool FingerprintMatcher::Match(const std::vector<uint32_t> &fp1, const std::vector<uint32_t> &fp2)
-{
-	return Match(fp1.data(), fp1.size(), fp2.data(), fp2.size());
-}
-
-bool FingerprintMatcher::Match(const uint32_t fp1_data[], size_t fp1_size, const uint32_t fp2_data[], size_t fp2_size)
+void FingerprintMatcher::BuildHistogramSort(const uint32_t fp1_data[], size_t fp1_size, const uint32_t fp2_data[], size_t fp2_size)
 {
 	const uint32_t hash_shift = 32 - ALIGN_BITS;
 	const uint32_t hash_mask = ((1u << ALIGN_BITS) - 1) << hash_shift;
 	const uint32_t offset_mask = (1u << (32 - ALIGN_BITS - 1)) - 1;
 	const uint32_t source_mask = 1u << (32 - ALIGN_BITS - 1);
 
-	if (fp1_size + 1 >= offset_mask) {
-		DEBUG("chromaprint::FingerprintMatcher::Match() -- Fingerprint 1 too long.");
-		return false;
-	}
-	if (fp2_size + 1 >= offset_mask) {
-		DEBUG("chromaprint::FingerprintMatcher::Match() -- Fingerprint 2 too long.");
-		return false;
-	}
-
 	m_offsets.clear();
 	m_offsets.reserve(fp1_size + fp2_size);
 	for (size_t i = 0; i < fp1_size; i++) {
@@ -74,7 +53,6 @@ bool FingerprintMatcher::Match(const uint32_t fp1_data[], size_t fp1_size, const
 	}
 	std::sort(m_offsets.begin(), m_offsets.end());
 
-	m_histogram.assign(fp1_size + fp2_size, 0);
 	for (auto it = m_offsets.cbegin(); it != m_offsets.cend(); ++it) {
 		const uint32_t hash = (*it) & hash_mask;
 		const uint32_t offset1 = (*it) & offset_mask;
@@ -98,6 +76,85 @@ bool FingerprintMatcher::Match(const uint32_t fp1_data[], size_t fp1_size, const
 			}
 		}
 	}
+}
+
+void FingerprintMatcher::BuildHistogramBuckets(const uint32_t fp1_data[], size_t fp1_size, const uint32_t fp2_data[], size_t fp2_size)
+{
+	const size_t num_buckets = 1u << ALIGN_BITS;
+
+	// Counting sort of the positions of both fingerprints by hash prefix.
+	// Buckets [0, num_buckets) hold fp1 and [num_buckets, 2 * num_buckets)
+	// hold fp2, positions within a bucket stay in increasing order. Counts
+	// are shifted by two, so that after the scatter pass bucket i occupies
+	// m_offsets[m_bucket_starts[i], m_bucket_starts[i + 1]).
+	m_bucket_starts.assign(2 * num_buckets + 2, 0);
+	for (size_t i = 0; i < fp1_size; i++) {
+		m_bucket_starts[ALIGN_STRIP(fp1_data[i]) + 2]++;
+	}
+	for (size_t i = 0; i < fp2_size; i++) {
+		m_bucket_starts[num_buckets + ALIGN_STRIP(fp2_data[i]) + 2]++;
+	}
+	for (size_t i = 3; i < m_bucket_starts.size(); i++) {
+		m_bucket_starts[i] += m_bucket_starts[i - 1];
+	}
+
+	m_offsets.resize(fp1_size + fp2_size);
+	for (size_t i = 0; i < fp1_size; i++) {
+		m_offsets[m_bucket_starts[ALIGN_STRIP(fp1_data[i]) + 1]++] = uint32_t(i);
+	}
+	for (size_t i = 0; i < fp2_size; i++) {
+		m_offsets[m_bucket_starts[num_buckets + ALIGN_STRIP(fp2_data[i]) + 1]++] = uint32_t(i);
+	}
+
+	for (size_t hash = 0; hash < num_buckets; hash++) {
+		const uint32_t begin1 = m_bucket_starts[hash];
+		const uint32_t end1 = m_bucket_starts[hash + 1];
+		const uint32_t begin2 = m_bucket_starts[num_buckets + hash];
+		const uint32_t end2 = m_bucket_starts[num_buckets + hash + 1];
+		if (begin1 == end1 || begin2 == end2) {
+			continue;
+		}
+		if (m_max_bucket_size > 0 && (end1 - begin1 > m_max_bucket_size || end2 - begin2 > m_max_bucket_size)) {
+			continue;
+		}
+		for (uint32_t i = begin1; i < end1; i++) {
+			uint32_t *histogram = m_histogram.data() + m_offsets[i] + fp2_size;
+			for (uint32_t j = begin2; j < end2; j++) {
+				histogram[-ptrdiff_t(m_offsets[j])] += 1;
+			}
+		}
+	}
+}
+
+bool FingerprintMatcher::Match(const std::vector<uint32_t> &fp1, const std::vector<uint32_t> &fp2)
+{
+	return Match(fp1.data(), fp1.size(), fp2.data(), fp2.size());
+}
+
+bool FingerprintMatcher::Match(const uint32_t fp1_data[], size_t fp1_size, const uint32_t fp2_data[], size_t fp2_size)
+{
+	const uint32_t offset_mask = (1u << (32 - ALIGN_BITS - 1)) - 1;
+
+	m_segments.clear();
+
+	if (fp1_size + 1 >= offset_mask) {
+		DEBUG("chromaprint::FingerprintMatcher::Match() -- Fingerprint 1 too long.");
+		return false;
+	}
+	if (fp2_size + 1 >= offset_mask) {
+		DEBUG("chromaprint::FingerprintMatcher::Match() -- Fingerprint 2 too long.");
+		return false;
+	}
+
+	m_histogram.assign(fp1_size + fp2_size, 0);
+	switch (m_alignment_method) {
+	case ALIGNMENT_BUCKETS:
+		BuildHistogramBuckets(fp1_data, fp1_size, fp2_data, fp2_size);
+		break;
+	default:
+		BuildHistogramSort(fp1_data, fp1_size, fp2_data, fp2_size);
+		break;
+	}
 
 	m_best_alignments.clear();
 	const auto histogram_size = m_histogram.size();
@@ -113,35 +170,32 @@ bool FingerprintMatcher::Match(const uint32_t fp1_data[], size_t fp1_size, const
 	}
 	std::sort(m_best_alignments.rbegin(), m_best_alignments.rend());
 
-	m_segments.clear();
-
 	for (const auto &item : m_best_alignments) {
 		const int offset_diff = int(item.second - fp2_size);
 
 		const size_t offset1 = offset_diff > 0 ? offset_diff : 0;
 		const size_t offset2 = offset_diff < 0 ? -offset_diff : 0;
 
-		auto it1 = fp1_data + offset1;
-		auto it2 = fp2_data + offset2;
-
 		const auto size = std::min(fp1_size - offset1, fp2_size - offset2);
-		std::vector<float> bit_counts(size);
-		for (size_t i = 0; i < size; i++) {
-			bit_counts[i] = HammingDistance(*it1++, *it2++) + rand() * (0.001f / RAND_MAX);
-		}
+		auto &bit_counts = m_bit_counts;
+		bit_counts.resize(size);
+		ComputeBitErrors(fp1_data + offset1, fp2_data + offset2, size, bit_counts.data());
 
-		std::vector<float> orig_bit_counts = bit_counts;
-		std::vector<float> smoothed_bit_counts;
+		auto &orig_bit_counts = m_orig_bit_counts;
+		orig_bit_counts.assign(bit_counts.begin(), bit_counts.end());
+		auto &smoothed_bit_counts = m_smoothed_bit_counts;
 		GaussianFilter(bit_counts, smoothed_bit_counts, 8.0, 3);
 
-		std::vector<float> gradient(size);
+		auto &gradient = m_gradient;
+		gradient.resize(size);
 		Gradient(smoothed_bit_counts.begin(), smoothed_bit_counts.end(), gradient.begin());
 
 		for (size_t i = 0; i < size; i++) {
 			gradient[i] = std::abs(gradient[i]);
 		}
 
-		std::vector<size_t> gradient_peaks;
+		auto &gradient_peaks = m_gradient_peaks;
+		gradient_peaks.clear();
 		for (size_t i = 0; i < size; i++) {
 			const auto gi = gradient[i];
 			if (i > 0 && i < size - 1 && gi > 0.15 && gi >= gradient[i - 1] && gi >= gradient[i + 1]) {
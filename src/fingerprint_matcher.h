@@ -47,8 +47,28 @@ struct Segment
 class FingerprintMatcher
 {
 public:
+	// How candidate alignments are found.
+	enum AlignmentMethod {
+		// Sort the hashes of both fingerprints and scan runs of equal hashes.
+		ALIGNMENT_SORT,
+		// Counting pass over the 4096 possible hash prefixes, linear in the
+		// fingerprint length.
+		ALIGNMENT_BUCKETS,
+	};
+
 	FingerprintMatcher(FingerprinterConfiguration *config);
 
+	void set_alignment_method(AlignmentMethod method) { m_alignment_method = method; }
+	AlignmentMethod alignment_method() const { return m_alignment_method; }
+
+	// Hash buckets with more entries than this in either fingerprint are
+	// ignored when looking for alignments, 0 means no limit. Such buckets
+	// usually come from silence or other steady sounds, they carry no
+	// information about the alignment and make the search quadratic.
+	// Only used by ALIGNMENT_BUCKETS.
+	void set_max_bucket_size(size_t n) { m_max_bucket_size = n; }
+	size_t max_bucket_size() const { return m_max_bucket_size; }
+
 	// Anything above this is not considered a match.
 	void set_match_threshold(double t) { m_match_threshold = t; }
 	double match_threshold() const { return m_match_threshold; }
@@ -62,11 +82,28 @@ public:
 
 	const std::vector<Segment> &segments() const { return m_segments; };
 
+	//! Forget the segments found by the last Match().
+	void ClearSegments() { m_segments.clear(); }
+
+	// Number of matching hashes for each offset difference, indexed by offset1 - offset2 + fp2_size.
+	const std::vector<uint32_t> &histogram() const { return m_histogram; }
+
 private:
+	void BuildHistogramSort(const uint32_t fp1_data[], size_t fp1_size, const uint32_t fp2_data[], size_t fp2_size);
+	void BuildHistogramBuckets(const uint32_t fp1_data[], size_t fp1_size, const uint32_t fp2_data[], size_t fp2_size);
+
 	std::unique_ptr<FingerprinterConfiguration> m_config;
+	AlignmentMethod m_alignment_method = ALIGNMENT_SORT;
+	size_t m_max_bucket_size = 0;
 	std::vector<uint32_t> m_offsets;
+	std::vector<uint32_t> m_bucket_starts;
 	std::vector<uint32_t> m_histogram;
 	std::vector<std::pair<uint32_t, uint32_t>> m_best_alignments;
+	std::vector<float> m_bit_counts;
+	std::vector<float> m_orig_bit_counts;
+	std::vector<float> m_smoothed_bit_counts;
+	std::vector<float> m_gradient;
+	std::vector<size_t> m_gradient_peaks;
 	std::vector<Segment> m_segments;
 	double m_match_threshold = kDefaultMatchThreshold;
 };
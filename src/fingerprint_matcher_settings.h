@@ -0,0 +1,16 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_FINGERPRINT_MATCHER_SETTINGS_H_
+#define CHROMAPRINT_FINGERPRINT_MATCHER_SETTINGS_H_
+
+/* fingerprint matcher settings */
+#define ACOUSTID_MAX_BIT_ERROR 2
+#define ACOUSTID_MAX_ALIGN_OFFSET 120
+#define ACOUSTID_QUERY_START 80
+#define ACOUSTID_QUERY_LENGTH 120
+#define ACOUSTID_QUERY_BITS 28
+#define ACOUSTID_QUERY_MASK (((1u<<ACOUSTID_QUERY_BITS)-1)<<(32-ACOUSTID_QUERY_BITS))
+#define ACOUSTID_QUERY_STRIP(x) ((x) & ACOUSTID_QUERY_MASK)
+
+#endif
@@ -0,0 +1,64 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_FINGERPRINT_PIPELINE_H_
+#define CHROMAPRINT_FINGERPRINT_PIPELINE_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fft.h"
+#include "chroma.h"
+#include "chroma_filter.h"
+#include "chroma_normalizer.h"
+#include "fingerprint_calculator.h"
+
+namespace chromaprint {
+
+/**
+ * Stages of the fingerprinting pipeline from the FFT to the fingerprint
+ * calculator, connected through the virtual consumer interfaces, so that
+ * any consumer can be inserted between them.
+ */
+template <typename T>
+struct DynamicFingerprintPipeline
+{
+	typedef BasicFingerprintCalculator<T> FingerprintCalculator;
+	typedef BasicChromaNormalizer<T> ChromaNormalizer;
+	typedef BasicChromaFilter<T> ChromaFilter;
+	typedef BasicChroma<T> Chroma;
+	typedef BasicFFT<T> FFT;
+};
+
+/**
+ * Stages of the fingerprinting pipeline with every stage knowing the exact
+ * type of the next one. The calls from Chroma to FingerprintCalculator are
+ * not virtual and the compiler can inline them into one loop per frame.
+ *
+ * All the algorithms use the same chain of stages, they only differ in the
+ * parameters from FingerprinterConfiguration, which are not part of the
+ * types.
+ */
+template <typename T>
+struct StaticFingerprintPipeline
+{
+	typedef BasicFingerprintCalculator<T> FingerprintCalculator;
+	typedef BasicChromaNormalizer<T, FingerprintCalculator> ChromaNormalizer;
+	typedef BasicChromaFilter<T, ChromaNormalizer> ChromaFilter;
+	typedef BasicChroma<T, ChromaFilter> Chroma;
+	typedef BasicFFT<T, Chroma> FFT;
+};
+
+#if ENABLE_STATS
+// The statistics are collected by proxies inserted between the stages.
+template <typename T>
+using DefaultFingerprintPipeline = DynamicFingerprintPipeline<T>;
+#else
+template <typename T>
+using DefaultFingerprintPipeline = StaticFingerprintPipeline<T>;
+#endif
+
+}; // namespace chromaprint
+
+#endif
@@ -0,0 +1,70 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <algorithm>
+#include <cassert>
+#include "fingerprint_window.h"
+
+namespace chromaprint {
+
+FingerprintWindow::FingerprintWindow(size_t size, size_t step, FingerprintConsumer *consumer)
+	: m_ring(size), m_step(step), m_consumer(consumer)
+{
+	assert(size > 0);
+	Reset();
+}
+
+void FingerprintWindow::Reset()
+{
+	m_num_items = 0;
+	m_end = 0;
+	m_next_emit = m_ring.size();
+	m_window.clear();
+}
+
+void FingerprintWindow::ClearFingerprint()
+{
+	m_num_items = 0;
+	m_next_emit = m_end + m_ring.size();
+}
+
+void FingerprintWindow::Consume(const uint32_t *fingerprint, size_t size, size_t offset)
+{
+	if (offset != m_end) {
+		// there is a gap, or the stream was restarted
+		m_num_items = 0;
+		m_end = offset;
+		m_next_emit = offset + m_ring.size();
+	}
+	const size_t capacity = m_ring.size();
+	for (size_t i = 0; i < size; i++) {
+		m_ring[m_end % capacity] = fingerprint[i];
+		m_end++;
+		m_num_items = std::min(m_num_items + 1, capacity);
+		if (m_end == m_next_emit) {
+			if (m_step > 0 && m_consumer) {
+				Emit();
+			}
+			m_next_emit += m_step > 0 ? m_step : capacity;
+		}
+	}
+}
+
+const Vector<uint32_t> &FingerprintWindow::GetFingerprint()
+{
+	const size_t capacity = m_ring.size();
+	const size_t begin = (m_end - m_num_items) % capacity;
+	m_window.resize(m_num_items);
+	const size_t first_part = std::min(m_num_items, capacity - begin);
+	std::copy(m_ring.begin() + begin, m_ring.begin() + begin + first_part, m_window.begin());
+	std::copy(m_ring.begin(), m_ring.begin() + (m_num_items - first_part), m_window.begin() + first_part);
+	return m_window;
+}
+
+void FingerprintWindow::Emit()
+{
+	const auto &window = GetFingerprint();
+	m_consumer->Consume(window.data(), window.size(), offset());
+}
+
+}; // namespace chromaprint
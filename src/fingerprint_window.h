@@ -0,0 +1,59 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_FINGERPRINT_WINDOW_H_
+#define CHROMAPRINT_FINGERPRINT_WINDOW_H_
+
+#include <cstdint>
+#include <vector>
+#include "fingerprint_consumer.h"
+
+namespace chromaprint {
+
+/**
+ * Keeps only the last items of a fingerprint, in a fixed-size ring buffer.
+ *
+ * Optionally, every time the window moves by the given step, the whole
+ * window is passed to another consumer. The windows overlap if the step is
+ * smaller than the window size. The memory usage doesn't depend on the
+ * length of the stream.
+ */
+class FingerprintWindow : public FingerprintConsumer {
+public:
+	FingerprintWindow(size_t size, size_t step = 0, FingerprintConsumer *consumer = nullptr);
+
+	virtual void Consume(const uint32_t *fingerprint, size_t size, size_t offset) override;
+
+	//! Get the items currently in the window, oldest first.
+	const Vector<uint32_t> &GetFingerprint();
+
+	//! Position of the first item of the window in the whole fingerprint.
+	size_t offset() const { return m_end - m_num_items; }
+
+	//! Remove all items from the window.
+	void ClearFingerprint();
+
+	//! Reset all internal state.
+	void Reset();
+
+	size_t size() const { return m_ring.size(); }
+	size_t step() const { return m_step; }
+
+	FingerprintConsumer *consumer() const { return m_consumer; }
+	void set_consumer(FingerprintConsumer *consumer) { m_consumer = consumer; }
+
+private:
+	void Emit();
+
+	Vector<uint32_t> m_ring;
+	size_t m_step;
+	FingerprintConsumer *m_consumer;
+	size_t m_num_items = 0;
+	size_t m_end = 0;
+	size_t m_next_emit = 0;
+	Vector<uint32_t> m_window;
+};
+
+}; // namespace chromaprint
+
+#endif
@@ -10,54 +10,67 @@
 #include "audio_processor.h"
 #include "image_builder.h"
 #include "silence_remover.h"
+#include "sharded_feature_extractor.h"
 #include "fingerprint_calculator.h"
 #include "fingerprinter_configuration.h"
 #include "classifier.h"
+#include "pipeline_stats.h"
 #include "utils.h"
 #include "debug.h"
 
 namespace chromaprint {
 
-static const int MIN_FREQ = 28;
-static const int MAX_FREQ = 3520;
-
-Fingerprinter::Fingerprinter(FingerprinterConfiguration *config) {
+template <typename T, typename Pipeline>
+BasicFingerprinter<T, Pipeline>::BasicFingerprinter(FingerprinterConfiguration *config) {
 	if (!config) {
 		config = new FingerprinterConfigurationTest1();
 	}
-	m_fingerprint_calculator = new FingerprintCalculator(config->classifiers(), config->num_classifiers());
-	m_chroma_normalizer = new ChromaNormalizer(m_fingerprint_calculator);
-	m_chroma_filter = new ChromaFilter(config->filter_coefficients(), config->num_filter_coefficients(), m_chroma_normalizer);
-	m_chroma = new Chroma(MIN_FREQ, MAX_FREQ, config->frame_size(), config->sample_rate(), m_chroma_filter);
+	m_stats = new PipelineStats();
+	m_fingerprint_calculator = new typename Pipeline::FingerprintCalculator(config->classifiers(), config->num_classifiers());
+	m_chroma_normalizer = new typename Pipeline::ChromaNormalizer(m_stats->Wrap(CHROMAPRINT_STAGE_FINGERPRINT_CALCULATOR, m_fingerprint_calculator));
+	m_chroma_filter = new typename Pipeline::ChromaFilter(config->filter_coefficients(), config->num_filter_coefficients(), m_stats->Wrap(CHROMAPRINT_STAGE_CHROMA_NORMALIZER, m_chroma_normalizer));
+	m_chroma = new typename Pipeline::Chroma(CHROMA_MIN_FREQ, CHROMA_MAX_FREQ, config->frame_size(), config->sample_rate(), m_stats->Wrap(CHROMAPRINT_STAGE_CHROMA_FILTER, m_chroma_filter));
 	//m_chroma->set_interpolate(true);
-	m_fft = new FFT(config->frame_size(), config->frame_overlap(), m_chroma);
+	m_chroma->set_block_size(FEATURE_BLOCK_SIZE);
+#if ENABLE_STATS
+	// Keep the FFT and chroma stages separate, so that they can be measured individually.
+	m_fft = new typename Pipeline::FFT(config->frame_size(), config->frame_overlap(), m_stats->Wrap(CHROMAPRINT_STAGE_CHROMA, m_chroma));
+#else
+	m_fft = new typename Pipeline::FFT(config->frame_size(), config->frame_overlap(), m_chroma);
+#endif
+	m_fft_input = m_stats->Wrap(CHROMAPRINT_STAGE_FFT, m_fft);
+	m_sharded_extractor = 0;
 	if (config->remove_silence()) {
-		m_silence_remover = new SilenceRemover(m_fft);
+		m_silence_remover = new SilenceRemover(m_fft_input);
 		m_silence_remover->set_threshold(config->silence_threshold());
-		m_audio_processor = new AudioProcessor(config->sample_rate(), m_silence_remover);
+		m_audio_processor = new AudioProcessor(config->sample_rate(), m_stats->Wrap(CHROMAPRINT_STAGE_SILENCE_REMOVER, m_silence_remover));
 	}
 	else {
 		m_silence_remover = 0;
-		m_audio_processor = new AudioProcessor(config->sample_rate(), m_fft);
+		m_audio_processor = new AudioProcessor(config->sample_rate(), m_fft_input);
 	}
 	m_config = config;
 }
 
-Fingerprinter::~Fingerprinter()
+template <typename T, typename Pipeline>
+BasicFingerprinter<T, Pipeline>::~BasicFingerprinter()
 {
 	delete m_audio_processor;
 	if (m_silence_remover) {
 		delete m_silence_remover;
 	}
+	delete m_sharded_extractor;
 	delete m_fft;
 	delete m_chroma;
 	delete m_chroma_filter;
 	delete m_chroma_normalizer;
 	delete m_fingerprint_calculator;
 	delete m_config;
+	delete m_stats;
 }
 
-bool Fingerprinter::SetOption(const char *name, int value)
+template <typename T, typename Pipeline>
+bool BasicFingerprinter<T, Pipeline>::SetOption(const char *name, int value)
 {
 	if (!strcmp(name, "silence_threshold")) {
 		if (m_silence_remover) {
@@ -65,40 +78,143 @@ bool Fingerprinter::SetOption(const char *name, int value)
 			return true;
 		}
 	}
+	if (!strcmp(name, "resampler")) {
+		if (value != CHROMAPRINT_RESAMPLER_AVRESAMPLE && value != CHROMAPRINT_RESAMPLER_POLYPHASE) {
+			return false;
+		}
+		m_audio_processor->set_resampler(ChromaprintResampler(value));
+		return true;
+	}
+	if (!strcmp(name, "num_threads")) {
+		if (value < 0) {
+			return false;
+		}
+		delete m_sharded_extractor;
+		m_sharded_extractor = 0;
+		AudioConsumer *consumer = m_fft_input;
+		if (value != 1) {
+			m_sharded_extractor = new BasicShardedFeatureExtractor<T>(m_config, value, m_stats->Wrap(CHROMAPRINT_STAGE_FINGERPRINT_CALCULATOR, m_fingerprint_calculator));
+			m_sharded_extractor->set_low_latency(m_fingerprint_calculator->consumer() != nullptr);
+			consumer = m_sharded_extractor;
+		}
+		if (m_silence_remover) {
+			m_silence_remover->set_consumer(consumer);
+		} else {
+			m_audio_processor->set_consumer(consumer);
+		}
+		return true;
+	}
 	return false;
 }
 
-bool Fingerprinter::Start(int sample_rate, int num_channels)
+template <typename T, typename Pipeline>
+bool BasicFingerprinter<T, Pipeline>::Start(int sample_rate, int num_channels)
 {
 	if (!m_audio_processor->Reset(sample_rate, num_channels)) {
 		// FIXME save error message somewhere
 		return false;
 	}
+	if (m_silence_remover) {
+		m_silence_remover->Reset(m_config->sample_rate(), 1);
+	}
 	m_fft->Reset();
 	m_chroma->Reset();
 	m_chroma_filter->Reset();
 	m_chroma_normalizer->Reset();
 	m_fingerprint_calculator->Reset();
+	if (m_sharded_extractor) {
+		m_sharded_extractor->Reset();
+	}
 	return true;
 }
 
-void Fingerprinter::Consume(const int16_t *samples, int length)
+template <typename T, typename Pipeline>
+void BasicFingerprinter<T, Pipeline>::Consume(const int16_t *samples, int length)
 {
 	assert(length >= 0);
+	PipelineStats::Timer timer(m_stats, CHROMAPRINT_STAGE_AUDIO_PROCESSOR, length);
 	m_audio_processor->Consume(samples, length);
 }
 
-void Fingerprinter::Finish()
+template <typename T, typename Pipeline>
+void BasicFingerprinter<T, Pipeline>::Consume(const int32_t *samples, int length)
 {
+	assert(length >= 0);
+	PipelineStats::Timer timer(m_stats, CHROMAPRINT_STAGE_AUDIO_PROCESSOR, length);
+	m_audio_processor->Consume(samples, length);
+}
+
+template <typename T, typename Pipeline>
+void BasicFingerprinter<T, Pipeline>::Consume(const float *samples, int length)
+{
+	assert(length >= 0);
+	PipelineStats::Timer timer(m_stats, CHROMAPRINT_STAGE_AUDIO_PROCESSOR, length);
+	m_audio_processor->Consume(samples, length);
+}
+
+template <typename T, typename Pipeline>
+void BasicFingerprinter<T, Pipeline>::ConsumePlanar(const int16_t *const *samples, int length)
+{
+	assert(length >= 0);
+	PipelineStats::Timer timer(m_stats, CHROMAPRINT_STAGE_AUDIO_PROCESSOR, length * m_audio_processor->num_channels());
+	m_audio_processor->ConsumePlanar(samples, length);
+}
+
+template <typename T, typename Pipeline>
+void BasicFingerprinter<T, Pipeline>::ConsumePlanar(const float *const *samples, int length)
+{
+	assert(length >= 0);
+	PipelineStats::Timer timer(m_stats, CHROMAPRINT_STAGE_AUDIO_PROCESSOR, length * m_audio_processor->num_channels());
+	m_audio_processor->ConsumePlanar(samples, length);
+}
+
+template <typename T, typename Pipeline>
+void BasicFingerprinter<T, Pipeline>::Finish()
+{
+	PipelineStats::Timer timer(m_stats, CHROMAPRINT_STAGE_AUDIO_PROCESSOR, 0);
 	m_audio_processor->Flush();
+	if (m_sharded_extractor) {
+		m_sharded_extractor->Flush();
+	}
+	m_chroma->Flush();
+}
+
+template <typename T, typename Pipeline>
+void BasicFingerprinter<T, Pipeline>::Flush() {
+	if (m_sharded_extractor) {
+		m_sharded_extractor->Flush();
+	}
+	m_chroma->Flush();
 }
 
-const std::vector<uint32_t> &Fingerprinter::GetFingerprint() const {
+template <typename T, typename Pipeline>
+const Vector<uint32_t> &BasicFingerprinter<T, Pipeline>::GetFingerprint() {
+	Flush();
 	return m_fingerprint_calculator->GetFingerprint();
 }
 
-void Fingerprinter::ClearFingerprint() {
+template <typename T, typename Pipeline>
+void BasicFingerprinter<T, Pipeline>::ClearFingerprint() {
+	// Items from audio that was already consumed must be cleared as well.
+	Flush();
 	m_fingerprint_calculator->ClearFingerprint();
 }
 
+template <typename T, typename Pipeline>
+void BasicFingerprinter<T, Pipeline>::SetFingerprintConsumer(FingerprintConsumer *consumer) {
+	// The consumer expects the items as soon as the audio is available, don't collect blocks.
+	m_chroma->set_block_size(consumer ? 1 : FEATURE_BLOCK_SIZE);
+	if (m_sharded_extractor) {
+		m_sharded_extractor->set_low_latency(consumer != nullptr);
+	}
+	m_fingerprint_calculator->set_consumer(consumer);
+}
+
+template class BasicFingerprinter<float, DynamicFingerprintPipeline<float>>;
+template class BasicFingerprinter<double, DynamicFingerprintPipeline<double>>;
+#if !ENABLE_STATS
+template class BasicFingerprinter<float, StaticFingerprintPipeline<float>>;
+template class BasicFingerprinter<double, StaticFingerprintPipeline<double>>;
+#endif
+
 }; // namespace chromaprint
@@ -4,26 +4,41 @@
 #ifndef CHROMAPRINT_FINGERPRINTER_H_
 #define CHROMAPRINT_FINGERPRINTER_H_
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <stdint.h>
 #include <vector>
 #include "audio_consumer.h"
+#include "fingerprint_pipeline.h"
 
 namespace chromaprint {
 
-class FFT;
-class Chroma;
-class ChromaNormalizer;
-class ChromaFilter;
 class AudioProcessor;
-class FingerprintCalculator;
+class FingerprintConsumer;
 class FingerprinterConfiguration;
 class SilenceRemover;
+class PipelineStats;
+template <typename T> class BasicShardedFeatureExtractor;
 
-class Fingerprinter : public AudioConsumer
+/**
+ * Calculates fingerprints from audio data.
+ *
+ * T is the type used for the spectrum and chroma features. The integral
+ * image used by the classifiers is always in double precision, so the float
+ * pipeline only differs from the double one by the rounding of the features,
+ * which can occasionally flip a bit of the fingerprint.
+ *
+ * Pipeline defines the types of the stages, see StaticFingerprintPipeline
+ * and DynamicFingerprintPipeline.
+ */
+template <typename T, typename Pipeline = DefaultFingerprintPipeline<T>>
+class BasicFingerprinter : public AudioConsumer
 {
 public:
-	Fingerprinter(FingerprinterConfiguration *config = 0);
-	~Fingerprinter();
+	BasicFingerprinter(FingerprinterConfiguration *config = 0);
+	~BasicFingerprinter();
 
 	/**
 	 * Initialize the fingerprinting process.
@@ -36,32 +51,83 @@ public:
 	 */
 	void Consume(const int16_t *input, int length);
 
+	/**
+	 * Process a block of 32-bit integer or floating point audio data, see
+	 * AudioProcessor::Consume().
+	 */
+	void Consume(const int32_t *input, int length);
+	void Consume(const float *input, int length);
+
+	/**
+	 * Process a block of planar audio data, with one array per channel.
+	 */
+	void ConsumePlanar(const int16_t *const *input, int length);
+	void ConsumePlanar(const float *const *input, int length);
+
 	/**
 	 * Calculate the fingerprint based on the provided audio data.
 	 */
 	void Finish();
 
-	//! Get the fingerprint generate from data up to this point.
-	const std::vector<uint32_t> &GetFingerprint() const;
+	/**
+	 * Process the features that are buffered between the stages, without
+	 * ending the stream. Only the few frames the filters need to see the
+	 * next audio are kept.
+	 */
+	void Flush();
+
+	/**
+	 * Get the fingerprint generate from data up to this point, see Flush().
+	 */
+	const Vector<uint32_t> &GetFingerprint();
 
 	//! Clear the generated fingerprint, but allow more audio to be processed.
 	void ClearFingerprint();
 
+	//! Deliver new fingerprint items to the consumer instead of accumulating them, see FingerprintCalculator::set_consumer().
+	void SetFingerprintConsumer(FingerprintConsumer *consumer);
+
+	/**
+	 * Set an option of the fingerprinting process:
+	 *
+	 *  - silence_threshold: threshold for detecting silence, only for
+	 *    configurations that remove silence
+	 *  - num_threads: calculate the features on multiple threads, 0 means
+	 *    one per CPU core and 1 disables it, see BasicShardedFeatureExtractor.
+	 *    The fingerprint is exactly the same, but a minute or more of audio
+	 *    is buffered for each thread before it is processed, or a few
+	 *    seconds while a fingerprint consumer is set. Must be set before
+	 *    Start().
+	 *  - resampler: ChromaprintResampler used by the audio processor, must
+	 *    be set before Start().
+	 */
 	bool SetOption(const char *name, int value);
 
 	const FingerprinterConfiguration *config() { return m_config; }
 
+	//! Time spent in the individual stages, only collected if built with ENABLE_STATS.
+	PipelineStats *stats() { return m_stats; }
+
 private:
-	Chroma *m_chroma;
-	ChromaNormalizer *m_chroma_normalizer;
-	ChromaFilter *m_chroma_filter;
-	FFT *m_fft;
+	typename Pipeline::Chroma *m_chroma;
+	typename Pipeline::ChromaNormalizer *m_chroma_normalizer;
+	typename Pipeline::ChromaFilter *m_chroma_filter;
+	typename Pipeline::FFT *m_fft;
 	AudioProcessor *m_audio_processor;
-	FingerprintCalculator *m_fingerprint_calculator;
+	typename Pipeline::FingerprintCalculator *m_fingerprint_calculator;
+	BasicShardedFeatureExtractor<T> *m_sharded_extractor;
+	AudioConsumer *m_fft_input;
 	FingerprinterConfiguration *m_config;
 	SilenceRemover *m_silence_remover;
+	PipelineStats *m_stats;
 };
 
+#if USE_FLOAT_FEATURES
+typedef BasicFingerprinter<float> Fingerprinter;
+#else
+typedef BasicFingerprinter<double> Fingerprinter;
+#endif
+
 }; // namespace chromaprint
 
 #endif
@@ -12,6 +12,10 @@ namespace chromaprint {
 
 static const int DEFAULT_SAMPLE_RATE = 11025;
 
+// Frequency range of the chroma features, the same for all algorithms.
+static const int CHROMA_MIN_FREQ = 28;
+static const int CHROMA_MAX_FREQ = 3520;
+
 class FingerprinterConfiguration
 {
 public:	
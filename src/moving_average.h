@@ -5,6 +5,7 @@
 #define CHROMAPRINT_MOVING_AVERAGE_H_
 
 #include <vector>
+#include <algorithm>
 
 namespace chromaprint {
 
@@ -15,6 +16,14 @@ public:
 	MovingAverage(int size)
 		: m_buffer(size), m_size(size), m_offset(0), m_sum(0), m_count(0) {}
 
+	void Reset()
+	{
+		std::fill(m_buffer.begin(), m_buffer.end(), T(0));
+		m_offset = 0;
+		m_sum = 0;
+		m_count = 0;
+	}
+
 	void AddValue(const T &x)
 	{
 		m_sum += x;
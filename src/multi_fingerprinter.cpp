@@ -0,0 +1,267 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <cassert>
+#include "multi_fingerprinter.h"
+#include "audio_processor.h"
+#include "silence_remover.h"
+#include "fft.h"
+#include "chroma.h"
+#include "chroma_filter.h"
+#include "chroma_normalizer.h"
+#include "fingerprint_calculator.h"
+#include "fingerprinter_configuration.h"
+#include "debug.h"
+
+namespace chromaprint {
+
+template <typename T>
+struct BasicMultiFingerprinter<T>::AudioSplitter : public AudioConsumer
+{
+	void Consume(const int16_t *input, int length) override {
+		for (auto consumer : consumers) {
+			consumer->Consume(input, length);
+		}
+	}
+
+	void ConsumeFloat(const float *input, int length) override {
+		for (auto consumer : consumers) {
+			consumer->ConsumeFloat(input, length);
+		}
+	}
+
+	std::vector<AudioConsumer *> consumers;
+};
+
+// Consumers are allowed to modify the features, all but the last one get a copy.
+template <typename T>
+struct BasicMultiFingerprinter<T>::FeatureSplitter : public BasicFeatureVectorConsumer<T>
+{
+	void Consume(std::vector<T> &features) override {
+		for (size_t i = 0; i + 1 < consumers.size(); i++) {
+			row = features;
+			consumers[i]->Consume(row);
+		}
+		consumers.back()->Consume(features);
+	}
+
+	void ConsumeBlock(T *features, size_t num_rows, size_t num_columns) override {
+		for (size_t i = 0; i + 1 < consumers.size(); i++) {
+			copy.assign(features, features + num_rows * num_columns);
+			consumers[i]->ConsumeBlock(copy.data(), num_rows, num_columns);
+		}
+		consumers.back()->ConsumeBlock(features, num_rows, num_columns);
+	}
+
+	std::vector<BasicFeatureVectorConsumer<T> *> consumers;
+	Vector<T> copy;
+	std::vector<T> row;
+};
+
+template <typename T>
+struct BasicMultiFingerprinter<T>::SilenceStage : public Allocated
+{
+	SilenceStage(const FingerprinterConfiguration *config) : config(config) {
+		if (config->remove_silence()) {
+			silence_remover.reset(new SilenceRemover(&splitter, config->silence_threshold()));
+		}
+	}
+
+	bool Matches(const FingerprinterConfiguration *other) const {
+		if (config->remove_silence() != other->remove_silence()) {
+			return false;
+		}
+		return !config->remove_silence() || config->silence_threshold() == other->silence_threshold();
+	}
+
+	AudioConsumer *input() {
+		if (silence_remover) {
+			return silence_remover.get();
+		}
+		return &splitter;
+	}
+
+	const FingerprinterConfiguration *config;
+	AudioSplitter splitter;
+	std::unique_ptr<SilenceRemover> silence_remover;
+};
+
+template <typename T>
+struct BasicMultiFingerprinter<T>::FrameStage : public Allocated
+{
+	FrameStage(const FingerprinterConfiguration *config, SilenceStage *input)
+		: config(config),
+		  input(input),
+		  chroma(CHROMA_MIN_FREQ, CHROMA_MAX_FREQ, config->frame_size(), config->sample_rate(), &splitter),
+		  fft(config->frame_size(), config->frame_overlap(), &chroma)
+	{
+		chroma.set_block_size(FEATURE_BLOCK_SIZE);
+	}
+
+	bool Matches(const FingerprinterConfiguration *other, SilenceStage *other_input) const {
+		return input == other_input &&
+			config->frame_size() == other->frame_size() &&
+			config->frame_overlap() == other->frame_overlap();
+	}
+
+	const FingerprinterConfiguration *config;
+	SilenceStage *input;
+	FeatureSplitter splitter;
+	BasicChroma<T> chroma;
+	BasicFFT<T> fft;
+};
+
+template <typename T>
+struct BasicMultiFingerprinter<T>::FilterStage : public Allocated
+{
+	FilterStage(const FingerprinterConfiguration *config, FrameStage *input)
+		: config(config),
+		  input(input),
+		  normalizer(&splitter),
+		  filter(config->filter_coefficients(), config->num_filter_coefficients(), &normalizer)
+	{
+	}
+
+	bool Matches(const FingerprinterConfiguration *other, FrameStage *other_input) const {
+		if (input != other_input || config->num_filter_coefficients() != other->num_filter_coefficients()) {
+			return false;
+		}
+		for (int i = 0; i < config->num_filter_coefficients(); i++) {
+			if (config->filter_coefficients()[i] != other->filter_coefficients()[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	const FingerprinterConfiguration *config;
+	FrameStage *input;
+	FeatureSplitter splitter;
+	BasicChromaNormalizer<T> normalizer;
+	BasicChromaFilter<T> filter;
+};
+
+template <typename T>
+BasicMultiFingerprinter<T>::BasicMultiFingerprinter(const int *algorithms, size_t num_algorithms)
+	: m_splitter(new AudioSplitter())
+{
+	for (size_t i = 0; i < num_algorithms; i++) {
+		FingerprinterConfiguration *config = CreateFingerprinterConfiguration(algorithms[i]);
+		if (!config) {
+			config = new FingerprinterConfigurationTest1();
+		}
+		// all configurations use the same sample rate, so the audio is only resampled once
+		assert(config->sample_rate() == DEFAULT_SAMPLE_RATE);
+		m_configs.emplace_back(config);
+
+		auto filter_stage = GetFilterStage(config);
+		m_calculators.emplace_back(new BasicFingerprintCalculator<T>(config->classifiers(), config->num_classifiers()));
+		filter_stage->splitter.consumers.push_back(m_calculators.back().get());
+	}
+	m_audio_processor.reset(new AudioProcessor(DEFAULT_SAMPLE_RATE, m_splitter.get()));
+}
+
+template <typename T>
+BasicMultiFingerprinter<T>::~BasicMultiFingerprinter()
+{
+}
+
+template <typename T>
+typename BasicMultiFingerprinter<T>::SilenceStage *BasicMultiFingerprinter<T>::GetSilenceStage(const FingerprinterConfiguration *config)
+{
+	for (const auto &stage : m_silence_stages) {
+		if (stage->Matches(config)) {
+			return stage.get();
+		}
+	}
+	m_silence_stages.emplace_back(new SilenceStage(config));
+	m_splitter->consumers.push_back(m_silence_stages.back()->input());
+	return m_silence_stages.back().get();
+}
+
+template <typename T>
+typename BasicMultiFingerprinter<T>::FrameStage *BasicMultiFingerprinter<T>::GetFrameStage(const FingerprinterConfiguration *config)
+{
+	auto input = GetSilenceStage(config);
+	for (const auto &stage : m_frame_stages) {
+		if (stage->Matches(config, input)) {
+			return stage.get();
+		}
+	}
+	m_frame_stages.emplace_back(new FrameStage(config, input));
+	input->splitter.consumers.push_back(&m_frame_stages.back()->fft);
+	return m_frame_stages.back().get();
+}
+
+template <typename T>
+typename BasicMultiFingerprinter<T>::FilterStage *BasicMultiFingerprinter<T>::GetFilterStage(const FingerprinterConfiguration *config)
+{
+	auto input = GetFrameStage(config);
+	for (const auto &stage : m_filter_stages) {
+		if (stage->Matches(config, input)) {
+			return stage.get();
+		}
+	}
+	m_filter_stages.emplace_back(new FilterStage(config, input));
+	input->splitter.consumers.push_back(&m_filter_stages.back()->filter);
+	return m_filter_stages.back().get();
+}
+
+template <typename T>
+bool BasicMultiFingerprinter<T>::Start(int sample_rate, int num_channels)
+{
+	if (!m_audio_processor->Reset(sample_rate, num_channels)) {
+		return false;
+	}
+	for (const auto &stage : m_silence_stages) {
+		if (stage->silence_remover) {
+			stage->silence_remover->Reset(DEFAULT_SAMPLE_RATE, 1);
+		}
+	}
+	for (const auto &stage : m_frame_stages) {
+		stage->fft.Reset();
+		stage->chroma.Reset();
+	}
+	for (const auto &stage : m_filter_stages) {
+		stage->filter.Reset();
+		stage->normalizer.Reset();
+	}
+	for (const auto &calculator : m_calculators) {
+		calculator->Reset();
+	}
+	return true;
+}
+
+template <typename T>
+void BasicMultiFingerprinter<T>::Consume(const int16_t *input, int length)
+{
+	assert(length >= 0);
+	m_audio_processor->Consume(input, length);
+}
+
+template <typename T>
+void BasicMultiFingerprinter<T>::Finish()
+{
+	m_audio_processor->Flush();
+	Flush();
+}
+
+template <typename T>
+void BasicMultiFingerprinter<T>::Flush()
+{
+	for (const auto &stage : m_frame_stages) {
+		stage->chroma.Flush();
+	}
+}
+
+template <typename T>
+const Vector<uint32_t> &BasicMultiFingerprinter<T>::GetFingerprint(size_t index)
+{
+	Flush();
+	return m_calculators[index]->GetFingerprint();
+}
+
+template class BasicMultiFingerprinter<float>;
+template class BasicMultiFingerprinter<double>;
+
+}; // namespace chromaprint
@@ -0,0 +1,97 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_MULTI_FINGERPRINTER_H_
+#define CHROMAPRINT_MULTI_FINGERPRINTER_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "utils.h"
+#include "audio_consumer.h"
+
+namespace chromaprint {
+
+class AudioProcessor;
+template <typename T> class BasicFingerprintCalculator;
+class FingerprinterConfiguration;
+
+/**
+ * Calculates fingerprints of the same audio with several algorithms at once.
+ *
+ * The audio is decoded, downmixed and resampled only once. After that the
+ * pipelines of the algorithms share every stage up to the first one whose
+ * configuration differs: algorithms with the same silence removal share the
+ * silence remover, with the same frames also the FFT and chroma stages,
+ * and with the same chroma filter also the filter and normalizer. Each
+ * algorithm only has its own fingerprint calculator, so the fingerprints
+ * are exactly the same as from separate fingerprinters.
+ */
+template <typename T>
+class BasicMultiFingerprinter : public Allocated
+{
+public:
+	BasicMultiFingerprinter(const int *algorithms, size_t num_algorithms);
+	~BasicMultiFingerprinter();
+
+	size_t num_algorithms() const { return m_configs.size(); }
+
+	const FingerprinterConfiguration *config(size_t index) const { return m_configs[index].get(); }
+
+	//! Number of FFT stages that are needed for all algorithms.
+	size_t num_fft_stages() const { return m_frame_stages.size(); }
+
+	//! Initialize the fingerprinting process.
+	bool Start(int sample_rate, int num_channels);
+
+	//! Process a block of raw audio data.
+	void Consume(const int16_t *input, int length);
+
+	//! Calculate the fingerprints based on the provided audio data.
+	void Finish();
+
+	//! Process the features that are buffered between the stages, without ending the stream.
+	void Flush();
+
+	//! Get the fingerprint of the algorithm with the given index, from data up to this point.
+	const Vector<uint32_t> &GetFingerprint(size_t index);
+
+private:
+	CHROMAPRINT_DISABLE_COPY(BasicMultiFingerprinter);
+
+	struct AudioSplitter;
+	struct FeatureSplitter;
+	struct SilenceStage;
+	struct FrameStage;
+	struct FilterStage;
+
+	SilenceStage *GetSilenceStage(const FingerprinterConfiguration *config);
+	FrameStage *GetFrameStage(const FingerprinterConfiguration *config);
+	FilterStage *GetFilterStage(const FingerprinterConfiguration *config);
+
+	std::vector<std::unique_ptr<FingerprinterConfiguration>> m_configs;
+	std::unique_ptr<AudioSplitter> m_splitter;
+	std::unique_ptr<AudioProcessor> m_audio_processor;
+	std::vector<std::unique_ptr<SilenceStage>> m_silence_stages;
+	std::vector<std::unique_ptr<FrameStage>> m_frame_stages;
+	std::vector<std::unique_ptr<FilterStage>> m_filter_stages;
+	std::vector<std::unique_ptr<BasicFingerprintCalculator<T>>> m_calculators;
+};
+
+extern template class BasicMultiFingerprinter<float>;
+extern template class BasicMultiFingerprinter<double>;
+
+#if USE_FLOAT_FEATURES
+typedef BasicMultiFingerprinter<float> MultiFingerprinter;
+#else
+typedef BasicMultiFingerprinter<double> MultiFingerprinter;
+#endif
+
+}; // namespace chromaprint
+
+#endif
@@ -0,0 +1,142 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include "pipeline_stats.h"
+
+namespace chromaprint {
+
+#if ENABLE_STATS
+
+class PipelineStats::Proxy
+{
+public:
+	virtual ~Proxy() {}
+};
+
+class PipelineStats::AudioConsumerProxy : public Proxy, public AudioConsumer
+{
+public:
+	AudioConsumerProxy(PipelineStats *stats, ChromaprintStage stage, AudioConsumer *consumer)
+		: m_stats(stats), m_stage(stage), m_consumer(consumer) {}
+
+	void Consume(const int16_t *input, int length) override {
+		Timer timer(m_stats, m_stage, length);
+		m_consumer->Consume(input, length);
+	}
+
+	void ConsumeFloat(const float *input, int length) override {
+		Timer timer(m_stats, m_stage, length);
+		m_consumer->ConsumeFloat(input, length);
+	}
+
+private:
+	PipelineStats *m_stats;
+	ChromaprintStage m_stage;
+	AudioConsumer *m_consumer;
+};
+
+template <typename T>
+class PipelineStats::FFTFrameConsumerProxy : public Proxy, public BasicFFTFrameConsumer<T>
+{
+public:
+	FFTFrameConsumerProxy(PipelineStats *stats, ChromaprintStage stage, BasicFFTFrameConsumer<T> *consumer)
+		: m_stats(stats), m_stage(stage), m_consumer(consumer) {}
+
+	void Consume(const BasicFFTFrame<T> &frame) override {
+		Timer timer(m_stats, m_stage, 1);
+		m_consumer->Consume(frame);
+	}
+
+private:
+	PipelineStats *m_stats;
+	ChromaprintStage m_stage;
+	BasicFFTFrameConsumer<T> *m_consumer;
+};
+
+template <typename T>
+class PipelineStats::FeatureVectorConsumerProxy : public Proxy, public BasicFeatureVectorConsumer<T>
+{
+public:
+	FeatureVectorConsumerProxy(PipelineStats *stats, ChromaprintStage stage, BasicFeatureVectorConsumer<T> *consumer)
+		: m_stats(stats), m_stage(stage), m_consumer(consumer) {}
+
+	void Consume(std::vector<T> &features) override {
+		Timer timer(m_stats, m_stage, 1);
+		m_consumer->Consume(features);
+	}
+
+	void ConsumeBlock(T *features, size_t num_rows, size_t num_columns) override {
+		Timer timer(m_stats, m_stage, num_rows);
+		m_consumer->ConsumeBlock(features, num_rows, num_columns);
+	}
+
+private:
+	PipelineStats *m_stats;
+	ChromaprintStage m_stage;
+	BasicFeatureVectorConsumer<T> *m_consumer;
+};
+
+AudioConsumer *PipelineStats::Wrap(ChromaprintStage stage, AudioConsumer *consumer)
+{
+	auto proxy = new AudioConsumerProxy(this, stage, consumer);
+	m_proxies.emplace_back(proxy);
+	return proxy;
+}
+
+template <typename T>
+BasicFFTFrameConsumer<T> *PipelineStats::Wrap(ChromaprintStage stage, BasicFFTFrameConsumer<T> *consumer)
+{
+	auto proxy = new FFTFrameConsumerProxy<T>(this, stage, consumer);
+	m_proxies.emplace_back(proxy);
+	return proxy;
+}
+
+template <typename T>
+BasicFeatureVectorConsumer<T> *PipelineStats::Wrap(ChromaprintStage stage, BasicFeatureVectorConsumer<T> *consumer)
+{
+	auto proxy = new FeatureVectorConsumerProxy<T>(this, stage, consumer);
+	m_proxies.emplace_back(proxy);
+	return proxy;
+}
+
+template BasicFFTFrameConsumer<float> *PipelineStats::Wrap(ChromaprintStage stage, BasicFFTFrameConsumer<float> *consumer);
+template BasicFFTFrameConsumer<double> *PipelineStats::Wrap(ChromaprintStage stage, BasicFFTFrameConsumer<double> *consumer);
+template BasicFeatureVectorConsumer<float> *PipelineStats::Wrap(ChromaprintStage stage, BasicFeatureVectorConsumer<float> *consumer);
+template BasicFeatureVectorConsumer<double> *PipelineStats::Wrap(ChromaprintStage stage, BasicFeatureVectorConsumer<double> *consumer);
+
+#endif
+
+PipelineStats::PipelineStats()
+{
+}
+
+PipelineStats::~PipelineStats()
+{
+}
+
+void PipelineStats::Reset()
+{
+	for (auto &stats : m_stages) {
+		stats = StageStats();
+	}
+}
+
+ChromaprintStageStats PipelineStats::GetStats(ChromaprintStage stage) const
+{
+	// The stages form a chain, the time of a stage includes the time of the
+	// first following stage that was called.
+	uint64_t time = m_stages[stage].total_time;
+	for (int next = stage + 1; next < CHROMAPRINT_NUM_STAGES; next++) {
+		if (m_stages[next].calls > 0) {
+			time -= std::min(time, m_stages[next].total_time);
+			break;
+		}
+	}
+	ChromaprintStageStats result;
+	result.time = time * 1e-9;
+	result.calls = m_stages[stage].calls;
+	result.items = m_stages[stage].items;
+	return result;
+}
+
+}; // namespace chromaprint
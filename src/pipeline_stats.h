@@ -0,0 +1,113 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_PIPELINE_STATS_H_
+#define CHROMAPRINT_PIPELINE_STATS_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "chromaprint.h"
+#include "utils.h"
+#include "audio_consumer.h"
+#include "fft_frame_consumer.h"
+#include "feature_vector_consumer.h"
+
+#if ENABLE_STATS
+#include <chrono>
+#endif
+
+namespace chromaprint {
+
+struct StageStats
+{
+	// Time spent in the stage including all the following stages (in ns).
+	uint64_t total_time = 0;
+	uint64_t calls = 0;
+	uint64_t items = 0;
+};
+
+/**
+ * Cumulative time and item counts of the stages of the fingerprinting
+ * pipeline.
+ *
+ * Stages are instrumented by wrapping the consumer that receives their
+ * input with Wrap(), which returns a proxy measuring the time spent in the
+ * wrapped consumer. The statistics are only collected if the library was
+ * built with ENABLE_STATS, otherwise Wrap() returns the consumer itself
+ * and the timers are empty, so the pipeline has no extra overhead.
+ */
+class PipelineStats : public Allocated
+{
+public:
+	PipelineStats();
+	~PipelineStats();
+
+	static bool IsEnabled() {
+#if ENABLE_STATS
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void Reset();
+
+	//! Get the statistics of a stage, with the time of the following stages subtracted.
+	ChromaprintStageStats GetStats(ChromaprintStage stage) const;
+
+#if ENABLE_STATS
+	class Timer
+	{
+	public:
+		Timer(PipelineStats *stats, ChromaprintStage stage, size_t items)
+			: m_stats(stats->m_stages[stage]), m_start(std::chrono::steady_clock::now()) {
+			m_stats.calls++;
+			m_stats.items += items;
+		}
+		~Timer() {
+			const auto elapsed = std::chrono::steady_clock::now() - m_start;
+			m_stats.total_time += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+		}
+	private:
+		StageStats &m_stats;
+		std::chrono::steady_clock::time_point m_start;
+	};
+
+	AudioConsumer *Wrap(ChromaprintStage stage, AudioConsumer *consumer);
+	template <typename T>
+	BasicFFTFrameConsumer<T> *Wrap(ChromaprintStage stage, BasicFFTFrameConsumer<T> *consumer);
+	template <typename T>
+	BasicFeatureVectorConsumer<T> *Wrap(ChromaprintStage stage, BasicFeatureVectorConsumer<T> *consumer);
+#else
+	class Timer
+	{
+	public:
+		Timer(PipelineStats *stats, ChromaprintStage stage, size_t items) {}
+	};
+
+	template <typename Consumer>
+	Consumer *Wrap(ChromaprintStage stage, Consumer *consumer) { return consumer; }
+#endif
+
+private:
+	CHROMAPRINT_DISABLE_COPY(PipelineStats);
+
+	StageStats m_stages[CHROMAPRINT_NUM_STAGES];
+
+#if ENABLE_STATS
+	class Proxy;
+	class AudioConsumerProxy;
+	template <typename T> class FFTFrameConsumerProxy;
+	template <typename T> class FeatureVectorConsumerProxy;
+	std::vector<std::unique_ptr<Proxy>> m_proxies;
+#endif
+};
+
+}; // namespace chromaprint
+
+#endif
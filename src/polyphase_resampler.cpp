@@ -0,0 +1,344 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <utility>
+#include "polyphase_resampler.h"
+#include "utils/shared_cache.h"
+#include "debug.h"
+
+#ifdef CHROMAPRINT_ARCH_X86
+#include <immintrin.h>
+#endif
+
+namespace chromaprint {
+
+// Same filter as the internal avresample is configured with in AudioProcessor.
+static const int kResampleFilterLength = 16;
+static const double kResampleCutoff = 0.8;
+static const double kResampleKaiserBeta = 9.0;
+
+// Filters are padded to a multiple of this many taps, so that the SIMD
+// loops don't need to handle a remainder.
+static const int kTapAlignment = 8;
+
+struct PolyphaseResampler::Filter
+{
+	int input_rate;
+	int output_rate;
+	// index_step + phase_step / num_phases input samples per output sample
+	int index_step;
+	int phase_step;
+	int num_phases;
+	int length;
+	int stride;
+	// num_phases filters, each with stride taps
+	std::vector<float> taps;
+};
+
+namespace {
+
+int GreatestCommonDivisor(int a, int b)
+{
+	while (b) {
+		const int t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+// 0th order modified Bessel function of the first kind.
+double Bessel(double x)
+{
+	double v = 1.0, last_v = 0.0, t = 1.0;
+	x = x * x / 4.0;
+	for (int i = 1; v != last_v; i++) {
+		last_v = v;
+		t *= x / (i * i);
+		v += t;
+	}
+	return v;
+}
+
+std::shared_ptr<const PolyphaseResampler::Filter> CreateFilter(int input_rate, int output_rate)
+{
+	const int gcd = GreatestCommonDivisor(input_rate, output_rate);
+	const double factor = std::min(output_rate * kResampleCutoff / input_rate, 1.0);
+
+	std::shared_ptr<PolyphaseResampler::Filter> filter(new PolyphaseResampler::Filter());
+	filter->input_rate = input_rate;
+	filter->output_rate = output_rate;
+	filter->num_phases = output_rate / gcd;
+	filter->index_step = (input_rate / gcd) / filter->num_phases;
+	filter->phase_step = (input_rate / gcd) % filter->num_phases;
+	filter->length = std::max(int(std::ceil(kResampleFilterLength / factor)), 1);
+	filter->stride = (filter->length + kTapAlignment - 1) / kTapAlignment * kTapAlignment;
+	filter->taps.resize(filter->num_phases * filter->stride);
+
+	// Windowed sinc centered between taps center and center + 1, normalized
+	// so that a constant signal keeps its value, see build_filter() in resample2.c.
+	const int center = (filter->length - 1) / 2;
+	std::vector<double> tmp(filter->length);
+	for (int phase = 0; phase < filter->num_phases; phase++) {
+		double norm = 0.0;
+		for (int i = 0; i < filter->length; i++) {
+			const double x = M_PI * ((i - center) - double(phase) / filter->num_phases) * factor;
+			double y = x == 0.0 ? 1.0 : std::sin(x) / x;
+			const double w = 2.0 * x / (factor * filter->length * M_PI);
+			y *= Bessel(kResampleKaiserBeta * std::sqrt(std::max(1.0 - w * w, 0.0)));
+			tmp[i] = y;
+			norm += y;
+		}
+		float *taps = filter->taps.data() + phase * filter->stride;
+		for (int i = 0; i < filter->length; i++) {
+			taps[i] = float(tmp[i] / norm);
+		}
+	}
+	return filter;
+}
+
+// The tables are immutable, resamplers with the same rates share them.
+std::shared_ptr<const PolyphaseResampler::Filter> GetFilter(int input_rate, int output_rate)
+{
+	static SharedCache<std::pair<int, int>, PolyphaseResampler::Filter> cache;
+	return cache.Get(std::make_pair(input_rate, output_rate), [&]() {
+		return CreateFilter(input_rate, output_rate);
+	});
+}
+
+inline void StoreSample(float value, int16_t *output)
+{
+	*output = RoundToInt16(value);
+}
+
+inline void StoreSample(float value, float *output)
+{
+	*output = value;
+}
+
+}; // namespace
+
+bool PolyphaseResampler::IsSupported(int input_rate, int output_rate)
+{
+	if (input_rate <= 0 || output_rate <= 0) {
+		return false;
+	}
+	return output_rate / GreatestCommonDivisor(input_rate, output_rate) <= MAX_PHASES;
+}
+
+PolyphaseResampler::PolyphaseResampler(int input_rate, int output_rate)
+	: m_filter(GetFilter(input_rate, output_rate))
+{
+	assert(IsSupported(input_rate, output_rate));
+	Reset();
+}
+
+PolyphaseResampler::~PolyphaseResampler()
+{
+}
+
+int PolyphaseResampler::filter_length() const
+{
+	return m_filter->length;
+}
+
+int PolyphaseResampler::num_phases() const
+{
+	return m_filter->num_phases;
+}
+
+void PolyphaseResampler::Reset()
+{
+	// the first output sample is centered on the first input sample
+	m_index = -long((m_filter->length - 1) / 2);
+	m_phase = 0;
+}
+
+void PolyphaseResampler::Reset(int input_rate, int output_rate)
+{
+	assert(IsSupported(input_rate, output_rate));
+	if (m_filter->input_rate != input_rate || m_filter->output_rate != output_rate) {
+		m_filter = GetFilter(input_rate, output_rate);
+	}
+	Reset();
+}
+
+inline void PolyphaseResampler::Advance()
+{
+	m_index += m_filter->index_step;
+	m_phase += m_filter->phase_step;
+	if (m_phase >= m_filter->num_phases) {
+		m_phase -= m_filter->num_phases;
+		m_index++;
+	}
+}
+
+template <typename Sample>
+size_t PolyphaseResampler::Resample(const Sample *input, size_t length, Sample *output, size_t max_output, size_t *consumed)
+{
+	const Filter &filter = *m_filter;
+	size_t num_output = 0;
+
+	// Before the filter is within the input, the input is mirrored like in
+	// av_resample(). Unlike there, it waits for enough input, so that the
+	// output doesn't depend on how the input is split into calls.
+	while (m_index < 0 && num_output < max_output && length >= size_t(filter.length)) {
+		const float *taps = filter.taps.data() + m_phase * filter.stride;
+		float sum = 0.0f;
+		for (int i = 0; i < filter.length; i++) {
+			sum += input[std::labs(m_index + i)] * taps[i];
+		}
+		StoreSample(sum, output + num_output++);
+		Advance();
+	}
+
+	if (m_index >= 0 && size_t(m_index) + filter.length <= length) {
+		// the loops read up to a full stride of taps past the filter
+		m_input.resize(length + filter.stride);
+		std::copy(input, input + length, m_input.begin());
+		std::fill(m_input.begin() + length, m_input.end(), 0.0f);
+		num_output += Run(m_input.data(), length, output + num_output, max_output - num_output);
+	}
+
+	*consumed = m_index > 0 ? size_t(m_index) : 0;
+	if (m_index > 0) {
+		m_index = 0;
+	}
+	return num_output;
+}
+
+template <typename Sample>
+size_t PolyphaseResampler::Run_Generic(const float *input, size_t length, Sample *output, size_t max_output)
+{
+	const Filter &filter = *m_filter;
+	size_t num_output = 0;
+	while (num_output < max_output && size_t(m_index) + filter.length <= length) {
+		const float *taps = filter.taps.data() + m_phase * filter.stride;
+		const float *x = input + m_index;
+		float sums[kTapAlignment] = { 0.0f };
+		for (int i = 0; i < filter.stride; i += kTapAlignment) {
+			for (int j = 0; j < kTapAlignment; j++) {
+				sums[j] += x[i + j] * taps[i + j];
+			}
+		}
+		float sum = 0.0f;
+		for (int j = 0; j < kTapAlignment; j++) {
+			sum += sums[j];
+		}
+		StoreSample(sum, output + num_output++);
+		Advance();
+	}
+	return num_output;
+}
+
+#ifdef CHROMAPRINT_ARCH_X86
+
+namespace {
+
+// Rounded and saturated to 16 bits like RoundToInt16().
+CHROMAPRINT_TARGET("avx2")
+inline void StoreSamples(__m128 sum, int16_t *output, size_t count)
+{
+	const __m128i rounded = _mm_cvtps_epi32(_mm_floor_ps(_mm_add_ps(sum, _mm_set1_ps(0.5f))));
+	int16_t values[8];
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(values), _mm_packs_epi32(rounded, rounded));
+	std::copy(values, values + count, output);
+}
+
+CHROMAPRINT_TARGET("avx2")
+inline void StoreSamples(__m128 sum, float *output, size_t count)
+{
+	float values[4];
+	_mm_storeu_ps(values, sum);
+	std::copy(values, values + count, output);
+}
+
+}; // namespace
+
+template <typename Sample>
+CHROMAPRINT_TARGET("avx2")
+size_t PolyphaseResampler::Run_AVX2(const float *input, size_t length, Sample *output, size_t max_output)
+{
+	// Four output samples are calculated at once, so that their dot products
+	// are independent and their horizontal sums can be combined.
+	const Filter &filter = *m_filter;
+	size_t num_output = 0;
+	while (num_output < max_output && size_t(m_index) + filter.length <= length) {
+		const float *taps[4];
+		const float *x[4];
+		size_t count = 0;
+		while (count < 4 && num_output + count < max_output && size_t(m_index) + filter.length <= length) {
+			taps[count] = filter.taps.data() + m_phase * filter.stride;
+			x[count] = input + m_index;
+			count++;
+			Advance();
+		}
+		for (size_t j = count; j < 4; j++) {
+			taps[j] = taps[0];
+			x[j] = x[0];
+		}
+
+		__m256 sums[4];
+		for (size_t j = 0; j < 4; j++) {
+			__m256 sum = _mm256_setzero_ps();
+			for (int i = 0; i < filter.stride; i += 8) {
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(x[j] + i), _mm256_loadu_ps(taps[j] + i)));
+			}
+			sums[j] = sum;
+		}
+
+		// sums of the four vectors
+		const __m256 sum01 = _mm256_hadd_ps(sums[0], sums[1]);
+		const __m256 sum23 = _mm256_hadd_ps(sums[2], sums[3]);
+		const __m256 sum0123 = _mm256_hadd_ps(sum01, sum23);
+		const __m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum0123), _mm256_extractf128_ps(sum0123, 1));
+		StoreSamples(sum, output + num_output, count);
+		num_output += count;
+	}
+	return num_output;
+}
+
+#endif
+
+namespace {
+
+template <typename Sample>
+struct RunFunc
+{
+	typedef size_t (PolyphaseResampler::*Type)(const float *input, size_t length, Sample *output, size_t max_output);
+};
+
+template <typename Sample>
+typename RunFunc<Sample>::Type SelectRun()
+{
+#ifdef CHROMAPRINT_ARCH_X86
+	if (GetCpuFeatures().avx2) {
+		return &PolyphaseResampler::Run_AVX2<Sample>;
+	}
+#endif
+	return &PolyphaseResampler::Run_Generic<Sample>;
+}
+
+}; // namespace
+
+template <typename Sample>
+size_t PolyphaseResampler::Run(const float *input, size_t length, Sample *output, size_t max_output)
+{
+	static const typename RunFunc<Sample>::Type func = SelectRun<Sample>();
+	return (this->*func)(input, length, output, max_output);
+}
+
+template size_t PolyphaseResampler::Resample(const int16_t *input, size_t length, int16_t *output, size_t max_output, size_t *consumed);
+template size_t PolyphaseResampler::Resample(const float *input, size_t length, float *output, size_t max_output, size_t *consumed);
+template size_t PolyphaseResampler::Run_Generic(const float *input, size_t length, int16_t *output, size_t max_output);
+template size_t PolyphaseResampler::Run_Generic(const float *input, size_t length, float *output, size_t max_output);
+#ifdef CHROMAPRINT_ARCH_X86
+template size_t PolyphaseResampler::Run_AVX2(const float *input, size_t length, int16_t *output, size_t max_output);
+template size_t PolyphaseResampler::Run_AVX2(const float *input, size_t length, float *output, size_t max_output);
+#endif
+
+}; // namespace chromaprint
@@ -0,0 +1,92 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_POLYPHASE_RESAMPLER_H_
+#define CHROMAPRINT_POLYPHASE_RESAMPLER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "utils.h"
+#include "utils/allocator.h"
+#include "utils/cpu_features.h"
+
+namespace chromaprint {
+
+/**
+ * Resampler for rates with a small rational ratio, like 44100 to 11025 Hz
+ * (4:1) or 48000 to 11025 Hz (640:147).
+ *
+ * It uses the same Kaiser windowed sinc filter as the internal avresample,
+ * but with a separate filter for every output phase the ratio can produce,
+ * so there is no phase rounding, and the filters are in floating point.
+ * The output is therefore very close to avresample, but not identical.
+ *
+ * The filter tables only depend on the rates, they are shared by all
+ * resamplers with the same rates. The dot products use the best
+ * implementation available on the CPU.
+ */
+class PolyphaseResampler : public Allocated
+{
+public:
+	//! Maximum number of phases, rates with a more complex ratio are not supported.
+	static const int MAX_PHASES = 1024;
+
+	struct Filter;
+
+	static bool IsSupported(int input_rate, int output_rate);
+
+	PolyphaseResampler(int input_rate, int output_rate);
+	~PolyphaseResampler();
+
+	int filter_length() const;
+	int num_phases() const;
+
+	//! Prepare for a new audio stream.
+	void Reset();
+
+	//! Prepare for a new audio stream with different rates, the buffers are kept.
+	void Reset(int input_rate, int output_rate);
+
+	/**
+	 * Resample as much of the input as possible, at most max_output samples.
+	 * Returns the number of output samples and sets consumed to the number
+	 * of input samples that are no longer needed. The rest of the input must
+	 * be passed again in the next call, same as with av_resample().
+	 *
+	 * The samples are either 16-bit integers, or floats in the same range,
+	 * which are not rounded. Implemented for int16_t and float.
+	 */
+	template <typename Sample>
+	size_t Resample(const Sample *input, size_t length, Sample *output, size_t max_output, size_t *consumed);
+
+	// Individual implementations of the inner loop, only exposed for testing
+	// and benchmarking. The caller is responsible for checking that the CPU
+	// supports them. They produce output while the whole filter is within the
+	// input, which is converted to float and padded with zeros.
+	template <typename Sample>
+	size_t Run_Generic(const float *input, size_t length, Sample *output, size_t max_output);
+#ifdef CHROMAPRINT_ARCH_X86
+	template <typename Sample>
+	size_t Run_AVX2(const float *input, size_t length, Sample *output, size_t max_output);
+#endif
+
+private:
+	CHROMAPRINT_DISABLE_COPY(PolyphaseResampler);
+
+	void Advance();
+	template <typename Sample>
+	size_t Run(const float *input, size_t length, Sample *output, size_t max_output);
+
+	std::shared_ptr<const Filter> m_filter;
+	Vector<float> m_input;
+	// position of the first input sample of the filter for the next output
+	// sample, it is negative at the start of the stream
+	long m_index;
+	int m_phase;
+};
+
+}; // namespace chromaprint
+
+#endif
@@ -0,0 +1,180 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+#include "polyphase_resampler.h"
+#include "test_utils.h"
+
+#if USE_INTERNAL_AVRESAMPLE
+extern "C" {
+#include "avresample/avcodec.h"
+}
+#endif
+
+namespace chromaprint {
+
+namespace {
+
+// Tones within the pass band of all rates and some noise.
+std::vector<int16_t> GenerateSignal(int sample_rate, double duration)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<double> noise(-1000.0, 1000.0);
+	std::vector<int16_t> signal(size_t(sample_rate * duration));
+	for (size_t i = 0; i < signal.size(); i++) {
+		const double t = double(i) / sample_rate;
+		const double value = 6000.0 * std::sin(2.0 * M_PI * 220.0 * t) +
+			5000.0 * std::sin(2.0 * M_PI * 1234.5 * t) +
+			4000.0 * std::sin(2.0 * M_PI * 3456.7 * t) + noise(rng);
+		signal[i] = int16_t(value);
+	}
+	return signal;
+}
+
+// Feed the input in chunks, keeping the unconsumed input like AudioProcessor does.
+template <typename Func>
+std::vector<int16_t> ResampleInChunks(const std::vector<int16_t> &input, size_t chunk_size, Func resample)
+{
+	std::vector<int16_t> buffer;
+	std::vector<int16_t> output;
+	std::vector<int16_t> result;
+	for (size_t offset = 0; offset < input.size(); offset += chunk_size) {
+		const size_t end = std::min(offset + chunk_size, input.size());
+		buffer.insert(buffer.end(), input.begin() + offset, input.begin() + end);
+		output.resize(buffer.size() * 2 + 1);
+		size_t consumed = 0;
+		const size_t length = resample(buffer.data(), buffer.size(), output.data(), output.size(), &consumed);
+		result.insert(result.end(), output.begin(), output.begin() + length);
+		buffer.erase(buffer.begin(), buffer.begin() + consumed);
+	}
+	return result;
+}
+
+std::vector<int16_t> Resample(int input_rate, int output_rate, const std::vector<int16_t> &input, size_t chunk_size)
+{
+	PolyphaseResampler resampler(input_rate, output_rate);
+	return ResampleInChunks(input, chunk_size, [&](const int16_t *input, size_t length, int16_t *output, size_t max_output, size_t *consumed) {
+		return resampler.Resample(input, length, output, max_output, consumed);
+	});
+}
+
+}; // namespace
+
+TEST(PolyphaseResamplerTest, IsSupported) {
+	ASSERT_TRUE(PolyphaseResampler::IsSupported(44100, 11025));
+	ASSERT_TRUE(PolyphaseResampler::IsSupported(48000, 11025));
+	ASSERT_TRUE(PolyphaseResampler::IsSupported(8000, 11025));
+	ASSERT_FALSE(PolyphaseResampler::IsSupported(44101, 11025));
+	ASSERT_FALSE(PolyphaseResampler::IsSupported(0, 11025));
+
+	PolyphaseResampler resampler1(44100, 11025);
+	ASSERT_EQ(1, resampler1.num_phases());
+	ASSERT_EQ(80, resampler1.filter_length());
+
+	PolyphaseResampler resampler2(48000, 11025);
+	ASSERT_EQ(147, resampler2.num_phases());
+	ASSERT_EQ(88, resampler2.filter_length());
+}
+
+TEST(PolyphaseResamplerTest, ChunkedMatchesWhole) {
+	for (int input_rate : { 8000, 44100, 48000 }) {
+		SCOPED_TRACE("input rate " + std::to_string(input_rate));
+		const auto input = GenerateSignal(input_rate, 3.0);
+		const auto whole = Resample(input_rate, 11025, input, input.size());
+		ASSERT_NEAR(3.0 * 11025, whole.size(), 100);
+		for (size_t chunk_size : { 7, 100, 4099 }) {
+			ASSERT_EQ(whole, Resample(input_rate, 11025, input, chunk_size)) << "chunk size " << chunk_size;
+		}
+	}
+}
+
+#if USE_INTERNAL_AVRESAMPLE
+
+// Same filter, but avresample rounds the phases to 1/256 and the filter
+// coefficients to 16 bits, so the results differ a little.
+TEST(PolyphaseResamplerTest, MatchesAvresample) {
+	struct {
+		int input_rate;
+		std::vector<int16_t> input;
+		int max_difference;
+	} inputs[] = {
+		{ 44100, LoadAudioFile("data/test_mono_44100.raw"), 4 },
+		{ 8000, LoadAudioFile("data/test_mono_8000.raw"), 32 },
+		{ 22050, GenerateSignal(22050, 3.0), 4 },
+		{ 44100, GenerateSignal(44100, 3.0), 4 },
+		{ 48000, GenerateSignal(48000, 3.0), 32 },
+		{ 96000, GenerateSignal(96000, 3.0), 32 },
+	};
+
+	for (const auto &input : inputs) {
+		SCOPED_TRACE("input rate " + std::to_string(input.input_rate));
+		AVResampleContext *ctx = av_resample_init(11025, input.input_rate, 16, 8, 0, 0.8);
+		const auto expected = ResampleInChunks(input.input, 4096, [&](const int16_t *input, size_t length, int16_t *output, size_t max_output, size_t *consumed) {
+			int consumed_int = 0;
+			const int result = av_resample(ctx, output, const_cast<int16_t *>(input), &consumed_int, int(length), int(max_output), 1);
+			*consumed = size_t(consumed_int);
+			return size_t(result);
+		});
+		av_resample_close(ctx);
+
+		const auto actual = Resample(input.input_rate, 11025, input.input, 4096);
+		ASSERT_EQ(expected.size(), actual.size());
+
+		double signal = 0.0, error = 0.0;
+		int max_difference = 0;
+		for (size_t i = 0; i < expected.size(); i++) {
+			const int difference = std::abs(int(expected[i]) - int(actual[i]));
+			max_difference = std::max(max_difference, difference);
+			signal += double(expected[i]) * expected[i];
+			error += double(difference) * difference;
+		}
+		EXPECT_LE(max_difference, input.max_difference);
+		EXPECT_GT(10.0 * std::log10(signal / std::max(error, 1.0)), 60.0);
+	}
+}
+
+#endif
+
+#ifdef CHROMAPRINT_ARCH_X86
+
+TEST(PolyphaseResamplerTest, AVX2) {
+	if (!GetCpuFeatures().avx2) {
+		GTEST_SKIP() << "AVX2 not supported";
+	}
+	const auto input = GenerateSignal(48000, 1.0);
+	std::vector<float> float_input(input.begin(), input.end());
+	float_input.resize(input.size() + 128, 0.0f);
+
+	PolyphaseResampler generic(48000, 11025);
+	PolyphaseResampler avx2(48000, 11025);
+
+	// skip the start of the stream, where the input is mirrored
+	std::vector<int16_t> output1(input.size()), output2(input.size());
+	size_t consumed1, consumed2;
+	generic.Resample(input.data(), input.size(), output1.data(), 32, &consumed1);
+	avx2.Resample(input.data(), input.size(), output2.data(), 32, &consumed2);
+	ASSERT_EQ(consumed1, consumed2);
+
+	const size_t length = input.size() - consumed1;
+	const size_t size1 = generic.Run_Generic(float_input.data() + consumed1, length, output1.data(), output1.size());
+	const size_t size2 = avx2.Run_AVX2(float_input.data() + consumed1, length, output2.data(), output2.size());
+	ASSERT_EQ(size1, size2);
+	ASSERT_GT(size1, 10000u);
+	for (size_t i = 0; i < size1; i++) {
+		// the sums are calculated in a different order
+		ASSERT_NEAR(output1[i], output2[i], 1) << "index " << i;
+	}
+}
+
+#endif
+
+}; // namespace chromaprint
@@ -0,0 +1,196 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <cassert>
+#include <algorithm>
+#include "sharded_feature_extractor.h"
+#include "fft.h"
+#include "chroma.h"
+#include "chroma_filter.h"
+#include "chroma_normalizer.h"
+#include "fingerprinter_configuration.h"
+#include "utils/thread_pool.h"
+#include "debug.h"
+
+namespace chromaprint {
+
+// Audio is buffered until every thread can get a shard of at least this
+// many rows, about a minute of audio.
+static const size_t SHARD_ROWS = 512;
+
+// Every shard repeats a few frames of the previous one, smaller shards are
+// not worth the overhead. In the low latency mode, the audio is processed as
+// soon as there is one shard of this size.
+static const size_t MIN_SHARD_ROWS = 32;
+
+template <typename T>
+struct BasicShardedFeatureExtractor<T>::Pipeline : public Allocated
+{
+	struct Collector : public BasicFeatureVectorConsumer<T> {
+		void Consume(std::vector<T> &features) override {
+			output->insert(output->end(), features.begin(), features.end());
+			num_rows++;
+		}
+		void ConsumeBlock(T *features, size_t rows, size_t num_columns) override {
+			output->insert(output->end(), features, features + rows * num_columns);
+			num_rows += rows;
+		}
+		Vector<T> *output = nullptr;
+		size_t num_rows = 0;
+	};
+
+	Pipeline(const FingerprinterConfiguration *config)
+		: normalizer(&collector),
+		  filter(config->filter_coefficients(), config->num_filter_coefficients(), &normalizer),
+		  chroma(CHROMA_MIN_FREQ, CHROMA_MAX_FREQ, config->frame_size(), config->sample_rate(), &filter),
+		  fft(config->frame_size(), config->frame_overlap(), &chroma)
+	{
+		chroma.set_block_size(FEATURE_BLOCK_SIZE);
+	}
+
+	//! Calculate features of a shard of audio that starts on a frame boundary.
+	size_t Run(const float *input, size_t length, Vector<T> &output) {
+		fft.Reset();
+		chroma.Reset();
+		filter.Reset();
+		normalizer.Reset();
+		output.clear();
+		collector.output = &output;
+		collector.num_rows = 0;
+		fft.ConsumeFloat(input, int(length));
+		chroma.Flush();
+		return collector.num_rows;
+	}
+
+	Collector collector;
+	BasicChromaNormalizer<T> normalizer;
+	BasicChromaFilter<T> filter;
+	BasicChroma<T> chroma;
+	BasicFFT<T> fft;
+};
+
+template <typename T>
+BasicShardedFeatureExtractor<T>::BasicShardedFeatureExtractor(const FingerprinterConfiguration *config, size_t num_threads, BasicFeatureVectorConsumer<T> *consumer)
+	: m_frame_size(config->frame_size()),
+	  m_frame_increment(config->frame_size() - config->frame_overlap()),
+	  m_filter_length(config->num_filter_coefficients()),
+	  m_pool(new ThreadPool(num_threads)),
+	  m_consumer(consumer)
+{
+	assert(m_filter_length > 0);
+	// The pipelines are created on this thread, FFT plan creation is not
+	// thread-safe with some FFT libraries.
+	for (size_t i = 0; i < m_pool->num_threads(); i++) {
+		m_pipelines.emplace_back(new Pipeline(config));
+	}
+}
+
+template <typename T>
+BasicShardedFeatureExtractor<T>::~BasicShardedFeatureExtractor()
+{
+}
+
+template <typename T>
+size_t BasicShardedFeatureExtractor<T>::num_threads() const
+{
+	return m_pool->num_threads();
+}
+
+template <typename T>
+void BasicShardedFeatureExtractor<T>::Reset()
+{
+	m_samples.clear();
+	m_samples_offset = 0;
+	m_next_row = 0;
+}
+
+template <typename T>
+size_t BasicShardedFeatureExtractor<T>::GetNumAvailableRows() const
+{
+	const size_t num_samples = m_samples_offset + m_samples.size();
+	if (num_samples < m_frame_size) {
+		return 0;
+	}
+	const size_t num_frames = (num_samples - m_frame_size) / m_frame_increment + 1;
+	if (num_frames < m_filter_length) {
+		return 0;
+	}
+	return num_frames - m_filter_length + 1;
+}
+
+template <typename T>
+void BasicShardedFeatureExtractor<T>::Consume(const int16_t *input, int length)
+{
+	m_samples.insert(m_samples.end(), input, input + length);
+	MaybeProcess();
+}
+
+template <typename T>
+void BasicShardedFeatureExtractor<T>::ConsumeFloat(const float *input, int length)
+{
+	m_samples.insert(m_samples.end(), input, input + length);
+	MaybeProcess();
+}
+
+template <typename T>
+void BasicShardedFeatureExtractor<T>::MaybeProcess()
+{
+	const size_t num_rows = GetNumAvailableRows();
+	const size_t min_rows = m_low_latency ? MIN_SHARD_ROWS : SHARD_ROWS * m_pipelines.size();
+	if (num_rows - m_next_row >= min_rows) {
+		Process(num_rows);
+	}
+}
+
+template <typename T>
+void BasicShardedFeatureExtractor<T>::Flush()
+{
+	Process(GetNumAvailableRows());
+}
+
+template <typename T>
+void BasicShardedFeatureExtractor<T>::Process(size_t end_row)
+{
+	const size_t num_rows = end_row - m_next_row;
+	if (num_rows == 0) {
+		return;
+	}
+
+	const size_t num_shards = std::max(size_t(1), std::min(m_pipelines.size(), num_rows / MIN_SHARD_ROWS));
+	m_shard_features.resize(std::max(m_shard_features.size(), num_shards));
+	m_pool->Run(num_shards, [&](size_t thread_index, size_t shard) {
+		// Row i of the features is calculated from frames [i, i + filter_length),
+		// frame j starts at sample j * frame_increment.
+		const size_t begin = m_next_row + num_rows * shard / num_shards;
+		const size_t end = m_next_row + num_rows * (shard + 1) / num_shards;
+		const size_t input_begin = begin * m_frame_increment;
+		const size_t input_end = (end + m_filter_length - 2) * m_frame_increment + m_frame_size;
+		assert(input_begin >= m_samples_offset);
+		assert(input_end <= m_samples_offset + m_samples.size());
+		const size_t shard_rows = m_pipelines[thread_index]->Run(
+			m_samples.data() + (input_begin - m_samples_offset), input_end - input_begin,
+			m_shard_features[shard]);
+		assert(shard_rows == end - begin);
+		(void) shard_rows;
+	});
+
+	for (size_t shard = 0; shard < num_shards; shard++) {
+		auto &features = m_shard_features[shard];
+		const size_t begin = m_next_row + num_rows * shard / num_shards;
+		const size_t end = m_next_row + num_rows * (shard + 1) / num_shards;
+		if (m_consumer) {
+			m_consumer->ConsumeBlock(features.data(), end - begin, features.size() / (end - begin));
+		}
+	}
+
+	// Keep only the audio needed for the next rows.
+	m_next_row = end_row;
+	const size_t input_begin = std::min(m_next_row * m_frame_increment, m_samples_offset + m_samples.size());
+	m_samples.erase(m_samples.begin(), m_samples.begin() + (input_begin - m_samples_offset));
+	m_samples_offset = input_begin;
+}
+
+template class BasicShardedFeatureExtractor<float>;
+template class BasicShardedFeatureExtractor<double>;
+
+}; // namespace chromaprint
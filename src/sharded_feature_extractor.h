@@ -0,0 +1,95 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_SHARDED_FEATURE_EXTRACTOR_H_
+#define CHROMAPRINT_SHARDED_FEATURE_EXTRACTOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "utils.h"
+#include "audio_consumer.h"
+#include "feature_vector_consumer.h"
+
+namespace chromaprint {
+
+class FingerprinterConfiguration;
+class ThreadPool;
+
+/**
+ * Calculates the normalized chroma features of a long audio stream on
+ * multiple threads.
+ *
+ * The stages from the FFT to the chroma normalizer only look at a few
+ * frames of audio, so the stream can be split into shards, which are
+ * processed by independent pipelines, as long as every shard starts on a
+ * frame boundary and includes the frames the chroma filter needs before
+ * its first row. The features are then passed to the consumer in order,
+ * exactly as if they were calculated by a single pipeline.
+ *
+ * The input is buffered until there is enough audio to keep all threads
+ * busy, Flush() processes everything that was buffered. In the low latency
+ * mode, the features are calculated as soon as there are a few seconds of
+ * audio, which keeps consumers that need the results early going, but uses
+ * fewer threads.
+ */
+template <typename T>
+class BasicShardedFeatureExtractor : public AudioConsumer
+{
+public:
+	//! Create an extractor with the given number of threads, 0 means one per CPU core.
+	BasicShardedFeatureExtractor(const FingerprinterConfiguration *config, size_t num_threads, BasicFeatureVectorConsumer<T> *consumer);
+	~BasicShardedFeatureExtractor();
+
+	size_t num_threads() const;
+
+	BasicFeatureVectorConsumer<T> *consumer() const { return m_consumer; }
+	void set_consumer(BasicFeatureVectorConsumer<T> *consumer) { m_consumer = consumer; }
+
+	bool low_latency() const { return m_low_latency; }
+	void set_low_latency(bool low_latency) { m_low_latency = low_latency; }
+
+	//! Prepare for a new audio stream.
+	void Reset();
+
+	void Consume(const int16_t *input, int length) override;
+	void ConsumeFloat(const float *input, int length) override;
+
+	//! Calculate features from all buffered audio.
+	void Flush();
+
+private:
+	CHROMAPRINT_DISABLE_COPY(BasicShardedFeatureExtractor);
+
+	struct Pipeline;
+
+	//! Calculate rows of features up to end_row and pass them to the consumer.
+	void Process(size_t end_row);
+
+	//! Number of rows of features that can be calculated from the audio received so far.
+	size_t GetNumAvailableRows() const;
+
+	//! Process the buffered audio if there is enough of it.
+	void MaybeProcess();
+
+	size_t m_frame_size;
+	size_t m_frame_increment;
+	size_t m_filter_length;
+	std::unique_ptr<ThreadPool> m_pool;
+	std::vector<std::unique_ptr<Pipeline>> m_pipelines;
+	std::vector<Vector<T>> m_shard_features;
+	// 16-bit samples are stored as floats exactly
+	Vector<float> m_samples;
+	size_t m_samples_offset = 0;
+	size_t m_next_row = 0;
+	bool m_low_latency = false;
+	BasicFeatureVectorConsumer<T> *m_consumer;
+};
+
+extern template class BasicShardedFeatureExtractor<float>;
+extern template class BasicShardedFeatureExtractor<double>;
+
+}; // namespace chromaprint
+
+#endif
@@ -25,27 +25,50 @@ bool SilenceRemover::Reset(int sample_rate, int num_channels)
 		return false;
 	}
 	m_start = true;
+	m_average.Reset();
 	return true;
 }
 
+template <typename Sample>
+int SilenceRemover::SkipSilence(const Sample *input, int length)
+{
+	int skipped = 0;
+	while (skipped < length) {
+		// float samples are measured like the 16-bit samples they would be rounded to
+		m_average.AddValue(std::abs(int(RoundToInt16(float(input[skipped])))));
+		if (m_average.GetAverage() > m_threshold) {
+			m_start = false;
+			break;
+		}
+		skipped++;
+	}
+	return skipped;
+}
+
 void SilenceRemover::Consume(const int16_t *input, int length)
 {
 	if (m_start) {
-		while (length) {
-			m_average.AddValue(std::abs(*input));
-			if (m_average.GetAverage() > m_threshold) {
-				m_start = false;
-				break;
-			}
-			input++;
-			length--;
-		}
+		const int skipped = SkipSilence(input, length);
+		input += skipped;
+		length -= skipped;
 	}
 	if (length) {
 		m_consumer->Consume(input, length);
 	}
 }
 
+void SilenceRemover::ConsumeFloat(const float *input, int length)
+{
+	if (m_start) {
+		const int skipped = SkipSilence(input, length);
+		input += skipped;
+		length -= skipped;
+	}
+	if (length) {
+		m_consumer->ConsumeFloat(input, length);
+	}
+}
+
 void SilenceRemover::Flush()
 {
 }
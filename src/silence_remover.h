@@ -27,6 +27,7 @@ public:
 
 	bool Reset(int sample_rate, int num_channels);
 	void Consume(const int16_t *input, int length) override;
+	void ConsumeFloat(const float *input, int length) override;
 	void Flush();
 
 	int threshold()
@@ -42,6 +43,10 @@ public:
 private:
 	CHROMAPRINT_DISABLE_COPY(SilenceRemover);
 
+	//! Skip the silence at the start of the stream, returns the number of samples skipped.
+	template <typename Sample>
+	int SkipSilence(const Sample *input, int length);
+
 	bool m_start;
 	int m_threshold;
 	MovingAverage<int16_t> m_average;
@@ -30,13 +30,4 @@ uint32_t SimHash(const uint32_t *data, size_t size)
 	return hash;
 }
 
-uint32_t SimHash(const std::vector<uint32_t> &data)
-{
-	if (data.empty()) {
-		return 0;
-	} else {
-		return SimHash(&data[0], data.size());
-	}
-}
-
 }; // namespace chromaprint
@@ -11,7 +11,11 @@ namespace chromaprint {
 
 uint32_t SimHash(const uint32_t *data, size_t size);
 
-uint32_t SimHash(const std::vector<uint32_t> &data);
+template <typename Alloc>
+inline uint32_t SimHash(const std::vector<uint32_t, Alloc> &data)
+{
+	return SimHash(data.data(), data.size());
+}
 
 }; // namespace chromaprint
 
@@ -33,6 +33,19 @@ static inline double round(double x)
 }
 #endif
 
+//! Round a sample in the range of 16-bit integers and saturate it.
+inline int16_t RoundToInt16(float value)
+{
+	value = floorf(value + 0.5f);
+	if (value >= 32767.0f) {
+		return 32767;
+	}
+	if (value <= -32768.0f) {
+		return -32768;
+	}
+	return int16_t(value);
+}
+
 template<class RandomAccessIterator>
 void PrepareHammingWindow(RandomAccessIterator first, RandomAccessIterator last, double scale = 1.0)
 {
@@ -80,7 +93,7 @@ typename std::iterator_traits<Iterator>::value_type EuclideanNorm(Iterator first
 template<class Iterator, class Func>
 void NormalizeVector(Iterator first, Iterator last, Func func, double threshold = 0.01)
 {
-	double norm = func(first, last);
+	const auto norm = func(first, last);
 	if (norm < threshold) {
 		std::fill(first, last, 0.0);
 	}
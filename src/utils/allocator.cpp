@@ -0,0 +1,141 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <cassert>
+#include <cstdlib>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "utils/allocator.h"
+#include "chromaprint.h"
+
+namespace chromaprint {
+
+namespace {
+
+void *DefaultAllocate(void *, size_t size)
+{
+	return malloc(size);
+}
+
+void DefaultDeallocate(void *, void *ptr)
+{
+	free(ptr);
+}
+
+const ChromaprintAllocator g_default_allocator = { DefaultAllocate, DefaultDeallocate, nullptr, nullptr };
+
+// Allocate() runs on all threads, so it reads the allocator without locking,
+// through a pointer to an immutable copy. SetAllocator() publishes a new
+// copy, the old ones are kept, because another thread may still be reading
+// them. The allocator is rarely changed, so they don't take much memory.
+std::mutex g_allocator_mutex;
+std::vector<std::unique_ptr<const ChromaprintAllocator>> g_allocator_copies;
+std::atomic<const ChromaprintAllocator *> g_allocator(&g_default_allocator);
+
+thread_local MemoryCounter *g_memory_scope = nullptr;
+
+// Stored right before the memory returned by Allocate(), it records how to
+// free the block, so that the allocator can be replaced while blocks
+// allocated by the previous one are still in use.
+struct BlockHeader {
+	void (*deallocate)(void *user_data, void *ptr);
+	void *user_data;
+	void *base;
+	size_t size;
+	MemoryCounter *counter;
+};
+
+const ChromaprintAllocator &GetAllocator()
+{
+	return *g_allocator.load(std::memory_order_acquire);
+}
+
+};
+
+MemoryScope::MemoryScope(MemoryCounter *counter)
+	: m_previous(g_memory_scope)
+{
+	g_memory_scope = counter;
+}
+
+MemoryScope::~MemoryScope()
+{
+	g_memory_scope = m_previous;
+}
+
+MemoryCounter *MemoryScope::current()
+{
+	return g_memory_scope;
+}
+
+void *Allocate(size_t size, size_t alignment)
+{
+	assert((alignment & (alignment - 1)) == 0);
+	if (alignment < DEFAULT_ALIGNMENT) {
+		alignment = DEFAULT_ALIGNMENT;
+	}
+
+	const auto &allocator = GetAllocator();
+	const size_t header_size = (sizeof(BlockHeader) + alignment - 1) & ~(alignment - 1);
+	if (size > size_t(-1) - header_size - alignment) {
+		return nullptr;
+	}
+
+	void *base;
+	if (allocator.allocate_aligned) {
+		base = allocator.allocate_aligned(allocator.user_data, alignment, header_size + size);
+	} else {
+		// Blocks from the allocator are only aligned like malloc(), leave
+		// space for aligning the returned memory.
+		base = allocator.allocate(allocator.user_data, header_size + alignment - DEFAULT_ALIGNMENT + size);
+	}
+	if (!base) {
+		return nullptr;
+	}
+	const uintptr_t address = reinterpret_cast<uintptr_t>(base) + header_size;
+	char *ptr = static_cast<char *>(base) + (((address + alignment - 1) & ~uintptr_t(alignment - 1)) - reinterpret_cast<uintptr_t>(base));
+
+	auto header = reinterpret_cast<BlockHeader *>(ptr) - 1;
+	header->deallocate = allocator.deallocate;
+	header->user_data = allocator.user_data;
+	header->base = base;
+	header->size = size;
+	header->counter = g_memory_scope;
+	if (header->counter) {
+		header->counter->Ref();
+		header->counter->Add(size);
+	}
+	return ptr;
+}
+
+void Deallocate(void *ptr)
+{
+	if (!ptr) {
+		return;
+	}
+	auto header = static_cast<BlockHeader *>(ptr) - 1;
+	if (header->counter) {
+		header->counter->Remove(header->size);
+		header->counter->Unref();
+	}
+	header->deallocate(header->user_data, header->base);
+}
+
+bool SetAllocator(const ChromaprintAllocator *allocator)
+{
+	if (allocator && (!allocator->allocate || !allocator->deallocate)) {
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(g_allocator_mutex);
+	if (!allocator) {
+		g_allocator.store(&g_default_allocator, std::memory_order_release);
+		return true;
+	}
+	g_allocator_copies.emplace_back(new ChromaprintAllocator(*allocator));
+	g_allocator.store(g_allocator_copies.back().get(), std::memory_order_release);
+	return true;
+}
+
+}; // namespace chromaprint
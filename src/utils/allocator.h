@@ -0,0 +1,172 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_UTILS_ALLOCATOR_H_
+#define CHROMAPRINT_UTILS_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <new>
+#include <vector>
+#include "utils.h"
+
+struct ChromaprintAllocator;
+
+namespace chromaprint {
+
+//! Alignment of all memory returned by Allocate(), like malloc().
+static const size_t DEFAULT_ALIGNMENT = alignof(std::max_align_t);
+
+//! Alignment of buffers processed with SIMD instructions.
+static const size_t SIMD_ALIGNMENT = 64;
+
+/**
+ * Counts the memory allocated while it's set as the current memory scope,
+ * see MemoryScope.
+ *
+ * Every allocated block keeps a reference to the counter, so the memory is
+ * subtracted from the right counter no matter which thread frees it, even
+ * after its owner released the counter.
+ */
+class MemoryCounter
+{
+public:
+	//! Create a counter with a single reference.
+	static MemoryCounter *Create() { return new MemoryCounter(); }
+
+	void Ref() { m_refs.fetch_add(1, std::memory_order_relaxed); }
+	void Unref() {
+		if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			delete this;
+		}
+	}
+
+	//! Number of bytes that are currently allocated.
+	size_t current() const { return m_current.load(std::memory_order_relaxed); }
+
+	//! Highest number of bytes that were allocated at the same time.
+	size_t peak() const { return m_peak.load(std::memory_order_relaxed); }
+
+	void Add(size_t size) {
+		const size_t current = m_current.fetch_add(size, std::memory_order_relaxed) + size;
+		size_t peak = m_peak.load(std::memory_order_relaxed);
+		while (current > peak && !m_peak.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+		}
+	}
+
+	void Remove(size_t size) { m_current.fetch_sub(size, std::memory_order_relaxed); }
+
+	//! Start measuring the peak again from the current usage.
+	void ResetPeak() { m_peak.store(current(), std::memory_order_relaxed); }
+
+private:
+	CHROMAPRINT_DISABLE_COPY(MemoryCounter);
+
+	MemoryCounter() {}
+
+	std::atomic<int> m_refs { 1 };
+	std::atomic<size_t> m_current { 0 };
+	std::atomic<size_t> m_peak { 0 };
+};
+
+/**
+ * Sets the counter for all memory allocated by this thread while the scope
+ * exists, scopes can be nested. A null counter means the memory is not
+ * counted at all.
+ */
+class MemoryScope
+{
+public:
+	explicit MemoryScope(MemoryCounter *counter);
+	~MemoryScope();
+
+	//! Counter of the innermost scope on this thread, or nullptr.
+	static MemoryCounter *current();
+
+private:
+	CHROMAPRINT_DISABLE_COPY(MemoryScope);
+
+	MemoryCounter *m_previous;
+};
+
+/**
+ * Allocate memory with the allocator set by chromaprint_set_allocator() and
+ * add it to the counter of the current memory scope. The alignment must be
+ * a power of two. Returns nullptr if the allocation fails.
+ */
+void *Allocate(size_t size, size_t alignment = DEFAULT_ALIGNMENT);
+
+//! Free memory returned by Allocate(), with the allocator it was allocated with.
+void Deallocate(void *ptr);
+
+//! Replace the allocator used by Allocate(), nullptr restores malloc() and free().
+bool SetAllocator(const ChromaprintAllocator *allocator);
+
+//! Like Allocate(), but throws std::bad_alloc if the allocation fails.
+inline void *AllocateOrThrow(size_t size, size_t alignment = DEFAULT_ALIGNMENT) {
+	void *ptr = Allocate(size, alignment);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+/**
+ * Standard library allocator that uses Allocate(), the alignment is at
+ * least Alignment bytes.
+ */
+template <typename T, size_t Alignment = DEFAULT_ALIGNMENT>
+class Allocator
+{
+public:
+	typedef T value_type;
+
+	template <typename U>
+	struct rebind {
+		typedef Allocator<U, Alignment> other;
+	};
+
+	Allocator() noexcept {}
+
+	template <typename U>
+	Allocator(const Allocator<U, Alignment> &) noexcept {}
+
+	T *allocate(size_t n) {
+		if (n > size_t(-1) / sizeof(T)) {
+			throw std::bad_alloc();
+		}
+		return static_cast<T *>(AllocateOrThrow(n * sizeof(T), Alignment > alignof(T) ? Alignment : alignof(T)));
+	}
+
+	void deallocate(T *ptr, size_t) noexcept {
+		Deallocate(ptr);
+	}
+};
+
+template <typename T, typename U, size_t Alignment>
+inline bool operator==(const Allocator<T, Alignment> &, const Allocator<U, Alignment> &) { return true; }
+
+template <typename T, typename U, size_t Alignment>
+inline bool operator!=(const Allocator<T, Alignment> &, const Allocator<U, Alignment> &) { return false; }
+
+//! Vector whose memory is allocated with Allocate().
+template <typename T, size_t Alignment = DEFAULT_ALIGNMENT>
+using Vector = std::vector<T, Allocator<T, Alignment>>;
+
+/**
+ * Base class for objects that are allocated with Allocate() when they are
+ * created with new.
+ */
+class Allocated
+{
+public:
+	static void *operator new(size_t size) { return AllocateOrThrow(size); }
+	static void *operator new[](size_t size) { return AllocateOrThrow(size); }
+	static void operator delete(void *ptr) noexcept { Deallocate(ptr); }
+	static void operator delete[](void *ptr) noexcept { Deallocate(ptr); }
+};
+
+}; // namespace chromaprint
+
+#endif
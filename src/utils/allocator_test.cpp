@@ -0,0 +1,122 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include "utils/allocator.h"
+#include "utils/scope_exit.h"
+#include "chromaprint.h"
+
+namespace chromaprint {
+
+namespace {
+
+struct CountingAllocator {
+	int num_allocations = 0;
+	int num_aligned_allocations = 0;
+	int num_deallocations = 0;
+};
+
+void *CountingAllocate(void *user_data, size_t size)
+{
+	static_cast<CountingAllocator *>(user_data)->num_allocations++;
+	return malloc(size);
+}
+
+void *CountingAllocateAligned(void *user_data, size_t alignment, size_t size)
+{
+	static_cast<CountingAllocator *>(user_data)->num_aligned_allocations++;
+	void *ptr = nullptr;
+	return posix_memalign(&ptr, alignment, size) == 0 ? ptr : nullptr;
+}
+
+void CountingDeallocate(void *user_data, void *ptr)
+{
+	static_cast<CountingAllocator *>(user_data)->num_deallocations++;
+	free(ptr);
+}
+
+bool IsAligned(const void *ptr, size_t alignment)
+{
+	return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+}; // namespace
+
+TEST(AllocatorTest, Alignment) {
+	for (size_t alignment : { size_t(1), size_t(16), size_t(64), size_t(4096) }) {
+		for (size_t size : { size_t(0), size_t(1), size_t(1000) }) {
+			void *ptr = Allocate(size, alignment);
+			ASSERT_NE(nullptr, ptr);
+			ASSERT_TRUE(IsAligned(ptr, std::max(alignment, DEFAULT_ALIGNMENT)));
+			std::fill_n(static_cast<char *>(ptr), size, 1);
+			Deallocate(ptr);
+		}
+	}
+
+	Vector<float, SIMD_ALIGNMENT> vector(100);
+	ASSERT_TRUE(IsAligned(vector.data(), SIMD_ALIGNMENT));
+}
+
+TEST(AllocatorTest, MemoryScope) {
+	MemoryCounter *counter = MemoryCounter::Create();
+	void *a;
+	void *b;
+	void *c;
+	{
+		MemoryScope scope(counter);
+		ASSERT_EQ(counter, MemoryScope::current());
+		a = Allocate(100);
+		b = Allocate(50);
+		{
+			MemoryScope inner(nullptr);
+			c = Allocate(1000);
+		}
+		ASSERT_EQ(counter, MemoryScope::current());
+	}
+	ASSERT_EQ(nullptr, MemoryScope::current());
+	ASSERT_EQ(150, counter->current());
+	ASSERT_EQ(150, counter->peak());
+
+	Deallocate(a);
+	Deallocate(c);
+	ASSERT_EQ(50, counter->current());
+	ASSERT_EQ(150, counter->peak());
+	counter->ResetPeak();
+	ASSERT_EQ(50, counter->peak());
+
+	// the block keeps the counter alive
+	counter->Unref();
+	Deallocate(b);
+}
+
+TEST(AllocatorTest, CustomAllocator) {
+	SCOPE_EXIT(SetAllocator(nullptr));
+
+	CountingAllocator counts;
+	ChromaprintAllocator allocator = { CountingAllocate, CountingDeallocate, nullptr, &counts };
+	ASSERT_TRUE(SetAllocator(&allocator));
+	void *a = Allocate(10);
+	void *b = Allocate(10, 256);
+	ASSERT_TRUE(IsAligned(b, 256));
+	ASSERT_EQ(2, counts.num_allocations);
+
+	allocator.allocate_aligned = CountingAllocateAligned;
+	ASSERT_TRUE(SetAllocator(&allocator));
+	void *c = Allocate(10, 256);
+	ASSERT_TRUE(IsAligned(c, 256));
+	ASSERT_EQ(2, counts.num_allocations);
+	ASSERT_EQ(1, counts.num_aligned_allocations);
+
+	// blocks are freed by the allocator that allocated them
+	ASSERT_TRUE(SetAllocator(nullptr));
+	Deallocate(a);
+	Deallocate(b);
+	Deallocate(c);
+	ASSERT_EQ(3, counts.num_deallocations);
+
+	allocator.deallocate = nullptr;
+	ASSERT_FALSE(SetAllocator(&allocator));
+}
+
+}; // namespace chromaprint
@@ -0,0 +1,129 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include "utils/bit_errors.h"
+#include "utils.h"
+
+#ifdef CHROMAPRINT_ARCH_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace chromaprint {
+
+void ComputeBitErrors_Generic(const uint32_t *fp1, const uint32_t *fp2, size_t size, float *bit_errors)
+{
+	for (size_t i = 0; i < size; i++) {
+		bit_errors[i] = float(HammingDistance(fp1[i], fp2[i])) + BitErrorsJitter(i);
+	}
+}
+
+#ifdef CHROMAPRINT_ARCH_X86
+
+CHROMAPRINT_TARGET("popcnt")
+void ComputeBitErrors_Popcnt(const uint32_t *fp1, const uint32_t *fp2, size_t size, float *bit_errors)
+{
+	for (size_t i = 0; i < size; i++) {
+#ifdef _MSC_VER
+		const unsigned int count = __popcnt(fp1[i] ^ fp2[i]);
+#else
+		const unsigned int count = __builtin_popcount(fp1[i] ^ fp2[i]);
+#endif
+		bit_errors[i] = float(count) + BitErrorsJitter(i);
+	}
+}
+
+CHROMAPRINT_TARGET("avx2")
+void ComputeBitErrors_AVX2(const uint32_t *fp1, const uint32_t *fp2, size_t size, float *bit_errors)
+{
+	// Per-byte popcount via a nibble lookup table, the bytes are then summed
+	// into 32-bit lanes with two multiply-add steps.
+	const __m256i lookup = _mm256_setr_epi8(
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low_mask = _mm256_set1_epi8(0x0f);
+	const __m256i ones_u8 = _mm256_set1_epi8(1);
+	const __m256i ones_i16 = _mm256_set1_epi16(1);
+	const __m256i hash_mul = _mm256_set1_epi32(int(2654435761u));
+	const __m256 jitter_scale = _mm256_set1_ps(CHROMAPRINT_BIT_ERRORS_JITTER_SCALE);
+	const __m256i index_step = _mm256_set1_epi32(8);
+	__m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(fp1 + i));
+		const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(fp2 + i));
+		const __m256i x = _mm256_xor_si256(a, b);
+		const __m256i lo = _mm256_and_si256(x, low_mask);
+		const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), low_mask);
+		const __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+		const __m256i counts = _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, ones_u8), ones_i16);
+		const __m256i hash = _mm256_srli_epi32(_mm256_mullo_epi32(index, hash_mul), 22);
+		const __m256 jitter = _mm256_mul_ps(_mm256_cvtepi32_ps(hash), jitter_scale);
+		_mm256_storeu_ps(bit_errors + i, _mm256_add_ps(_mm256_cvtepi32_ps(counts), jitter));
+		index = _mm256_add_epi32(index, index_step);
+	}
+	for (; i < size; i++) {
+		bit_errors[i] = float(HammingDistance(fp1[i], fp2[i])) + BitErrorsJitter(i);
+	}
+}
+
+CHROMAPRINT_TARGET("avx512f,avx512vpopcntdq")
+void ComputeBitErrors_AVX512(const uint32_t *fp1, const uint32_t *fp2, size_t size, float *bit_errors)
+{
+	const __m512i hash_mul = _mm512_set1_epi32(int(2654435761u));
+	const __m512 jitter_scale = _mm512_set1_ps(CHROMAPRINT_BIT_ERRORS_JITTER_SCALE);
+	const __m512i index_step = _mm512_set1_epi32(16);
+	__m512i index = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+	// The tail is handled with a masked iteration, so there is no scalar loop.
+	for (size_t i = 0; i < size; i += 16) {
+		const size_t remaining = size - i;
+		const __mmask16 mask = remaining >= 16 ? __mmask16(0xffff) : __mmask16((1u << remaining) - 1);
+		const __m512i a = _mm512_maskz_loadu_epi32(mask, fp1 + i);
+		const __m512i b = _mm512_maskz_loadu_epi32(mask, fp2 + i);
+		const __m512i counts = _mm512_popcnt_epi32(_mm512_xor_si512(a, b));
+		// The zero-masked forms of the shift and conversion compute the same
+		// lanes that are stored, but unlike the unmasked ones, they don't make
+		// GCC warn about an uninitialized source.
+		const __m512i hash = _mm512_maskz_srli_epi32(mask, _mm512_mullo_epi32(index, hash_mul), 22);
+		const __m512 jitter = _mm512_mul_ps(_mm512_maskz_cvtepi32_ps(mask, hash), jitter_scale);
+		_mm512_mask_storeu_ps(bit_errors + i, mask, _mm512_add_ps(_mm512_maskz_cvtepi32_ps(mask, counts), jitter));
+		index = _mm512_add_epi32(index, index_step);
+	}
+}
+
+#endif
+
+namespace {
+
+typedef void (*ComputeBitErrorsFunc)(const uint32_t *fp1, const uint32_t *fp2, size_t size, float *bit_errors);
+
+ComputeBitErrorsFunc SelectComputeBitErrors()
+{
+#ifdef CHROMAPRINT_ARCH_X86
+	const auto &cpu = GetCpuFeatures();
+	if (cpu.avx512f && cpu.avx512vpopcntdq) {
+		return ComputeBitErrors_AVX512;
+	}
+	if (cpu.avx2) {
+		return ComputeBitErrors_AVX2;
+	}
+	if (cpu.popcnt) {
+		return ComputeBitErrors_Popcnt;
+	}
+#endif
+	return ComputeBitErrors_Generic;
+}
+
+}; // namespace
+
+void ComputeBitErrors(const uint32_t *fp1, const uint32_t *fp2, size_t size, float *bit_errors)
+{
+	static const ComputeBitErrorsFunc func = SelectComputeBitErrors();
+	func(fp1, fp2, size, bit_errors);
+}
+
+}; // namespace chromaprint
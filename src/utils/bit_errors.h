@@ -0,0 +1,44 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_UTILS_BIT_ERRORS_H_
+#define CHROMAPRINT_UTILS_BIT_ERRORS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "utils/cpu_features.h"
+
+namespace chromaprint {
+
+// Small amount of noise added to the bit error counts, so that the gradient
+// of a constant series is not exactly zero. It used to come from rand(), now
+// it's a hash of the index, which makes matching results reproducible.
+#define CHROMAPRINT_BIT_ERRORS_JITTER_SCALE (0.001f / 1024)
+
+inline float BitErrorsJitter(size_t i)
+{
+	return float((uint32_t(i) * 2654435761u) >> 22) * CHROMAPRINT_BIT_ERRORS_JITTER_SCALE;
+}
+
+/**
+ * Compute the number of differing bits between two aligned fingerprints,
+ * plus a deterministic jitter, for every position.
+ *
+ * bit_errors[i] = HammingDistance(fp1[i], fp2[i]) + BitErrorsJitter(i)
+ *
+ * The best implementation available on the CPU is selected at runtime.
+ */
+void ComputeBitErrors(const uint32_t *fp1, const uint32_t *fp2, size_t size, float *bit_errors);
+
+// Individual implementations, only exposed for testing and benchmarking.
+// The caller is responsible for checking that the CPU supports them.
+void ComputeBitErrors_Generic(const uint32_t *fp1, const uint32_t *fp2, size_t size, float *bit_errors);
+#ifdef CHROMAPRINT_ARCH_X86
+void ComputeBitErrors_Popcnt(const uint32_t *fp1, const uint32_t *fp2, size_t size, float *bit_errors);
+void ComputeBitErrors_AVX2(const uint32_t *fp1, const uint32_t *fp2, size_t size, float *bit_errors);
+void ComputeBitErrors_AVX512(const uint32_t *fp1, const uint32_t *fp2, size_t size, float *bit_errors);
+#endif
+
+}; // namespace chromaprint
+
+#endif
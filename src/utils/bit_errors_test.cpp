@@ -0,0 +1,83 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include "utils/bit_errors.h"
+#include "utils.h"
+
+namespace chromaprint {
+
+namespace {
+
+typedef void (*ComputeBitErrorsFunc)(const uint32_t *fp1, const uint32_t *fp2, size_t size, float *bit_errors);
+
+void CheckImplementation(ComputeBitErrorsFunc func)
+{
+	std::mt19937 rng(1234);
+	for (size_t size : { 0, 1, 7, 8, 15, 16, 17, 31, 100, 1000 }) {
+		std::vector<uint32_t> fp1(size), fp2(size);
+		for (size_t i = 0; i < size; i++) {
+			fp1[i] = rng();
+			fp2[i] = rng();
+		}
+		if (size > 2) {
+			fp2[0] = fp1[0];
+			fp2[1] = ~fp1[1];
+		}
+		std::vector<float> expected(size), actual(size);
+		ComputeBitErrors_Generic(fp1.data(), fp2.data(), size, expected.data());
+		func(fp1.data(), fp2.data(), size, actual.data());
+		for (size_t i = 0; i < size; i++) {
+			ASSERT_EQ(expected[i], actual[i]) << "size=" << size << " i=" << i;
+		}
+	}
+}
+
+}; // namespace
+
+TEST(BitErrorsTest, Generic) {
+	const uint32_t fp1[] = { 0, 0xffffffff, 0x0f0f0f0f, 123 };
+	const uint32_t fp2[] = { 0, 0, 0xf0f0f0f0, 123 };
+	float bit_errors[4];
+	ComputeBitErrors_Generic(fp1, fp2, 4, bit_errors);
+	EXPECT_FLOAT_EQ(0.0f, bit_errors[0]);
+	EXPECT_NEAR(32.0f, bit_errors[1], 0.001f);
+	EXPECT_NEAR(32.0f, bit_errors[2], 0.001f);
+	EXPECT_NEAR(0.0f, bit_errors[3], 0.001f);
+	for (size_t i = 0; i < 4; i++) {
+		EXPECT_EQ(float(HammingDistance(fp1[i], fp2[i])) + BitErrorsJitter(i), bit_errors[i]);
+	}
+}
+
+TEST(BitErrorsTest, Dispatch) {
+	CheckImplementation(ComputeBitErrors);
+}
+
+#ifdef CHROMAPRINT_ARCH_X86
+
+TEST(BitErrorsTest, Popcnt) {
+	if (!GetCpuFeatures().popcnt) {
+		GTEST_SKIP() << "POPCNT not supported";
+	}
+	CheckImplementation(ComputeBitErrors_Popcnt);
+}
+
+TEST(BitErrorsTest, AVX2) {
+	if (!GetCpuFeatures().avx2) {
+		GTEST_SKIP() << "AVX2 not supported";
+	}
+	CheckImplementation(ComputeBitErrors_AVX2);
+}
+
+TEST(BitErrorsTest, AVX512) {
+	if (!GetCpuFeatures().avx512f || !GetCpuFeatures().avx512vpopcntdq) {
+		GTEST_SKIP() << "AVX-512 VPOPCNTDQ not supported";
+	}
+	CheckImplementation(ComputeBitErrors_AVX512);
+}
+
+#endif
+
+}; // namespace chromaprint
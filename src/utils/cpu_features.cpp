@@ -0,0 +1,62 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include "utils/cpu_features.h"
+
+#if defined(CHROMAPRINT_ARCH_X86) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace chromaprint {
+
+namespace {
+
+CpuFeatures DetectCpuFeatures()
+{
+	CpuFeatures features;
+#if defined(CHROMAPRINT_ARCH_X86)
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_cpu_init();
+	features.sse2 = __builtin_cpu_supports("sse2");
+	features.sse42 = __builtin_cpu_supports("sse4.2");
+	features.popcnt = __builtin_cpu_supports("popcnt");
+	features.avx2 = __builtin_cpu_supports("avx2");
+	features.avx512f = __builtin_cpu_supports("avx512f");
+	features.avx512bw = __builtin_cpu_supports("avx512bw");
+	features.avx512vpopcntdq = __builtin_cpu_supports("avx512vpopcntdq");
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int max_leaf = info[0];
+	__cpuid(info, 1);
+	features.sse2 = (info[3] & (1 << 26)) != 0;
+	features.sse42 = (info[2] & (1 << 20)) != 0;
+	features.popcnt = (info[2] & (1 << 23)) != 0;
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+	const bool os_avx = (xcr0 & 0x6) == 0x6;
+	const bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+	if (max_leaf >= 7) {
+		__cpuidex(info, 7, 0);
+		features.avx2 = os_avx && (info[1] & (1 << 5)) != 0;
+		features.avx512f = os_avx512 && (info[1] & (1 << 16)) != 0;
+		features.avx512bw = os_avx512 && (info[1] & (1 << 30)) != 0;
+		features.avx512vpopcntdq = os_avx512 && (info[2] & (1 << 14)) != 0;
+	}
+#endif
+#elif defined(CHROMAPRINT_ARCH_NEON)
+	features.neon = true;
+#endif
+	return features;
+}
+
+}; // namespace
+
+const CpuFeatures &GetCpuFeatures()
+{
+	static const CpuFeatures features = DetectCpuFeatures();
+	return features;
+}
+
+}; // namespace chromaprint
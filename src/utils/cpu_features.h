@@ -0,0 +1,43 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_UTILS_CPU_FEATURES_H_
+#define CHROMAPRINT_UTILS_CPU_FEATURES_H_
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CHROMAPRINT_ARCH_X86 1
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64) || (defined(__ARM_NEON) && defined(__arm__))
+#define CHROMAPRINT_ARCH_NEON 1
+#endif
+
+// Enables an instruction set for a single function, so that SIMD kernels can
+// live next to the generic code and be selected at runtime. MSVC allows the
+// intrinsics to be used without any special flags.
+#if defined(__GNUC__) || defined(__clang__)
+#define CHROMAPRINT_TARGET(x) __attribute__((target(x)))
+#else
+#define CHROMAPRINT_TARGET(x)
+#endif
+
+namespace chromaprint {
+
+struct CpuFeatures
+{
+	bool sse2 = false;
+	bool sse42 = false;
+	bool popcnt = false;
+	bool avx2 = false;
+	bool avx512f = false;
+	bool avx512bw = false;
+	bool avx512vpopcntdq = false;
+	bool neon = false;
+};
+
+//! Features supported by the CPU and the OS, detected once on first use.
+const CpuFeatures &GetCpuFeatures();
+
+}; // namespace chromaprint
+
+#endif
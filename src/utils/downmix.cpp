@@ -0,0 +1,279 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <algorithm>
+#include "utils/downmix.h"
+
+#ifdef CHROMAPRINT_ARCH_X86
+#include <immintrin.h>
+#endif
+
+#ifdef CHROMAPRINT_ARCH_NEON
+#include <arm_neon.h>
+#endif
+
+namespace chromaprint {
+
+namespace {
+
+void DownmixMono(const int16_t *input, int16_t *output, size_t length)
+{
+	std::copy(input, input + length, output);
+}
+
+void DownmixStereo_Generic(const int16_t *input, int16_t *output, size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; i++) {
+		output[i] = int16_t((input[2 * i] + input[2 * i + 1]) / 2);
+	}
+}
+
+// With the number of channels known at compile time, the inner loop is
+// unrolled and the division is replaced by a multiplication.
+template <int N>
+void DownmixFixed_Generic(const int16_t *input, int16_t *output, size_t begin, size_t end)
+{
+	input += begin * N;
+	for (size_t i = begin; i < end; i++) {
+		int32_t sum = 0;
+		for (int j = 0; j < N; j++) {
+			sum += input[j];
+		}
+		output[i] = int16_t(sum / N);
+		input += N;
+	}
+}
+
+void DownmixMultiChannel_Generic(const int16_t *input, int16_t *output, size_t begin, size_t end, int num_channels)
+{
+	switch (num_channels) {
+	case 3: DownmixFixed_Generic<3>(input, output, begin, end); return;
+	case 4: DownmixFixed_Generic<4>(input, output, begin, end); return;
+	case 5: DownmixFixed_Generic<5>(input, output, begin, end); return;
+	case 6: DownmixFixed_Generic<6>(input, output, begin, end); return;
+	case 7: DownmixFixed_Generic<7>(input, output, begin, end); return;
+	case 8: DownmixFixed_Generic<8>(input, output, begin, end); return;
+	}
+	input += begin * num_channels;
+	for (size_t i = begin; i < end; i++) {
+		int32_t sum = 0;
+		for (int j = 0; j < num_channels; j++) {
+			sum += *input++;
+		}
+		output[i] = int16_t(sum / num_channels);
+	}
+}
+
+}; // namespace
+
+void Downmix_Generic(const int16_t *input, int16_t *output, size_t length, int num_channels)
+{
+	switch (num_channels) {
+	case 1:
+		DownmixMono(input, output, length);
+		break;
+	case 2:
+		DownmixStereo_Generic(input, output, 0, length);
+		break;
+	default:
+		DownmixMultiChannel_Generic(input, output, 0, length, num_channels);
+		break;
+	}
+}
+
+#ifdef CHROMAPRINT_ARCH_X86
+
+namespace {
+
+// Divide eight sums of N samples, with rounding towards zero, and store
+// them as 16-bit values. A float division gives the same result as integer
+// division here, because the sums are exactly representable and a quotient
+// that is not an integer is at least 1/N away from one.
+template <int N>
+CHROMAPRINT_TARGET("avx2")
+inline void StoreAverage_AVX2(int16_t *output, __m256i sum)
+{
+	__m256i avg;
+	if ((N & (N - 1)) == 0) {
+		const int shift = N == 2 ? 1 : N == 4 ? 2 : 3;
+		const __m256i bias = _mm256_srli_epi32(_mm256_srai_epi32(sum, 31), 32 - shift);
+		avg = _mm256_srai_epi32(_mm256_add_epi32(sum, bias), shift);
+	} else {
+		avg = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(sum), _mm256_set1_ps(float(N))));
+	}
+	const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(avg, avg), _MM_SHUFFLE(3, 1, 2, 0));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(output), _mm256_castsi256_si128(packed));
+}
+
+}; // namespace
+
+CHROMAPRINT_TARGET("sse2")
+void Downmix_SSE2(const int16_t *input, int16_t *output, size_t length, int num_channels)
+{
+	size_t i = 0;
+	if (num_channels == 1) {
+		DownmixMono(input, output, length);
+		return;
+	} else if (num_channels == 2) {
+		// Adjacent samples are summed into 32-bit lanes by multiply-add, the
+		// sums are divided by shifting, with rounding towards zero.
+		const __m128i ones = _mm_set1_epi16(1);
+		for (; i + 8 <= length; i += 8) {
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + 2 * i));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + 2 * i + 8));
+			__m128i sa = _mm_madd_epi16(a, ones);
+			__m128i sb = _mm_madd_epi16(b, ones);
+			sa = _mm_srai_epi32(_mm_add_epi32(sa, _mm_srli_epi32(sa, 31)), 1);
+			sb = _mm_srai_epi32(_mm_add_epi32(sb, _mm_srli_epi32(sb, 31)), 1);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), _mm_packs_epi32(sa, sb));
+		}
+		DownmixStereo_Generic(input, output, i, length);
+	} else {
+		DownmixMultiChannel_Generic(input, output, 0, length, num_channels);
+	}
+}
+
+CHROMAPRINT_TARGET("avx2")
+void Downmix_AVX2(const int16_t *input, int16_t *output, size_t length, int num_channels)
+{
+	size_t i = 0;
+	if (num_channels == 1) {
+		DownmixMono(input, output, length);
+		return;
+	} else if (num_channels == 2) {
+		const __m256i ones = _mm256_set1_epi16(1);
+		for (; i + 16 <= length; i += 16) {
+			const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + 2 * i));
+			const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + 2 * i + 16));
+			__m256i sa = _mm256_madd_epi16(a, ones);
+			__m256i sb = _mm256_madd_epi16(b, ones);
+			sa = _mm256_srai_epi32(_mm256_add_epi32(sa, _mm256_srli_epi32(sa, 31)), 1);
+			sb = _mm256_srai_epi32(_mm256_add_epi32(sb, _mm256_srli_epi32(sb, 31)), 1);
+			// packs works within 128-bit lanes, put the 64-bit blocks back in order
+			const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(sa, sb), _MM_SHUFFLE(3, 1, 2, 0));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i), packed);
+		}
+		DownmixStereo_Generic(input, output, i, length);
+	} else if (num_channels == 4) {
+		// Pairs of samples are summed by multiply-add, and the pairs by
+		// horizontal add, which gives frames 0, 1, 4, 5, 2, 3, 6, 7.
+		const __m256i ones = _mm256_set1_epi16(1);
+		const __m256i order = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+		for (; i + 8 <= length; i += 8) {
+			const __m256i *ptr = reinterpret_cast<const __m256i *>(input + 4 * i);
+			const __m256i a = _mm256_madd_epi16(_mm256_loadu_si256(ptr), ones);
+			const __m256i b = _mm256_madd_epi16(_mm256_loadu_si256(ptr + 1), ones);
+			const __m256i sum = _mm256_permutevar8x32_epi32(_mm256_hadd_epi32(a, b), order);
+			StoreAverage_AVX2<4>(output + i, sum);
+		}
+		DownmixMultiChannel_Generic(input, output, i, length, num_channels);
+	} else if (num_channels == 6) {
+		// Pairs of samples are summed by multiply-add, every frame is then
+		// three consecutive pairs, which are collected into three vectors.
+		const __m256i ones = _mm256_set1_epi16(1);
+		const __m256i idx_a0 = _mm256_setr_epi32(0, 3, 6, 0, 0, 0, 0, 0);
+		const __m256i idx_a1 = _mm256_setr_epi32(1, 4, 7, 0, 0, 0, 0, 0);
+		const __m256i idx_a2 = _mm256_setr_epi32(2, 5, 0, 0, 0, 0, 0, 0);
+		const __m256i idx_b0 = _mm256_setr_epi32(0, 0, 0, 1, 4, 7, 0, 0);
+		const __m256i idx_b1 = _mm256_setr_epi32(0, 0, 0, 2, 5, 0, 0, 0);
+		const __m256i idx_b2 = _mm256_setr_epi32(0, 0, 0, 3, 6, 0, 0, 0);
+		const __m256i idx_c0 = _mm256_setr_epi32(0, 0, 0, 0, 0, 0, 2, 5);
+		const __m256i idx_c1 = _mm256_setr_epi32(0, 0, 0, 0, 0, 0, 3, 6);
+		const __m256i idx_c2 = _mm256_setr_epi32(0, 0, 0, 0, 0, 1, 4, 7);
+		for (; i + 8 <= length; i += 8) {
+			const __m256i *ptr = reinterpret_cast<const __m256i *>(input + 6 * i);
+			const __m256i a = _mm256_madd_epi16(_mm256_loadu_si256(ptr), ones);
+			const __m256i b = _mm256_madd_epi16(_mm256_loadu_si256(ptr + 1), ones);
+			const __m256i c = _mm256_madd_epi16(_mm256_loadu_si256(ptr + 2), ones);
+			const __m256i x = _mm256_blend_epi32(_mm256_blend_epi32(
+				_mm256_permutevar8x32_epi32(a, idx_a0),
+				_mm256_permutevar8x32_epi32(b, idx_b0), 0x38),
+				_mm256_permutevar8x32_epi32(c, idx_c0), 0xc0);
+			const __m256i y = _mm256_blend_epi32(_mm256_blend_epi32(
+				_mm256_permutevar8x32_epi32(a, idx_a1),
+				_mm256_permutevar8x32_epi32(b, idx_b1), 0x18),
+				_mm256_permutevar8x32_epi32(c, idx_c1), 0xe0);
+			const __m256i z = _mm256_blend_epi32(_mm256_blend_epi32(
+				_mm256_permutevar8x32_epi32(a, idx_a2),
+				_mm256_permutevar8x32_epi32(b, idx_b2), 0x1c),
+				_mm256_permutevar8x32_epi32(c, idx_c2), 0xe0);
+			StoreAverage_AVX2<6>(output + i, _mm256_add_epi32(_mm256_add_epi32(x, y), z));
+		}
+		DownmixMultiChannel_Generic(input, output, i, length, num_channels);
+	} else if (num_channels == 8) {
+		// Two rounds of horizontal add give frames 0, 2, 4, 6, 1, 3, 5, 7.
+		const __m256i ones = _mm256_set1_epi16(1);
+		const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+		for (; i + 8 <= length; i += 8) {
+			const __m256i *ptr = reinterpret_cast<const __m256i *>(input + 8 * i);
+			const __m256i a = _mm256_madd_epi16(_mm256_loadu_si256(ptr), ones);
+			const __m256i b = _mm256_madd_epi16(_mm256_loadu_si256(ptr + 1), ones);
+			const __m256i c = _mm256_madd_epi16(_mm256_loadu_si256(ptr + 2), ones);
+			const __m256i d = _mm256_madd_epi16(_mm256_loadu_si256(ptr + 3), ones);
+			const __m256i sum = _mm256_hadd_epi32(_mm256_hadd_epi32(a, b), _mm256_hadd_epi32(c, d));
+			StoreAverage_AVX2<8>(output + i, _mm256_permutevar8x32_epi32(sum, order));
+		}
+		DownmixMultiChannel_Generic(input, output, i, length, num_channels);
+	} else {
+		DownmixMultiChannel_Generic(input, output, 0, length, num_channels);
+	}
+}
+
+#endif
+
+#ifdef CHROMAPRINT_ARCH_NEON
+
+void Downmix_NEON(const int16_t *input, int16_t *output, size_t length, int num_channels)
+{
+	size_t i = 0;
+	if (num_channels == 1) {
+		DownmixMono(input, output, length);
+		return;
+	} else if (num_channels == 2) {
+		for (; i + 8 <= length; i += 8) {
+			const int16x8x2_t x = vld2q_s16(input + 2 * i);
+			int32x4_t lo = vaddl_s16(vget_low_s16(x.val[0]), vget_low_s16(x.val[1]));
+			int32x4_t hi = vaddl_s16(vget_high_s16(x.val[0]), vget_high_s16(x.val[1]));
+			lo = vshrq_n_s32(vaddq_s32(lo, vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(lo), 31))), 1);
+			hi = vshrq_n_s32(vaddq_s32(hi, vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(hi), 31))), 1);
+			vst1q_s16(output + i, vcombine_s16(vmovn_s32(lo), vmovn_s32(hi)));
+		}
+		DownmixStereo_Generic(input, output, i, length);
+	} else {
+		DownmixMultiChannel_Generic(input, output, 0, length, num_channels);
+	}
+}
+
+#endif
+
+namespace {
+
+typedef void (*DownmixFunc)(const int16_t *input, int16_t *output, size_t length, int num_channels);
+
+DownmixFunc SelectDownmix()
+{
+#ifdef CHROMAPRINT_ARCH_X86
+	const auto &cpu = GetCpuFeatures();
+	if (cpu.avx2) {
+		return Downmix_AVX2;
+	}
+	if (cpu.sse2) {
+		return Downmix_SSE2;
+	}
+#endif
+#ifdef CHROMAPRINT_ARCH_NEON
+	return Downmix_NEON;
+#else
+	return Downmix_Generic;
+#endif
+}
+
+}; // namespace
+
+void Downmix(const int16_t *input, int16_t *output, size_t length, int num_channels)
+{
+	static const DownmixFunc func = SelectDownmix();
+	func(input, output, length, num_channels);
+}
+
+}; // namespace chromaprint
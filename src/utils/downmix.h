@@ -0,0 +1,37 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_UTILS_DOWNMIX_H_
+#define CHROMAPRINT_UTILS_DOWNMIX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "utils/cpu_features.h"
+
+namespace chromaprint {
+
+/**
+ * Convert interleaved 16-bit audio to mono by averaging the channels.
+ *
+ * output[i] = (input[i * n] + ... + input[i * n + n - 1]) / n
+ *
+ * The division truncates towards zero, all implementations produce
+ * exactly the same output. The best implementation available on the CPU
+ * is selected at runtime. Length is the number of frames.
+ */
+void Downmix(const int16_t *input, int16_t *output, size_t length, int num_channels);
+
+// Individual implementations, only exposed for testing and benchmarking.
+// The caller is responsible for checking that the CPU supports them.
+void Downmix_Generic(const int16_t *input, int16_t *output, size_t length, int num_channels);
+#ifdef CHROMAPRINT_ARCH_X86
+void Downmix_SSE2(const int16_t *input, int16_t *output, size_t length, int num_channels);
+void Downmix_AVX2(const int16_t *input, int16_t *output, size_t length, int num_channels);
+#endif
+#ifdef CHROMAPRINT_ARCH_NEON
+void Downmix_NEON(const int16_t *input, int16_t *output, size_t length, int num_channels);
+#endif
+
+}; // namespace chromaprint
+
+#endif
@@ -0,0 +1,87 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include "utils/downmix.h"
+
+namespace chromaprint {
+
+namespace {
+
+typedef void (*DownmixFunc)(const int16_t *input, int16_t *output, size_t length, int num_channels);
+
+void CheckImplementation(DownmixFunc func)
+{
+	std::mt19937 rng(1234);
+	for (int num_channels : { 1, 2, 3, 4, 5, 6, 7, 8, 9, 300 }) {
+		for (size_t length : { 0, 1, 7, 8, 9, 15, 16, 17, 33, 1000 }) {
+			std::vector<int16_t> input(length * num_channels);
+			for (auto &x : input) {
+				x = int16_t(rng());
+			}
+			// extreme values and sums that are not divisible by the number of channels
+			if (length > 2) {
+				std::fill(input.begin(), input.begin() + num_channels, int16_t(-32768));
+				std::fill(input.begin() + num_channels, input.begin() + 2 * num_channels, int16_t(32767));
+				std::fill(input.begin() + 2 * num_channels, input.begin() + 3 * num_channels, int16_t(0));
+				input[2 * num_channels] = -1;
+			}
+			std::vector<int16_t> expected(length), actual(length);
+			Downmix_Generic(input.data(), expected.data(), length, num_channels);
+			func(input.data(), actual.data(), length, num_channels);
+			ASSERT_EQ(expected, actual) << "num_channels=" << num_channels << " length=" << length;
+		}
+	}
+}
+
+}; // namespace
+
+TEST(DownmixTest, Generic) {
+	const int16_t stereo[] = { 1, 2, -1, -2, 100, -100, -32768, -32768, 32767, 32767 };
+	int16_t output[5];
+	Downmix_Generic(stereo, output, 5, 2);
+	EXPECT_EQ(1, output[0]);
+	EXPECT_EQ(-1, output[1]);
+	EXPECT_EQ(0, output[2]);
+	EXPECT_EQ(-32768, output[3]);
+	EXPECT_EQ(32767, output[4]);
+
+	const int16_t surround[] = { 1, 2, 3, 4, 5, 6, -1, -2, -3, -4, -5, -6 };
+	Downmix_Generic(surround, output, 2, 6);
+	EXPECT_EQ(3, output[0]);
+	EXPECT_EQ(-3, output[1]);
+}
+
+TEST(DownmixTest, Dispatch) {
+	CheckImplementation(Downmix);
+}
+
+#ifdef CHROMAPRINT_ARCH_X86
+
+TEST(DownmixTest, SSE2) {
+	if (!GetCpuFeatures().sse2) {
+		GTEST_SKIP() << "SSE2 not supported";
+	}
+	CheckImplementation(Downmix_SSE2);
+}
+
+TEST(DownmixTest, AVX2) {
+	if (!GetCpuFeatures().avx2) {
+		GTEST_SKIP() << "AVX2 not supported";
+	}
+	CheckImplementation(Downmix_AVX2);
+}
+
+#endif
+
+#ifdef CHROMAPRINT_ARCH_NEON
+
+TEST(DownmixTest, NEON) {
+	CheckImplementation(Downmix_NEON);
+}
+
+#endif
+
+}; // namespace chromaprint
@@ -0,0 +1,123 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include "utils/mapped_file.h"
+#include "debug.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace chromaprint {
+
+MappedFile::MappedFile()
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string &file_name)
+{
+	Close();
+
+	HANDLE file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		DEBUG("chromaprint::MappedFile::Open() -- Could not open " << file_name);
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		DEBUG("chromaprint::MappedFile::Open() -- Could not get size of " << file_name);
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapping) {
+		DEBUG("chromaprint::MappedFile::Open() -- Could not map " << file_name);
+		CloseHandle(file);
+		return false;
+	}
+
+	void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		DEBUG("chromaprint::MappedFile::Open() -- Could not map " << file_name);
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_mapping = mapping;
+	m_data = static_cast<const uint8_t *>(data);
+	m_size = size_t(size.QuadPart);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_data) {
+		UnmapViewOfFile(m_data);
+		CloseHandle(m_mapping);
+		CloseHandle(m_file);
+		m_data = nullptr;
+		m_mapping = nullptr;
+		m_file = nullptr;
+		m_size = 0;
+	}
+}
+
+#else
+
+bool MappedFile::Open(const std::string &file_name)
+{
+	Close();
+
+	const int fd = open(file_name.c_str(), O_RDONLY);
+	if (fd == -1) {
+		DEBUG("chromaprint::MappedFile::Open() -- Could not open " << file_name);
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == -1 || st.st_size == 0) {
+		DEBUG("chromaprint::MappedFile::Open() -- Could not get size of " << file_name);
+		close(fd);
+		return false;
+	}
+
+	void *data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		DEBUG("chromaprint::MappedFile::Open() -- Could not map " << file_name);
+		return false;
+	}
+
+	m_data = static_cast<const uint8_t *>(data);
+	m_size = size_t(st.st_size);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_data) {
+		munmap(const_cast<uint8_t *>(m_data), m_size);
+		m_data = nullptr;
+		m_size = 0;
+	}
+}
+
+#endif
+
+}; // namespace chromaprint
@@ -0,0 +1,46 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_UTILS_MAPPED_FILE_H_
+#define CHROMAPRINT_UTILS_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "utils.h"
+
+namespace chromaprint {
+
+/**
+ * Read-only memory mapping of a whole file.
+ *
+ * The mapping is shared, so multiple processes mapping the same file use
+ * the same pages in the OS page cache.
+ */
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool Open(const std::string &file_name);
+	void Close();
+
+	bool is_open() const { return m_data != nullptr; }
+	const uint8_t *data() const { return m_data; }
+	size_t size() const { return m_size; }
+
+private:
+	CHROMAPRINT_DISABLE_COPY(MappedFile);
+
+	const uint8_t *m_data = nullptr;
+	size_t m_size = 0;
+#ifdef _WIN32
+	void *m_file = nullptr;
+	void *m_mapping = nullptr;
+#endif
+};
+
+}; // namespace chromaprint
+
+#endif
@@ -8,7 +8,9 @@
 #include <cassert>
 #include <algorithm>
 #include <numeric>
+#include <vector>
 #include "debug.h"
+#include "utils/allocator.h"
 
 namespace chromaprint {
 
@@ -28,6 +30,31 @@ public:
 
 	size_t num_columns() const { return m_num_columns; }
 	size_t num_rows() const { return m_num_rows; }
+	size_t max_rows() const { return m_max_rows; }
+
+	/**
+	 * Sums of all rows before row r, prefixed with a zero column, so that
+	 * RowSums(r)[c] is the area of rows [0, r) and columns [0, c). For r
+	 * equal to zero this is a row of zeros.
+	 *
+	 * Area(r1, c1, r2, c2) equals RowSums(r2)[c2] - RowSums(r1)[c2] -
+	 * RowSums(r2)[c1] + RowSums(r1)[c1], evaluated in this order.
+	 */
+	const double *RowSums(size_t r) const {
+		return m_data.data() + RowSumsIndex(r);
+	}
+
+	//! Position of RowSums(r) in data().
+	size_t RowSumsIndex(size_t r) const {
+		assert(r <= m_num_rows);
+		if (r == 0) {
+			return m_max_rows * (m_num_columns + 1);
+		}
+		assert(m_num_rows <= m_max_rows || r > m_num_rows - m_max_rows);
+		return ((r - 1) % m_max_rows) * (m_num_columns + 1);
+	}
+
+	const double *data() const { return m_data.data(); }
 
 	void Reset() {
 		m_data.clear();
@@ -77,13 +104,21 @@ public:
 		const size_t size = std::distance(begin, end);
 		if (m_num_columns == 0) {
 			m_num_columns = size;
-			m_data.resize(m_max_rows * m_num_columns, 0.0);
+			// every row starts with a zero column and there is an extra row of zeros at the end
+			m_data.resize((m_max_rows + 1) * (m_num_columns + 1), 0.0);
 		}
 
 		assert(m_num_columns == size);
 
+		// Accumulate in double even if the features are in single precision,
+		// the sums keep growing over the whole stream and float would lose
+		// the small differences the classifiers compare.
 		auto current_row_begin = GetRow(m_num_rows);
-		std::partial_sum(begin, end, current_row_begin);
+		double sum = 0.0;
+		for (auto output = current_row_begin; begin != end; ++begin, ++output) {
+			sum += *begin;
+			*output = sum;
+		}
 
 		if (m_num_rows > 0) {
 			auto last_row_begin = GetRow(m_num_rows - 1);
@@ -95,26 +130,27 @@ public:
 		m_num_rows++;
 	}
 
-	void AddRow(const std::vector<double> &row) {
+	template <typename T>
+	void AddRow(const std::vector<T> &row) {
 		AddRow(row.begin(), row.end());
 	}
 
 private:
 
-	std::vector<double>::iterator GetRow(size_t i) {
+	Vector<double>::iterator GetRow(size_t i) {
 		i = i % m_max_rows;
-		return m_data.begin() + i * m_num_columns;
+		return m_data.begin() + i * (m_num_columns + 1) + 1;
 	}
 
-	std::vector<double>::const_iterator GetRow(size_t i) const {
+	Vector<double>::const_iterator GetRow(size_t i) const {
 		i = i % m_max_rows;
-		return m_data.begin() + i * m_num_columns;
+		return m_data.begin() + i * (m_num_columns + 1) + 1;
 	}
 
 	size_t m_max_rows;
 	size_t m_num_columns = 0;
 	size_t m_num_rows = 0;
-	std::vector<double> m_data;
+	Vector<double> m_data;
 };
 
 }; // namespace chromaprint
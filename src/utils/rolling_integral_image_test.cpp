@@ -88,4 +88,30 @@ TEST(RollingIntegralImageTest, All) {
 	ASSERT_DOUBLE_EQ((7 + 8 + 9) + (10 + 11 + 12) + (13 + 14 + 15) + (16 + 17 + 18), image.Area(2, 0, 6, 3));
 }
 
+TEST(RollingIntegralImageTest, RowSums) {
+	RollingIntegralImage image(4);
+	for (int i = 0; i < 7; i++) {
+		std::vector<double> data { i * 0.5, i * 0.25 + 1, 3.0 - i };
+		image.AddRow(data);
+	}
+
+	ASSERT_EQ(7, image.num_rows());
+	for (size_t r1 = 3; r1 <= 7; r1++) {
+		for (size_t r2 = r1; r2 <= 7; r2++) {
+			for (size_t c1 = 0; c1 <= 3; c1++) {
+				for (size_t c2 = c1 + 1; c2 <= 3; c2++) {
+					const double *row1 = image.RowSums(r1);
+					const double *row2 = image.RowSums(r2);
+					ASSERT_DOUBLE_EQ(image.Area(r1, c1, r2, c2), row2[c2] - row1[c2] - row2[c1] + row1[c1]);
+				}
+			}
+		}
+	}
+
+	const double *zeros = image.RowSums(0);
+	for (size_t c = 0; c <= 3; c++) {
+		ASSERT_EQ(0.0, zeros[c]);
+	}
+}
+
 }; // namespace chromaprint
@@ -0,0 +1,114 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_UTILS_SHARED_CACHE_H_
+#define CHROMAPRINT_UTILS_SHARED_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "utils.h"
+
+namespace chromaprint {
+
+/**
+ * Thread-safe cache of immutable objects that are expensive to create,
+ * like filter tables or FFT plans, shared by all contexts that need the
+ * same one.
+ *
+ * The objects are reference-counted. When nobody uses an object anymore,
+ * it is kept in the cache, so that contexts which are created and
+ * destroyed one after another can still reuse it, but only up to the
+ * given number of unused objects. The least recently used ones are
+ * released first.
+ */
+template <typename Key, typename Value>
+class SharedCache
+{
+public:
+	typedef std::shared_ptr<const Value> ValuePtr;
+
+	explicit SharedCache(size_t max_unused = 8) : m_max_unused(max_unused) {}
+
+	/**
+	 * Get the object for the key, or create it by calling create(), which
+	 * returns something convertible to ValuePtr. The lock is held while the
+	 * object is created, so it is only ever created once. If it returns an
+	 * empty pointer, nothing is cached.
+	 */
+	template <typename Factory>
+	ValuePtr Get(const Key &key, Factory create) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_entries.find(key);
+		if (it != m_entries.end()) {
+			it->second.last_used = ++m_clock;
+			return it->second.value;
+		}
+		ValuePtr value(create());
+		if (value) {
+			Entry &entry = m_entries[key];
+			entry.value = value;
+			entry.last_used = ++m_clock;
+			Trim();
+		}
+		return value;
+	}
+
+	//! Number of cached objects, including the ones that are in use.
+	size_t size() const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_entries.size();
+	}
+
+	//! Release all objects that are not in use.
+	void Clear() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto it = m_entries.begin(); it != m_entries.end(); ) {
+			if (it->second.value.use_count() == 1) {
+				it = m_entries.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
+private:
+	CHROMAPRINT_DISABLE_COPY(SharedCache);
+
+	struct Entry {
+		ValuePtr value;
+		uint64_t last_used = 0;
+	};
+
+	// New references are only handed out with the lock held, so an object
+	// that only the cache refers to cannot become used while it's released.
+	void Trim() {
+		while (true) {
+			size_t num_unused = 0;
+			auto oldest = m_entries.end();
+			for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+				if (it->second.value.use_count() == 1) {
+					num_unused++;
+					if (oldest == m_entries.end() || it->second.last_used < oldest->second.last_used) {
+						oldest = it;
+					}
+				}
+			}
+			if (num_unused <= m_max_unused) {
+				break;
+			}
+			m_entries.erase(oldest);
+		}
+	}
+
+	size_t m_max_unused;
+	uint64_t m_clock = 0;
+	std::map<Key, Entry> m_entries;
+	mutable std::mutex m_mutex;
+};
+
+}; // namespace chromaprint
+
+#endif
@@ -0,0 +1,102 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "utils/shared_cache.h"
+
+namespace chromaprint {
+
+TEST(SharedCacheTest, SharesValues) {
+	SharedCache<int, std::string> cache;
+	int num_created = 0;
+	auto create = [&]() {
+		num_created++;
+		return std::make_shared<std::string>("value");
+	};
+
+	auto a = cache.Get(1, create);
+	auto b = cache.Get(1, create);
+	ASSERT_EQ(1, num_created);
+	ASSERT_EQ(a.get(), b.get());
+
+	auto c = cache.Get(2, create);
+	ASSERT_EQ(2, num_created);
+	ASSERT_NE(a.get(), c.get());
+
+	// still cached when nobody uses it
+	a.reset();
+	b.reset();
+	c = cache.Get(1, create);
+	ASSERT_EQ(2, num_created);
+}
+
+TEST(SharedCacheTest, ReleasesUnused) {
+	SharedCache<int, int> cache(2);
+	auto create = []() { return std::make_shared<int>(0); };
+
+	auto used = cache.Get(0, create);
+	for (int i = 1; i <= 5; i++) {
+		cache.Get(i, create);
+	}
+	// unused objects are released when a new one is added
+	auto last = cache.Get(6, create);
+	ASSERT_EQ(4, cache.size());
+
+	int num_created = 0;
+	auto count = [&]() {
+		num_created++;
+		return std::make_shared<int>(0);
+	};
+	ASSERT_EQ(used.get(), cache.Get(0, count).get());
+	cache.Get(4, count);
+	cache.Get(5, count);
+	ASSERT_EQ(0, num_created);
+	cache.Get(1, count);
+	ASSERT_EQ(1, num_created);
+
+	last.reset();
+	cache.Clear();
+	ASSERT_EQ(1, cache.size());
+	ASSERT_EQ(used.get(), cache.Get(0, count).get());
+}
+
+TEST(SharedCacheTest, FailedCreate) {
+	SharedCache<int, int> cache;
+	auto value = cache.Get(1, []() { return std::shared_ptr<int>(); });
+	ASSERT_FALSE(value);
+	ASSERT_EQ(0, cache.size());
+}
+
+TEST(SharedCacheTest, Threads) {
+	SharedCache<int, int> cache;
+	std::atomic<int> num_created(0);
+	std::vector<std::thread> threads;
+	std::vector<const int *> values(8);
+	for (size_t i = 0; i < values.size(); i++) {
+		threads.emplace_back([&, i]() {
+			for (int j = 0; j < 1000; j++) {
+				auto value = cache.Get(j % 4, [&]() {
+					num_created++;
+					return std::make_shared<int>(j % 4);
+				});
+				ASSERT_EQ(j % 4, *value);
+				if (j % 4 == 0) {
+					values[i] = value.get();
+				}
+			}
+		});
+	}
+	for (auto &thread : threads) {
+		thread.join();
+	}
+	ASSERT_EQ(4, num_created.load());
+	for (auto value : values) {
+		ASSERT_EQ(values[0], value);
+	}
+}
+
+}; // namespace chromaprint
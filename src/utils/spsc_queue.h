@@ -0,0 +1,77 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_UTILS_SPSC_QUEUE_H_
+#define CHROMAPRINT_UTILS_SPSC_QUEUE_H_
+
+#include <cstddef>
+#include <atomic>
+#include <utility>
+#include <vector>
+#include "utils.h"
+
+namespace chromaprint {
+
+/**
+ * Bounded lock-free queue for passing values from one producer thread to
+ * one consumer thread.
+ *
+ * Values are exchanged with the slots of a ring buffer using swap, not
+ * copied, so the producer gets back whatever the consumer left in the slot
+ * it writes to. When the values are buffers, they keep circulating between
+ * the two threads and no memory is allocated once the ring is full of them.
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+	//! Create a queue that holds at most capacity values, rounded up to a power of two.
+	explicit SpscQueue(size_t capacity) {
+		size_t size = 1;
+		while (size < capacity) {
+			size *= 2;
+		}
+		m_slots.resize(size);
+		m_mask = size - 1;
+	}
+
+	size_t capacity() const { return m_slots.size(); }
+
+	//! Swap value into the queue, fails if the queue is full. Only call from the producer thread.
+	bool TryPush(T &value) {
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) == m_slots.size()) {
+			return false;
+		}
+		using std::swap;
+		swap(m_slots[tail & m_mask], value);
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	//! Swap the oldest value out of the queue, fails if the queue is empty. Only call from the consumer thread.
+	bool TryPop(T &value) {
+		const size_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		using std::swap;
+		swap(m_slots[head & m_mask], value);
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	CHROMAPRINT_DISABLE_COPY(SpscQueue);
+
+	std::vector<T> m_slots;
+	size_t m_mask;
+	// the positions are only ever incremented, each is written by one thread,
+	// keep them on separate cache lines so the threads don't fight over them
+	alignas(64) std::atomic<size_t> m_head { 0 };
+	alignas(64) std::atomic<size_t> m_tail { 0 };
+};
+
+}; // namespace chromaprint
+
+#endif
@@ -0,0 +1,72 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "utils/spsc_queue.h"
+
+namespace chromaprint {
+
+TEST(SpscQueueTest, Capacity) {
+	SpscQueue<int> queue(5);
+	ASSERT_EQ(8, queue.capacity());
+
+	for (int i = 0; i < 8; i++) {
+		int value = i;
+		ASSERT_TRUE(queue.TryPush(value));
+	}
+	int value = 8;
+	ASSERT_FALSE(queue.TryPush(value));
+
+	for (int i = 0; i < 8; i++) {
+		ASSERT_TRUE(queue.TryPop(value));
+		ASSERT_EQ(i, value);
+	}
+	ASSERT_FALSE(queue.TryPop(value));
+}
+
+TEST(SpscQueueTest, RecyclesValues) {
+	SpscQueue<std::vector<int>> queue(1);
+
+	std::vector<int> produced(100, 1);
+	const int *produced_data = produced.data();
+	ASSERT_TRUE(queue.TryPush(produced));
+	ASSERT_TRUE(produced.empty());
+
+	std::vector<int> consumed(100, 2);
+	const int *consumed_data = consumed.data();
+	ASSERT_TRUE(queue.TryPop(consumed));
+	ASSERT_EQ(produced_data, consumed.data());
+
+	// the consumer's old buffer was left in the slot, the producer gets it back
+	produced.assign(100, 3);
+	ASSERT_TRUE(queue.TryPush(produced));
+	ASSERT_EQ(consumed_data, produced.data());
+}
+
+TEST(SpscQueueTest, Threads) {
+	SpscQueue<size_t> queue(16);
+	const size_t count = 100000;
+
+	std::thread producer([&]() {
+		for (size_t i = 0; i < count; i++) {
+			size_t value = i;
+			while (!queue.TryPush(value)) {
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	for (size_t i = 0; i < count; i++) {
+		size_t value = 0;
+		while (!queue.TryPop(value)) {
+			std::this_thread::yield();
+		}
+		EXPECT_EQ(i, value);
+	}
+
+	producer.join();
+}
+
+}; // namespace chromaprint
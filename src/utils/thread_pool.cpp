@@ -0,0 +1,133 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include "utils/thread_pool.h"
+
+namespace chromaprint {
+
+size_t ThreadPool::GetDefaultNumThreads()
+{
+	const auto num_threads = std::thread::hardware_concurrency();
+	return num_threads > 0 ? num_threads : 1;
+}
+
+ThreadPool::ThreadPool(size_t num_threads)
+{
+	if (num_threads == 0) {
+		num_threads = GetDefaultNumThreads();
+	}
+	for (size_t i = 0; i < num_threads; i++) {
+		m_queues.emplace_back(new TaskQueue());
+	}
+	for (size_t i = 1; i < num_threads; i++) {
+		m_threads.emplace_back(&ThreadPool::WorkerMain, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_start_cond.notify_all();
+	for (auto &thread : m_threads) {
+		thread.join();
+	}
+}
+
+void ThreadPool::Run(size_t num_tasks, const TaskFunc &func)
+{
+	if (num_tasks == 0) {
+		return;
+	}
+
+	// Split the tasks into contiguous ranges, one for each thread.
+	const auto num_threads = m_queues.size();
+	for (size_t i = 0; i < num_threads; i++) {
+		const auto begin = num_tasks * i / num_threads;
+		const auto end = num_tasks * (i + 1) / num_threads;
+		std::lock_guard<std::mutex> lock(m_queues[i]->mutex);
+		for (size_t task = begin; task < end; task++) {
+			m_queues[i]->tasks.push_back(task);
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_func = &func;
+		m_memory = MemoryScope::current();
+		m_num_running = m_threads.size();
+		m_generation++;
+	}
+	m_start_cond.notify_all();
+
+	Work(0);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done_cond.wait(lock, [this] { return m_num_running == 0; });
+	m_func = nullptr;
+}
+
+void ThreadPool::WorkerMain(size_t thread_index)
+{
+	uint64_t generation = 0;
+	while (true) {
+		MemoryCounter *memory;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_start_cond.wait(lock, [&] { return m_stop || m_generation != generation; });
+			if (m_stop) {
+				return;
+			}
+			generation = m_generation;
+			memory = m_memory;
+		}
+		{
+			MemoryScope scope(memory);
+			Work(thread_index);
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_num_running--;
+		}
+		m_done_cond.notify_one();
+	}
+}
+
+void ThreadPool::Work(size_t thread_index)
+{
+	size_t task;
+	while (PopTask(thread_index, task) || StealTask(thread_index, task)) {
+		(*m_func)(thread_index, task);
+	}
+}
+
+bool ThreadPool::PopTask(size_t thread_index, size_t &task)
+{
+	auto &queue = *m_queues[thread_index];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.tasks.empty()) {
+		return false;
+	}
+	task = queue.tasks.back();
+	queue.tasks.pop_back();
+	return true;
+}
+
+bool ThreadPool::StealTask(size_t thread_index, size_t &task)
+{
+	const auto num_threads = m_queues.size();
+	for (size_t i = 1; i < num_threads; i++) {
+		auto &queue = *m_queues[(thread_index + i) % num_threads];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = queue.tasks.front();
+			queue.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+}; // namespace chromaprint
@@ -0,0 +1,76 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_UTILS_THREAD_POOL_H_
+#define CHROMAPRINT_UTILS_THREAD_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include "utils.h"
+#include "utils/allocator.h"
+
+namespace chromaprint {
+
+/**
+ * Fixed-size pool of worker threads for running a set of independent tasks.
+ *
+ * Tasks are distributed over per-thread queues up front. Each thread takes
+ * tasks from the back of its own queue and, once that is empty, steals from
+ * the front of the other queues, so uneven task durations don't leave
+ * threads idle. The thread calling Run() works as thread 0.
+ *
+ * Memory allocated by the tasks is counted in the memory scope of the
+ * thread calling Run().
+ */
+class ThreadPool : public Allocated
+{
+public:
+	typedef std::function<void(size_t thread_index, size_t task_index)> TaskFunc;
+
+	//! Create a pool with the given number of threads, 0 means one per CPU core.
+	explicit ThreadPool(size_t num_threads = 0);
+	~ThreadPool();
+
+	//! Total number of threads that execute tasks, including the caller of Run().
+	size_t num_threads() const { return m_queues.size(); }
+
+	//! Execute func for every task index in [0, num_tasks) and wait for all of them to finish.
+	void Run(size_t num_tasks, const TaskFunc &func);
+
+	static size_t GetDefaultNumThreads();
+
+private:
+	CHROMAPRINT_DISABLE_COPY(ThreadPool);
+
+	struct TaskQueue : public Allocated {
+		std::mutex mutex;
+		std::deque<size_t> tasks;
+	};
+
+	void WorkerMain(size_t thread_index);
+	void Work(size_t thread_index);
+	bool PopTask(size_t thread_index, size_t &task);
+	bool StealTask(size_t thread_index, size_t &task);
+
+	std::vector<std::unique_ptr<TaskQueue>> m_queues;
+	std::vector<std::thread> m_threads;
+	std::mutex m_mutex;
+	std::condition_variable m_start_cond;
+	std::condition_variable m_done_cond;
+	const TaskFunc *m_func = nullptr;
+	MemoryCounter *m_memory = nullptr;
+	uint64_t m_generation = 0;
+	size_t m_num_running = 0;
+	bool m_stop = false;
+};
+
+}; // namespace chromaprint
+
+#endif
@@ -0,0 +1,46 @@
+// Copyright (C) 2026  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <algorithm>
+#include <atomic>
+#include <gtest/gtest.h>
+#include "utils/thread_pool.h"
+
+namespace chromaprint {
+
+TEST(ThreadPoolTest, RunsEveryTaskOnce) {
+	ThreadPool pool(4);
+	ASSERT_EQ(4, pool.num_threads());
+
+	for (size_t num_tasks : { 0, 1, 3, 4, 100 }) {
+		std::vector<std::atomic<int>> counts(num_tasks);
+		for (auto &count : counts) {
+			count = 0;
+		}
+		pool.Run(num_tasks, [&](size_t thread_index, size_t task_index) {
+			ASSERT_LT(thread_index, pool.num_threads());
+			counts[task_index]++;
+		});
+		for (size_t i = 0; i < num_tasks; i++) {
+			ASSERT_EQ(1, counts[i]) << "Task " << i << " of " << num_tasks;
+		}
+	}
+}
+
+TEST(ThreadPoolTest, SingleThread) {
+	ThreadPool pool(1);
+	ASSERT_EQ(1, pool.num_threads());
+
+	std::vector<size_t> tasks;
+	pool.Run(10, [&](size_t thread_index, size_t task_index) {
+		ASSERT_EQ(0, thread_index);
+		tasks.push_back(task_index);
+	});
+	std::sort(tasks.begin(), tasks.end());
+	ASSERT_EQ(10, tasks.size());
+	for (size_t i = 0; i < tasks.size(); i++) {
+		ASSERT_EQ(i, tasks[i]);
+	}
+}
+
+}; // namespace chromaprint
@@ -1,11 +1,37 @@
 #include <gtest/gtest.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <algorithm>
 #include <vector>
 #include <fstream>
 #include "chromaprint.h"
 #include "test_utils.h"
 #include "utils/scope_exit.h"
+#include "pipeline_stats.h"
+
+namespace {
+
+// Allocations made through CountingAllocate() are counted on the current
+// thread while enabled, to check that code doesn't allocate memory.
+thread_local bool g_count_allocations = false;
+thread_local int g_num_allocations = 0;
+
+void *CountingAllocate(void *user_data, size_t size)
+{
+	if (g_count_allocations) {
+		g_num_allocations++;
+	}
+	(*static_cast<int *>(user_data))++;
+	return malloc(size);
+}
+
+void CountingDeallocate(void *user_data, void *ptr)
+{
+	(*static_cast<int *>(user_data))--;
+	free(ptr);
+}
+
+}; // namespace
 
 namespace chromaprint {
 
@@ -237,4 +263,594 @@ TEST(API, TestDecodeFingerprintCoustidFingerprint)
 	ASSERT_EQ(0, algorithm);
 }
 
+static std::vector<uint32_t> CalculateRawFingerprint(ChromaprintContext *ctx, const std::vector<short> &data, int sample_rate, int num_channels)
+{
+	chromaprint_start(ctx, sample_rate, num_channels);
+	chromaprint_feed(ctx, data.data(), int(data.size()));
+	chromaprint_finish(ctx);
+	uint32_t *fp;
+	int size;
+	chromaprint_get_raw_fingerprint(ctx, &fp, &size);
+	SCOPE_EXIT(chromaprint_dealloc(fp));
+	return std::vector<uint32_t>(fp, fp + size);
+}
+
+static std::vector<uint32_t> CalculateRawFingerprint(int algorithm, const std::vector<short> &data, int sample_rate, int num_channels)
+{
+	ChromaprintContext *ctx = chromaprint_new(algorithm);
+	SCOPE_EXIT(chromaprint_free(ctx));
+	return CalculateRawFingerprint(ctx, data, sample_rate, num_channels);
+}
+
+static std::vector<short> RepeatAudio(const std::vector<short> &data, int count)
+{
+	std::vector<short> result;
+	for (int i = 0; i < count; i++) {
+		result.insert(result.end(), data.begin(), data.end());
+	}
+	return result;
+}
+
+TEST(API, TestBatch)
+{
+	std::vector<short> data1 = LoadAudioFile("data/test_stereo_44100.raw");
+	std::vector<short> data2 = RepeatAudio(data1, 3);
+	std::vector<short> data3 = RepeatAudio(LoadAudioFile("data/test_mono_8000.raw"), 5);
+
+	ChromaprintBatch *batch = chromaprint_batch_new(CHROMAPRINT_ALGORITHM_TEST2, 3);
+	ASSERT_NE(nullptr, batch);
+	SCOPE_EXIT(chromaprint_batch_free(batch));
+
+	ASSERT_EQ(3, chromaprint_batch_get_num_threads(batch));
+
+	for (int i = 0; i < 3; i++) {
+		ASSERT_EQ(1, chromaprint_batch_add(batch, data1.data(), int(data1.size()), 44100, 1));
+		ASSERT_EQ(1, chromaprint_batch_add(batch, data2.data(), int(data2.size()), 44100, 2));
+		ASSERT_EQ(1, chromaprint_batch_add(batch, data3.data(), int(data3.size()), 8000, 1));
+	}
+
+	int size;
+	ASSERT_EQ(1, chromaprint_batch_get_size(batch, &size));
+	ASSERT_EQ(9, size);
+
+	ASSERT_EQ(1, chromaprint_batch_run(batch));
+
+	const std::vector<uint32_t> expected[] = {
+		CalculateRawFingerprint(CHROMAPRINT_ALGORITHM_TEST2, data1, 44100, 1),
+		CalculateRawFingerprint(CHROMAPRINT_ALGORITHM_TEST2, data2, 44100, 2),
+		CalculateRawFingerprint(CHROMAPRINT_ALGORITHM_TEST2, data3, 8000, 1),
+	};
+
+	for (int i = 0; i < size; i++) {
+		uint32_t *fp;
+		int fp_size;
+		ASSERT_EQ(1, chromaprint_batch_get_raw_fingerprint(batch, i, &fp, &fp_size));
+		SCOPE_EXIT(chromaprint_dealloc(fp));
+		ASSERT_FALSE(expected[i % 3].empty());
+		ASSERT_EQ(expected[i % 3], std::vector<uint32_t>(fp, fp + fp_size)) << "Different fingerprint at " << i;
+	}
+
+	char *fp;
+	ASSERT_EQ(1, chromaprint_batch_get_fingerprint(batch, 0, &fp));
+	SCOPE_EXIT(chromaprint_dealloc(fp));
+	EXPECT_EQ(std::string("AQAAC0kkZUqYREkUnFAXHk8uuMZl6EfO4zu-4ABKFGESWIIMEQE"), std::string(fp));
+}
+
+TEST(API, TestBatchReuse)
+{
+	std::vector<short> mono = RepeatAudio(LoadAudioFile("data/test_mono_44100.raw"), 3);
+
+	ChromaprintBatch *batch = chromaprint_batch_new(CHROMAPRINT_ALGORITHM_TEST4, 2);
+	ASSERT_NE(nullptr, batch);
+	SCOPE_EXIT(chromaprint_batch_free(batch));
+
+	const auto expected = CalculateRawFingerprint(CHROMAPRINT_ALGORITHM_TEST4, mono, 44100, 1);
+
+	for (int run = 0; run < 2; run++) {
+		ASSERT_EQ(1, chromaprint_batch_clear(batch));
+		ASSERT_EQ(1, chromaprint_batch_add(batch, mono.data(), int(mono.size()), 44100, 1));
+		ASSERT_EQ(1, chromaprint_batch_run(batch));
+
+		uint32_t *fp;
+		int fp_size;
+		ASSERT_EQ(1, chromaprint_batch_get_raw_fingerprint(batch, 0, &fp, &fp_size));
+		SCOPE_EXIT(chromaprint_dealloc(fp));
+		ASSERT_FALSE(expected.empty());
+		ASSERT_EQ(expected, std::vector<uint32_t>(fp, fp + fp_size));
+	}
+}
+
+TEST(API, TestMulti)
+{
+	std::vector<short> stereo = RepeatAudio(LoadAudioFile("data/test_stereo_44100.raw"), 3);
+	const int algorithms[] = { CHROMAPRINT_ALGORITHM_TEST2, CHROMAPRINT_ALGORITHM_TEST4, CHROMAPRINT_ALGORITHM_TEST5 };
+
+	ASSERT_EQ(nullptr, chromaprint_multi_new(algorithms, 0));
+	const int invalid_algorithms[] = { CHROMAPRINT_ALGORITHM_TEST2, -1 };
+	ASSERT_EQ(nullptr, chromaprint_multi_new(invalid_algorithms, 2));
+
+	ChromaprintMultiContext *ctx = chromaprint_multi_new(algorithms, 3);
+	ASSERT_NE(nullptr, ctx);
+	SCOPE_EXIT(chromaprint_multi_free(ctx));
+
+	ASSERT_EQ(11025, chromaprint_multi_get_sample_rate(ctx));
+	ASSERT_EQ(1, chromaprint_multi_start(ctx, 44100, 2));
+	ASSERT_EQ(1, chromaprint_multi_feed(ctx, stereo.data(), int(stereo.size())));
+	ASSERT_EQ(1, chromaprint_multi_finish(ctx));
+
+	for (int i = 0; i < 3; i++) {
+		const auto expected = CalculateRawFingerprint(algorithms[i], stereo, 44100, 2);
+		ASSERT_FALSE(expected.empty());
+
+		uint32_t *fp;
+		int fp_size;
+		ASSERT_EQ(1, chromaprint_multi_get_raw_fingerprint(ctx, i, &fp, &fp_size));
+		SCOPE_EXIT(chromaprint_dealloc(fp));
+		ASSERT_EQ(expected, std::vector<uint32_t>(fp, fp + fp_size)) << "Different fingerprint for algorithm " << algorithms[i];
+
+		char *encoded;
+		ASSERT_EQ(1, chromaprint_multi_get_fingerprint(ctx, i, &encoded));
+		SCOPE_EXIT(chromaprint_dealloc(encoded));
+		int algorithm;
+		ASSERT_EQ(1, chromaprint_decode_fingerprint_header(encoded, int(strlen(encoded)), &fp_size, &algorithm, 1));
+		ASSERT_EQ(algorithms[i], algorithm);
+		ASSERT_EQ(int(expected.size()), fp_size);
+	}
+
+	ASSERT_EQ(0, chromaprint_multi_get_fingerprint(ctx, 3, nullptr));
+}
+
+TEST(API, TestBatchInvalidInput)
+{
+	std::vector<short> mono = LoadAudioFile("data/test_mono_44100.raw");
+
+	ASSERT_EQ(nullptr, chromaprint_batch_new(-1, 0));
+
+	ChromaprintBatch *batch = chromaprint_batch_new(CHROMAPRINT_ALGORITHM_DEFAULT, 0);
+	ASSERT_NE(nullptr, batch);
+	SCOPE_EXIT(chromaprint_batch_free(batch));
+
+	ASSERT_EQ(1, chromaprint_batch_add(batch, mono.data(), int(mono.size()), 44100, 1));
+	ASSERT_EQ(1, chromaprint_batch_add(batch, mono.data(), int(mono.size()), 44100, 0));
+	ASSERT_EQ(0, chromaprint_batch_run(batch));
+
+	uint32_t *fp;
+	int fp_size;
+	ASSERT_EQ(1, chromaprint_batch_get_raw_fingerprint(batch, 0, &fp, &fp_size));
+	chromaprint_dealloc(fp);
+	ASSERT_EQ(0, chromaprint_batch_get_raw_fingerprint(batch, 1, &fp, &fp_size));
+	ASSERT_EQ(0, chromaprint_batch_get_raw_fingerprint(batch, 2, &fp, &fp_size));
+}
+
+TEST(API, TestMatcher)
+{
+	std::vector<short> data = LoadAudioFile("data/test_stereo_44100.raw");
+	const std::vector<short> reversed(data.rbegin(), data.rend());
+	data.insert(data.end(), reversed.begin(), reversed.end());
+	std::vector<uint32_t> fp1 = CalculateRawFingerprint(CHROMAPRINT_ALGORITHM_TEST2, data, 44100, 1);
+	ASSERT_FALSE(fp1.empty());
+	// the reversed second half of the audio
+	std::vector<short> data2(data.begin() + data.size() / 2, data.end());
+	std::vector<uint32_t> fp2 = CalculateRawFingerprint(CHROMAPRINT_ALGORITHM_TEST2, data2, 44100, 1);
+	ASSERT_FALSE(fp2.empty());
+
+	ChromaprintMatcherContext *ctx = chromaprint_matcher_new();
+	ASSERT_NE(nullptr, ctx);
+	SCOPE_EXIT(chromaprint_matcher_free(ctx));
+
+	int num_segments;
+	ASSERT_EQ(0, chromaprint_matcher_get_num_segments(ctx, &num_segments));
+
+	ASSERT_EQ(1, chromaprint_matcher_set_fingerprint(ctx, 0, fp1.data(), int(fp1.size()), CHROMAPRINT_ALGORITHM_TEST2));
+	ASSERT_EQ(1, chromaprint_matcher_set_fingerprint(ctx, 1, fp1.data(), int(fp1.size()), CHROMAPRINT_ALGORITHM_TEST2));
+	ASSERT_EQ(1, chromaprint_matcher_run(ctx));
+	ASSERT_EQ(1, chromaprint_matcher_get_num_segments(ctx, &num_segments));
+	ASSERT_EQ(1, num_segments);
+
+	int pos1, pos2, duration, score;
+	ASSERT_EQ(1, chromaprint_matcher_get_segment_position(ctx, 0, &pos1, &pos2, &duration));
+	EXPECT_EQ(0, pos1);
+	EXPECT_EQ(0, pos2);
+	EXPECT_EQ(int(fp1.size()), duration);
+	ASSERT_EQ(1, chromaprint_matcher_get_segment_score(ctx, 0, &score));
+	EXPECT_EQ(0, score);
+	ASSERT_EQ(0, chromaprint_matcher_get_segment_score(ctx, 1, &score));
+
+	// the same context, with the second fingerprint compressed
+	char *encoded;
+	int encoded_size;
+	ASSERT_EQ(1, chromaprint_encode_fingerprint(fp2.data(), int(fp2.size()), CHROMAPRINT_ALGORITHM_TEST2, &encoded, &encoded_size, 1));
+	SCOPE_EXIT(chromaprint_dealloc(encoded));
+	ASSERT_EQ(1, chromaprint_matcher_set_encoded_fingerprint(ctx, 1, encoded, encoded_size, 1));
+	ASSERT_EQ(1, chromaprint_matcher_run(ctx));
+	ASSERT_EQ(1, chromaprint_matcher_get_num_segments(ctx, &num_segments));
+	ASSERT_LE(1, num_segments);
+	ASSERT_EQ(1, chromaprint_matcher_get_segment_position(ctx, 0, &pos1, &pos2, &duration));
+	EXPECT_NEAR(int(fp1.size() - fp2.size()), pos1, 1);
+	EXPECT_EQ(0, pos2);
+	ASSERT_EQ(1, chromaprint_matcher_get_segment_position_ms(ctx, 0, &pos1, &pos2, &duration));
+	EXPECT_NEAR(4000, pos1, 200);
+	EXPECT_EQ(0, pos2);
+
+	// fingerprints from different algorithms can't be compared
+	ASSERT_EQ(1, chromaprint_matcher_set_fingerprint(ctx, 1, fp2.data(), int(fp2.size()), CHROMAPRINT_ALGORITHM_TEST1));
+	ASSERT_EQ(0, chromaprint_matcher_run(ctx));
+	ASSERT_EQ(1, chromaprint_matcher_get_num_segments(ctx, &num_segments));
+	ASSERT_EQ(0, num_segments);
+	ASSERT_EQ(0, chromaprint_matcher_set_fingerprint(ctx, 2, fp2.data(), int(fp2.size()), CHROMAPRINT_ALGORITHM_TEST2));
+	ASSERT_EQ(0, chromaprint_matcher_set_encoded_fingerprint(ctx, 0, "xx", 2, 1));
+}
+
+TEST(API, TestFingerprintCallback)
+{
+	std::vector<short> data = LoadAudioFile("data/test_stereo_44100.raw");
+	const std::vector<uint32_t> expected = CalculateRawFingerprint(CHROMAPRINT_ALGORITHM_TEST2, data, 44100, 1);
+	ASSERT_FALSE(expected.empty());
+
+	struct Result {
+		std::vector<uint32_t> fp;
+		std::vector<int> offsets;
+	} result;
+
+	auto callback = [](void *user_data, const uint32_t *fp, int size, int offset) {
+		auto result = static_cast<Result *>(user_data);
+		for (int i = 0; i < size; i++) {
+			result->fp.push_back(fp[i]);
+			result->offsets.push_back(offset + i);
+		}
+	};
+
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_TEST2);
+	SCOPE_EXIT(chromaprint_free(ctx));
+	ASSERT_EQ(1, chromaprint_set_fingerprint_callback(ctx, callback, &result));
+
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+	// feed the audio in small chunks, items should arrive as soon as they are available
+	size_t num_calls_with_items = 0;
+	for (size_t i = 0; i < data.size(); i += 4410) {
+		const size_t size = std::min(data.size() - i, size_t(4410));
+		const auto old_size = result.fp.size();
+		ASSERT_EQ(1, chromaprint_feed(ctx, data.data() + i, int(size)));
+		if (result.fp.size() > old_size) {
+			num_calls_with_items++;
+		}
+	}
+	ASSERT_EQ(1, chromaprint_finish(ctx));
+	EXPECT_LT(1u, num_calls_with_items);
+
+	ASSERT_EQ(expected, result.fp);
+	for (size_t i = 0; i < result.offsets.size(); i++) {
+		ASSERT_EQ(int(i), result.offsets[i]);
+	}
+
+	// nothing is accumulated in the context
+	int size;
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint_size(ctx, &size));
+	ASSERT_EQ(0, size);
+
+	// offsets are counted from the start
+	result.fp.clear();
+	result.offsets.clear();
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+	ASSERT_EQ(1, chromaprint_feed(ctx, data.data(), int(data.size())));
+	ASSERT_EQ(1, chromaprint_finish(ctx));
+	ASSERT_EQ(expected, result.fp);
+	ASSERT_EQ(0, result.offsets[0]);
+
+	// removing the callback switches back to accumulating
+	ASSERT_EQ(1, chromaprint_set_fingerprint_callback(ctx, nullptr, nullptr));
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+	ASSERT_EQ(1, chromaprint_feed(ctx, data.data(), int(data.size())));
+	ASSERT_EQ(1, chromaprint_finish(ctx));
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint_size(ctx, &size));
+	ASSERT_EQ(int(expected.size()), size);
+}
+
+TEST(API, TestFingerprintBeforeFinish)
+{
+	std::vector<short> data = RepeatAudio(LoadAudioFile("data/test_stereo_44100.raw"), 10);
+	const std::vector<uint32_t> expected = CalculateRawFingerprint(CHROMAPRINT_ALGORITHM_TEST2, data, 44100, 1);
+	ASSERT_FALSE(expected.empty());
+
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_TEST2);
+	SCOPE_EXIT(chromaprint_free(ctx));
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+	ASSERT_EQ(1, chromaprint_feed(ctx, data.data(), int(data.size())));
+
+	// only the last few frames are missing, not a whole block of them
+	uint32_t *fp;
+	int size;
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint(ctx, &fp, &size));
+	SCOPE_EXIT(chromaprint_dealloc(fp));
+	ASSERT_GE(size + 8, int(expected.size()));
+	ASSERT_EQ(std::vector<uint32_t>(expected.begin(), expected.begin() + size), std::vector<uint32_t>(fp, fp + size));
+
+	ASSERT_EQ(1, chromaprint_finish(ctx));
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint_size(ctx, &size));
+	ASSERT_EQ(int(expected.size()), size);
+}
+
+TEST(API, TestSlidingWindow)
+{
+	std::vector<short> data = LoadAudioFile("data/test_stereo_44100.raw");
+	const std::vector<uint32_t> expected = CalculateRawFingerprint(CHROMAPRINT_ALGORITHM_TEST2, data, 44100, 1);
+	ASSERT_LT(10u, expected.size());
+
+	struct Result {
+		std::vector<std::vector<uint32_t>> windows;
+		std::vector<int> offsets;
+	} result;
+
+	auto callback = [](void *user_data, const uint32_t *fp, int size, int offset) {
+		auto result = static_cast<Result *>(user_data);
+		result->windows.emplace_back(fp, fp + size);
+		result->offsets.push_back(offset);
+	};
+
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_TEST2);
+	SCOPE_EXIT(chromaprint_free(ctx));
+
+	const int item_duration_ms = chromaprint_get_item_duration_ms(ctx);
+	ASSERT_EQ(1, chromaprint_set_sliding_window(ctx, 8 * item_duration_ms, 3 * item_duration_ms, callback, &result));
+
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+	ASSERT_EQ(1, chromaprint_feed(ctx, data.data(), int(data.size())));
+	ASSERT_EQ(1, chromaprint_finish(ctx));
+
+	// the last window
+	uint32_t *fp;
+	int size;
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint(ctx, &fp, &size));
+	SCOPE_EXIT(chromaprint_dealloc(fp));
+	ASSERT_EQ(std::vector<uint32_t>(expected.end() - 8, expected.end()), std::vector<uint32_t>(fp, fp + size));
+
+	// overlapping windows
+	ASSERT_EQ((expected.size() - 8) / 3 + 1, result.windows.size());
+	for (size_t i = 0; i < result.windows.size(); i++) {
+		const int offset = int(i * 3);
+		ASSERT_EQ(offset, result.offsets[i]);
+		ASSERT_EQ(std::vector<uint32_t>(expected.begin() + offset, expected.begin() + offset + 8), result.windows[i]);
+	}
+
+	// disabling the window
+	ASSERT_EQ(1, chromaprint_set_sliding_window(ctx, 0, 0, nullptr, nullptr));
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+	ASSERT_EQ(1, chromaprint_feed(ctx, data.data(), int(data.size())));
+	ASSERT_EQ(1, chromaprint_finish(ctx));
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint_size(ctx, &size));
+	ASSERT_EQ(int(expected.size()), size);
+}
+
+TEST(API, TestFeedFloat)
+{
+	std::vector<short> data = LoadAudioFile("data/test_stereo_44100.raw");
+	const std::vector<uint32_t> expected = CalculateRawFingerprint(CHROMAPRINT_ALGORITHM_TEST2, data, 44100, 1);
+
+	std::vector<float> data_float(data.size());
+	std::vector<int32_t> data_s32(data.size());
+	for (size_t i = 0; i < data.size(); i++) {
+		data_float[i] = data[i] / 32768.0f;
+		data_s32[i] = int32_t(data[i]) << 16;
+	}
+	const float *planar_float[] = { data_float.data() };
+	const int16_t *planar[] = { data.data() };
+
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_TEST2);
+	SCOPE_EXIT(chromaprint_free(ctx));
+
+	for (int method = 0; method < 4; method++) {
+		SCOPED_TRACE(method);
+		ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+		switch (method) {
+		case 0:
+			ASSERT_EQ(1, chromaprint_feed_float(ctx, data_float.data(), int(data_float.size())));
+			break;
+		case 1:
+			ASSERT_EQ(1, chromaprint_feed_int32(ctx, data_s32.data(), int(data_s32.size())));
+			break;
+		case 2:
+			ASSERT_EQ(1, chromaprint_feed_float_planar(ctx, planar_float, int(data_float.size())));
+			break;
+		case 3:
+			ASSERT_EQ(1, chromaprint_feed_planar(ctx, planar, int(data.size())));
+			break;
+		}
+		ASSERT_EQ(1, chromaprint_finish(ctx));
+
+		uint32_t *fp;
+		int size;
+		ASSERT_EQ(1, chromaprint_get_raw_fingerprint(ctx, &fp, &size));
+		SCOPE_EXIT(chromaprint_dealloc(fp));
+		ASSERT_EQ(expected, std::vector<uint32_t>(fp, fp + size));
+	}
+}
+
+TEST(API, TestStats)
+{
+	std::vector<short> data = LoadAudioFile("data/test_stereo_44100.raw");
+
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_TEST4);
+	SCOPE_EXIT(chromaprint_free(ctx));
+
+	ASSERT_STREQ("AudioProcessor", chromaprint_get_stage_name(CHROMAPRINT_STAGE_AUDIO_PROCESSOR));
+	ASSERT_STREQ("FingerprintCalculator", chromaprint_get_stage_name(CHROMAPRINT_STAGE_FINGERPRINT_CALCULATOR));
+	ASSERT_EQ(nullptr, chromaprint_get_stage_name(CHROMAPRINT_NUM_STAGES));
+
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+	ASSERT_EQ(1, chromaprint_feed(ctx, data.data(), int(data.size())));
+	ASSERT_EQ(1, chromaprint_finish(ctx));
+
+	int fp_size;
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint_size(ctx, &fp_size));
+
+	ChromaprintStageStats stats[CHROMAPRINT_NUM_STAGES];
+	if (!PipelineStats::IsEnabled()) {
+		ASSERT_EQ(0, chromaprint_get_stats(ctx, stats, CHROMAPRINT_NUM_STAGES));
+		ASSERT_EQ(1, chromaprint_reset_stats(ctx));
+		return;
+	}
+
+	ASSERT_EQ(1, chromaprint_get_stats(ctx, stats, CHROMAPRINT_NUM_STAGES));
+	EXPECT_EQ(data.size(), stats[CHROMAPRINT_STAGE_AUDIO_PROCESSOR].items);
+	EXPECT_EQ(2u, stats[CHROMAPRINT_STAGE_AUDIO_PROCESSOR].calls);
+	EXPECT_LT(0u, stats[CHROMAPRINT_STAGE_SILENCE_REMOVER].items);
+	EXPECT_LE(stats[CHROMAPRINT_STAGE_FFT].items, stats[CHROMAPRINT_STAGE_SILENCE_REMOVER].items);
+	EXPECT_LT(0u, stats[CHROMAPRINT_STAGE_CHROMA].items);
+	EXPECT_EQ(stats[CHROMAPRINT_STAGE_CHROMA].items, stats[CHROMAPRINT_STAGE_CHROMA_FILTER].items);
+	EXPECT_LT(stats[CHROMAPRINT_STAGE_CHROMA_NORMALIZER].items, stats[CHROMAPRINT_STAGE_CHROMA_FILTER].items);
+	EXPECT_EQ(stats[CHROMAPRINT_STAGE_CHROMA_NORMALIZER].items, stats[CHROMAPRINT_STAGE_FINGERPRINT_CALCULATOR].items);
+	EXPECT_LT(uint64_t(fp_size), stats[CHROMAPRINT_STAGE_FINGERPRINT_CALCULATOR].items);
+	// the stages after the chroma get blocks of features, not single rows
+	for (int i : { CHROMAPRINT_STAGE_CHROMA_FILTER, CHROMAPRINT_STAGE_CHROMA_NORMALIZER, CHROMAPRINT_STAGE_FINGERPRINT_CALCULATOR }) {
+		SCOPED_TRACE(chromaprint_get_stage_name(ChromaprintStage(i)));
+		EXPECT_LT(stats[i].calls, stats[i].items);
+	}
+	for (int i = 0; i < CHROMAPRINT_NUM_STAGES; i++) {
+		EXPECT_GE(stats[i].time, 0.0);
+	}
+
+	ASSERT_EQ(1, chromaprint_reset_stats(ctx));
+	ASSERT_EQ(1, chromaprint_get_stats(ctx, stats, CHROMAPRINT_NUM_STAGES));
+	for (int i = 0; i < CHROMAPRINT_NUM_STAGES; i++) {
+		EXPECT_EQ(0u, stats[i].calls);
+		EXPECT_EQ(0.0, stats[i].time);
+	}
+}
+
+TEST(API, TestContextPool)
+{
+	std::vector<short> stereo = RepeatAudio(LoadAudioFile("data/test_stereo_44100.raw"), 3);
+	const auto expected = CalculateRawFingerprint(CHROMAPRINT_ALGORITHM_TEST2, stereo, 44100, 2);
+
+	ASSERT_EQ(nullptr, chromaprint_pool_new(-1));
+	ChromaprintContextPool *pool = chromaprint_pool_new(2);
+	ASSERT_NE(nullptr, pool);
+	SCOPE_EXIT(chromaprint_pool_free(pool));
+
+	int num_idle = -1;
+	ASSERT_EQ(1, chromaprint_pool_reserve(pool, CHROMAPRINT_ALGORITHM_TEST2, 3, 44100));
+	ASSERT_EQ(1, chromaprint_pool_get_num_idle(pool, CHROMAPRINT_ALGORITHM_TEST2, &num_idle));
+	ASSERT_EQ(2, num_idle);
+	ASSERT_EQ(1, chromaprint_pool_get_num_idle(pool, CHROMAPRINT_ALGORITHM_TEST1, &num_idle));
+	ASSERT_EQ(0, num_idle);
+
+	ChromaprintContext *ctx = chromaprint_pool_acquire(pool, CHROMAPRINT_ALGORITHM_TEST2);
+	ASSERT_NE(nullptr, ctx);
+	ASSERT_EQ(CHROMAPRINT_ALGORITHM_TEST2, chromaprint_get_algorithm(ctx));
+	ASSERT_EQ(1, chromaprint_pool_get_num_idle(pool, CHROMAPRINT_ALGORITHM_TEST2, &num_idle));
+	ASSERT_EQ(1, num_idle);
+
+	// only keeps the last second of the fingerprint
+	ASSERT_EQ(1, chromaprint_set_sliding_window(ctx, 1000, 0, nullptr, nullptr));
+	ASSERT_EQ(1, chromaprint_set_option(ctx, "resampler", CHROMAPRINT_RESAMPLER_POLYPHASE));
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 2));
+	ASSERT_EQ(1, chromaprint_feed(ctx, stereo.data(), int(stereo.size())));
+	ASSERT_EQ(1, chromaprint_finish(ctx));
+	int fp_size;
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint_size(ctx, &fp_size));
+	ASSERT_LT(fp_size, int(expected.size()));
+	chromaprint_pool_release(pool, ctx);
+
+	// the same context, with the default options
+	ChromaprintContext *ctx2 = chromaprint_pool_acquire(pool, CHROMAPRINT_ALGORITHM_TEST2);
+	ASSERT_EQ(ctx, ctx2);
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint_size(ctx2, &fp_size));
+	ASSERT_EQ(0, fp_size);
+	ASSERT_EQ(expected, CalculateRawFingerprint(ctx2, stereo, 44100, 2));
+
+	// more contexts than the pool keeps
+	ChromaprintContext *ctx3 = chromaprint_pool_acquire(pool, CHROMAPRINT_ALGORITHM_TEST2);
+	ChromaprintContext *ctx4 = chromaprint_pool_acquire(pool, CHROMAPRINT_ALGORITHM_TEST2);
+	ASSERT_NE(nullptr, ctx4);
+	ASSERT_EQ(1, chromaprint_pool_get_num_idle(pool, CHROMAPRINT_ALGORITHM_TEST2, &num_idle));
+	ASSERT_EQ(0, num_idle);
+	chromaprint_pool_release(pool, ctx2);
+	chromaprint_pool_release(pool, ctx3);
+	chromaprint_pool_release(pool, ctx4);
+	ASSERT_EQ(1, chromaprint_pool_get_num_idle(pool, CHROMAPRINT_ALGORITHM_TEST2, &num_idle));
+	ASSERT_EQ(2, num_idle);
+}
+
+TEST(API, TestContextPoolStartWithoutAllocation)
+{
+	std::vector<short> stereo = RepeatAudio(LoadAudioFile("data/test_stereo_44100.raw"), 3);
+
+	// the library allocates its memory through the allocator
+	int num_blocks = 0;
+	ChromaprintAllocator allocator = { CountingAllocate, CountingDeallocate, nullptr, &num_blocks };
+	ASSERT_EQ(1, chromaprint_set_allocator(&allocator));
+	SCOPE_EXIT(chromaprint_set_allocator(nullptr));
+
+	ChromaprintContextPool *pool = chromaprint_pool_new(1);
+	ASSERT_NE(nullptr, pool);
+	SCOPE_EXIT(chromaprint_pool_free(pool));
+
+	const int resamplers[] = { CHROMAPRINT_RESAMPLER_AVRESAMPLE, CHROMAPRINT_RESAMPLER_POLYPHASE };
+	const int sample_rates[] = { 44100, 48000, 11025, 44100 };
+	for (int check = 0; check < 2; check++) {
+		for (int resampler : resamplers) {
+			for (int sample_rate : sample_rates) {
+				ChromaprintContext *ctx = chromaprint_pool_acquire(pool, CHROMAPRINT_ALGORITHM_TEST4);
+				ASSERT_NE(nullptr, ctx);
+				ASSERT_EQ(1, chromaprint_set_option(ctx, "resampler", resampler));
+
+				g_num_allocations = 0;
+				g_count_allocations = true;
+				ASSERT_EQ(1, chromaprint_start(ctx, sample_rate, 2));
+				g_count_allocations = false;
+				// the first time, the filters for the sample rate are built
+				if (check) {
+					EXPECT_EQ(0, g_num_allocations) << "resampler " << resampler << ", sample rate " << sample_rate;
+				}
+
+				ASSERT_EQ(1, chromaprint_feed(ctx, stereo.data(), int(stereo.size())));
+				ASSERT_EQ(1, chromaprint_finish(ctx));
+				chromaprint_pool_release(pool, ctx);
+			}
+		}
+	}
+}
+
+TEST(API, TestMemoryUsage)
+{
+	std::vector<short> stereo = RepeatAudio(LoadAudioFile("data/test_stereo_44100.raw"), 3);
+
+	int num_blocks = 0;
+	ChromaprintAllocator allocator = { CountingAllocate, CountingDeallocate, nullptr, &num_blocks };
+	ASSERT_EQ(1, chromaprint_set_allocator(&allocator));
+	SCOPE_EXIT(chromaprint_set_allocator(nullptr));
+
+	uint64_t current = 0, peak = 0;
+	ASSERT_EQ(0, chromaprint_get_memory_usage(nullptr, &current, &peak));
+
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_TEST2);
+	ASSERT_NE(nullptr, ctx);
+	ASSERT_GT(num_blocks, 0);
+	ASSERT_EQ(1, chromaprint_get_memory_usage(ctx, &current, &peak));
+	ASSERT_GT(current, 0u);
+	ASSERT_EQ(current, peak);
+	const uint64_t initial = current;
+
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 2));
+	ASSERT_EQ(1, chromaprint_feed(ctx, stereo.data(), int(stereo.size())));
+	ASSERT_EQ(1, chromaprint_finish(ctx));
+	ASSERT_EQ(1, chromaprint_get_memory_usage(ctx, &current, &peak));
+	ASSERT_GT(peak, initial);
+	ASSERT_GE(peak, current);
+
+	// the result is allocated with the allocator, but it's not counted
+	const int num_ctx_blocks = num_blocks;
+	char *fp = nullptr;
+	ASSERT_EQ(1, chromaprint_get_fingerprint(ctx, &fp));
+	ASSERT_EQ(num_ctx_blocks + 1, num_blocks);
+	uint64_t current_with_fp = 0;
+	ASSERT_EQ(1, chromaprint_get_memory_usage(ctx, &current_with_fp, nullptr));
+	ASSERT_EQ(current, current_with_fp);
+	chromaprint_dealloc(fp);
+	ASSERT_EQ(num_ctx_blocks, num_blocks);
+
+	chromaprint_free(ctx);
+	ASSERT_EQ(0, num_blocks);
+}
+
 }; // namespace chromaprint
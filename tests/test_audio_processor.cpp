@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <algorithm>
+#include <cmath>
 #include <vector>
 #include <string>
 #include <fstream>
@@ -10,6 +11,33 @@
 
 using namespace chromaprint;
 
+namespace {
+
+// Keeps the samples passed to ConsumeFloat() unrounded.
+class FloatAudioBuffer : public AudioConsumer
+{
+public:
+	void Consume(const int16_t *input, int length) override
+	{
+		m_data.insert(m_data.end(), input, input + length);
+	}
+
+	void ConsumeFloat(const float *input, int length) override
+	{
+		m_data.insert(m_data.end(), input, input + length);
+		m_num_float_samples += length;
+	}
+
+	const std::vector<float> &data() { return m_data; }
+	size_t num_float_samples() const { return m_num_float_samples; }
+
+private:
+	std::vector<float> m_data;
+	size_t m_num_float_samples = 0;
+};
+
+}; // namespace
+
 TEST(AudioProcessor, Accessors)
 {
 	std::vector<short> data = LoadAudioFile("data/test_mono_44100.raw");
@@ -147,3 +175,152 @@ TEST(AudioProcessor, ChunkedConsumeMatchesSingleConsume)
 		}
 	}
 }
+
+TEST(AudioProcessor, SampleFormats)
+{
+	std::vector<short> data = LoadAudioFile("data/test_stereo_44100.raw");
+
+	AudioBuffer expected;
+	AudioProcessor reference(44100, &expected);
+	reference.Reset(44100, 2);
+	reference.Consume(data.data(), data.size());
+	reference.Flush();
+
+	std::vector<int32_t> data_s32(data.size());
+	std::vector<float> data_float(data.size());
+	for (size_t i = 0; i < data.size(); i++) {
+		data_s32[i] = int32_t(data[i]) << 16;
+		data_float[i] = data[i] / 32768.0f;
+	}
+
+	std::vector<int16_t> left(data.size() / 2), right(data.size() / 2);
+	std::vector<float> left_float(data.size() / 2), right_float(data.size() / 2);
+	for (size_t i = 0; i < left.size(); i++) {
+		left[i] = data[2 * i];
+		right[i] = data[2 * i + 1];
+		left_float[i] = data_float[2 * i];
+		right_float[i] = data_float[2 * i + 1];
+	}
+	const int16_t *planar[] = { left.data(), right.data() };
+	const float *planar_float[] = { left_float.data(), right_float.data() };
+
+	AudioBuffer buffer_s32, buffer_planar, buffer_float, buffer_planar_float;
+	AudioProcessor processor(44100, &buffer_s32);
+
+	// 32-bit and float input is not truncated when downmixing, the buffer
+	// gets it unrounded and rounds it, so the result can differ by one.
+	processor.Reset(44100, 2);
+	for (size_t offset = 0; offset < data.size(); offset += 1001) {
+		processor.Consume(data_s32.data() + offset, std::min(size_t(1001), data.size() - offset));
+	}
+	processor.Flush();
+	ASSERT_EQ(expected.data().size(), buffer_s32.data().size());
+	for (size_t i = 0; i < expected.data().size(); i++) {
+		ASSERT_NEAR(expected.data()[i], buffer_s32.data()[i], 1) << "Signals differ at index " << i;
+	}
+
+	processor.set_consumer(&buffer_planar);
+	processor.Reset(44100, 2);
+	processor.ConsumePlanar(planar, left.size());
+	processor.Flush();
+	EXPECT_EQ(expected.data(), buffer_planar.data());
+
+	processor.set_consumer(&buffer_float);
+	processor.Reset(44100, 2);
+	for (size_t offset = 0; offset < data.size(); offset += 1001) {
+		processor.Consume(data_float.data() + offset, std::min(size_t(1001), data.size() - offset));
+	}
+	processor.Flush();
+	ASSERT_EQ(expected.data().size(), buffer_float.data().size());
+	for (size_t i = 0; i < expected.data().size(); i++) {
+		ASSERT_NEAR(expected.data()[i], buffer_float.data()[i], 1) << "Signals differ at index " << i;
+	}
+
+	processor.set_consumer(&buffer_planar_float);
+	processor.Reset(44100, 2);
+	processor.ConsumePlanar(planar_float, left.size());
+	processor.Flush();
+	EXPECT_EQ(buffer_float.data(), buffer_planar_float.data());
+}
+
+TEST(AudioProcessor, FloatClipping)
+{
+	const float data[] = { 0.0f, 0.5f, -0.5f, 1.0f, -1.0f, 2.0f, -2.0f };
+
+	AudioBuffer buffer;
+	AudioProcessor processor(44100, &buffer);
+	processor.Reset(44100, 1);
+	processor.Consume(data, NELEMS(data));
+	processor.Flush();
+
+	const std::vector<int16_t> expected = { 0, 16384, -16384, 32767, -32768, 32767, -32768 };
+	EXPECT_EQ(expected, buffer.data());
+}
+
+TEST(AudioProcessor, FloatNotRounded)
+{
+	const float data[] = { 0.25f / 32768, -100.75f / 32768, 0.5f, 1.0f, -2.0f, 3.0f / 32768, 0.0f };
+	const int32_t data_s32[] = { 0x4000, -0x10000 - 0x8000 };
+
+	FloatAudioBuffer buffer;
+	AudioProcessor processor(44100, &buffer);
+	processor.Reset(44100, 1);
+	processor.Consume(data, NELEMS(data));
+	processor.Consume(data_s32, NELEMS(data_s32));
+	processor.Flush();
+
+	const std::vector<float> expected = { 0.25f, -100.75f, 16384.0f, 32767.0f, -32768.0f, 3.0f, 0.0f, 0.25f, -1.5f };
+	ASSERT_EQ(expected.size(), buffer.num_float_samples());
+	for (size_t i = 0; i < expected.size(); i++) {
+		ASSERT_FLOAT_EQ(expected[i], buffer.data()[i]) << "Signals differ at index " << i;
+	}
+
+	// 3.0 averaged with 0.5 is 1.75
+	const float stereo[] = { 3.0f / 32768, 0.5f / 32768 };
+	const int16_t stereo_s16[] = { 10, 11 };
+	FloatAudioBuffer buffer2;
+	processor.set_consumer(&buffer2);
+	processor.Reset(44100, 2);
+	processor.Consume(stereo_s16, NELEMS(stereo_s16));
+	processor.Consume(stereo, NELEMS(stereo));
+	processor.Flush();
+	ASSERT_EQ(2u, buffer2.num_float_samples());
+	EXPECT_EQ(std::vector<float>({ 10.0f, 1.75f }), buffer2.data());
+}
+
+TEST(AudioProcessor, ResampleFloat)
+{
+	std::vector<short> data = LoadAudioFile("data/test_mono_44100.raw");
+	std::vector<float> data_float(data.size());
+	for (size_t i = 0; i < data.size(); i++) {
+		data_float[i] = (data[i] + 0.25f) / 32768.0f;
+	}
+
+	AudioBuffer expected;
+	AudioProcessor reference(11025, &expected);
+	reference.set_resampler(CHROMAPRINT_RESAMPLER_POLYPHASE);
+	reference.Reset(44100, 1);
+	reference.Consume(data.data(), data.size());
+	reference.Flush();
+
+	// the float input is resampled without rounding it to 16 bits first
+	FloatAudioBuffer buffer;
+	AudioProcessor processor(11025, &buffer);
+	processor.set_resampler(CHROMAPRINT_RESAMPLER_POLYPHASE);
+	processor.Reset(44100, 1);
+	for (size_t offset = 0; offset < data.size(); offset += 1001) {
+		processor.Consume(data_float.data() + offset, std::min(size_t(1001), data.size() - offset));
+	}
+	processor.Flush();
+
+	ASSERT_EQ(expected.data().size(), buffer.data().size());
+	ASSERT_EQ(buffer.data().size(), buffer.num_float_samples());
+	size_t num_fractional = 0;
+	for (size_t i = 0; i < expected.data().size(); i++) {
+		ASSERT_NEAR(expected.data()[i] + 0.25f, buffer.data()[i], 0.51f) << "Signals differ at index " << i;
+		if (buffer.data()[i] != std::floor(buffer.data()[i])) {
+			num_fractional++;
+		}
+	}
+	EXPECT_GT(num_fractional, buffer.data().size() / 2);
+}
@@ -122,3 +122,49 @@ TEST(Chroma, InterpolatedGSharp) {
 	}
 }
 
+
+TEST(Chroma, Blocks) {
+	struct FeatureVectorCollector : public FeatureVectorConsumer {
+		void Consume(std::vector<double> &features) override {
+			features_list.push_back(features);
+		}
+		std::vector<std::vector<double>> features_list;
+	};
+
+	std::vector<FFTFrame> frames;
+	for (int i = 0; i < 10; i++) {
+		FFTFrame frame(128);
+		for (size_t j = 0; j < frame.size(); j++) {
+			frame[j] = (i * 31 + j * 17) % 23;
+		}
+		frames.push_back(frame);
+	}
+
+	FeatureVectorCollector expected;
+	Chroma chroma1(10, 510, 256, 1000, &expected);
+	for (const auto &frame : frames) {
+		chroma1.Consume(frame);
+	}
+	ASSERT_EQ(10, expected.features_list.size());
+
+	FeatureVectorCollector actual;
+	Chroma chroma2(10, 510, 256, 1000, &actual);
+	chroma2.set_block_size(4);
+	for (const auto &frame : frames) {
+		chroma2.Consume(frame);
+	}
+	ASSERT_EQ(8, actual.features_list.size());
+	chroma2.Flush();
+	ASSERT_EQ(expected.features_list, actual.features_list);
+}
+
+TEST(Chroma, SharedNotes) {
+	auto notes1 = GetChromaNotes(10, 510, 256, 1000);
+	auto notes2 = GetChromaNotes(10, 510, 256, 1000);
+	auto notes3 = GetChromaNotes(10, 510, 256, 2000);
+	ASSERT_EQ(notes1.get(), notes2.get());
+	ASSERT_NE(notes1.get(), notes3.get());
+	ASSERT_EQ(3, notes1->min_index);
+	ASSERT_EQ(128, notes1->max_index);
+	ASSERT_EQ(0, notes1->notes[113]);
+}
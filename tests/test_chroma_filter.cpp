@@ -71,3 +71,39 @@ TEST(ChromaFilter, Diff) {
 	EXPECT_EQ(-1.0, image[1][1]);
 }
 
+
+TEST(ChromaFilter, Blocks) {
+	double coefficients[] = { 0.25, 0.75, 2.0, 1.0, -0.5 };
+	std::vector<double> input(20 * 12);
+	for (size_t i = 0; i < input.size(); i++) {
+		input[i] = (i * 7919) % 13 - 6.5;
+	}
+
+	Image expected(12);
+	ImageBuilder expected_builder(&expected);
+	ChromaFilter expected_filter(coefficients, 5, &expected_builder);
+	for (size_t i = 0; i < 20; i++) {
+		std::vector<double> row(input.begin() + i * 12, input.begin() + (i + 1) * 12);
+		expected_filter.Consume(row);
+	}
+	ASSERT_EQ(16, expected.NumRows());
+
+	// blocks of varying size, including ones shorter than the filter
+	Image actual(12);
+	ImageBuilder actual_builder(&actual);
+	ChromaFilter actual_filter(coefficients, 5, &actual_builder);
+	const size_t block_sizes[] = { 1, 3, 0, 9, 2, 5 };
+	size_t row = 0;
+	for (auto block_size : block_sizes) {
+		actual_filter.ConsumeBlock(input.data() + row * 12, block_size, 12);
+		row += block_size;
+	}
+	ASSERT_EQ(20, row);
+
+	ASSERT_EQ(expected.NumRows(), actual.NumRows());
+	for (int i = 0; i < expected.NumRows(); i++) {
+		for (int j = 0; j < 12; j++) {
+			EXPECT_EQ(expected[i][j], actual[i][j]) << "Different value at " << i << ", " << j;
+		}
+	}
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+#include "fingerprint_calculator.h"
+#include "fingerprint_consumer.h"
+#include "fingerprinter_configuration.h"
+
+using namespace chromaprint;
+
+namespace {
+
+struct FingerprintCollector : public FingerprintConsumer {
+	void Consume(const uint32_t *fingerprint, size_t size, size_t offset) override {
+		for (size_t i = 0; i < size; i++) {
+			items.push_back(fingerprint[i]);
+			offsets.push_back(offset + i);
+		}
+	}
+	Vector<uint32_t> items;
+	std::vector<size_t> offsets;
+};
+
+std::vector<double> GenerateFeatures(size_t num_rows)
+{
+	std::vector<double> features(num_rows * 12);
+	uint32_t seed = 12345;
+	for (auto &x : features) {
+		seed = seed * 1103515245 + 12345;
+		x = (seed >> 16) / 65536.0;
+	}
+	return features;
+}
+
+};
+
+TEST(FingerprintCalculator, Blocks) {
+	std::unique_ptr<FingerprinterConfiguration> config(CreateFingerprinterConfiguration(CHROMAPRINT_ALGORITHM_TEST2));
+	const size_t num_rows = 600;
+	auto features = GenerateFeatures(num_rows);
+
+	FingerprintCalculator expected_calculator(config->classifiers(), config->num_classifiers());
+	for (size_t i = 0; i < num_rows; i++) {
+		std::vector<double> row(features.begin() + i * 12, features.begin() + (i + 1) * 12);
+		expected_calculator.Consume(row);
+	}
+	const auto expected = expected_calculator.GetFingerprint();
+	ASSERT_EQ(num_rows - 15, expected.size());
+
+	// a block longer than the rolling image, and blocks shorter than the filters
+	const size_t block_sizes[] = { 400, 3, 0, 1, 10, 186 };
+
+	FingerprintCalculator calculator(config->classifiers(), config->num_classifiers());
+	size_t row = 0;
+	for (auto block_size : block_sizes) {
+		auto block = features;
+		calculator.ConsumeBlock(block.data() + row * 12, block_size, 12);
+		row += block_size;
+	}
+	ASSERT_EQ(num_rows, row);
+	ASSERT_EQ(expected, calculator.GetFingerprint());
+
+	FingerprintCollector collector;
+	calculator.Reset();
+	calculator.set_consumer(&collector);
+	row = 0;
+	for (auto block_size : block_sizes) {
+		auto block = features;
+		calculator.ConsumeBlock(block.data() + row * 12, block_size, 12);
+		row += block_size;
+	}
+	ASSERT_EQ(expected, collector.items);
+	for (size_t i = 0; i < collector.offsets.size(); i++) {
+		ASSERT_EQ(i, collector.offsets[i]);
+	}
+}
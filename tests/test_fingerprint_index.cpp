@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <fstream>
+#include "fingerprint_index.h"
+#include "chromaprint.h"
+
+namespace chromaprint
+{
+
+static std::vector<uint32_t> GenerateFingerprint(std::mt19937 &rng, size_t size)
+{
+	std::vector<uint32_t> fp(size);
+	for (auto &x : fp) {
+		x = rng();
+	}
+	return fp;
+}
+
+static std::vector<uint32_t> AddNoise(std::mt19937 &rng, const uint32_t *begin, const uint32_t *end)
+{
+	std::vector<uint32_t> fp(begin, end);
+	for (auto &x : fp) {
+		x ^= 1u << (rng() % 32);
+	}
+	return fp;
+}
+
+TEST(FingerprintIndex, Search)
+{
+	std::mt19937 rng(1234);
+	std::vector<std::vector<uint32_t>> fps;
+	FingerprintIndex index(CHROMAPRINT_ALGORITHM_TEST2);
+	for (uint32_t i = 0; i < 100; i++) {
+		fps.push_back(GenerateFingerprint(rng, 500 + i));
+		index.Add(1000 + i, fps.back());
+	}
+
+	std::vector<FingerprintIndexResult> results;
+	ASSERT_TRUE(index.Search(fps[0], 10, results));
+	ASSERT_TRUE(results.empty());
+
+	index.Build();
+	ASSERT_EQ(100, index.num_fingerprints());
+
+	for (uint32_t i = 0; i < 100; i += 7) {
+		const auto query = AddNoise(rng, fps[i].data() + 200, fps[i].data() + 400);
+		ASSERT_TRUE(index.Search(query, 10, results));
+		ASSERT_EQ(1, results.size());
+		EXPECT_EQ(1000 + i, results[0].id);
+		EXPECT_EQ(200, results[0].offset);
+		EXPECT_GE(results[0].votes, 10u);
+		EXPECT_EQ(200, results[0].duration);
+		EXPECT_NEAR(1.0, results[0].score, 0.1);
+	}
+}
+
+TEST(FingerprintIndex, IncrementalBuild)
+{
+	std::mt19937 rng(5678);
+	const auto fp1 = GenerateFingerprint(rng, 300);
+	const auto fp2 = GenerateFingerprint(rng, 300);
+
+	FingerprintIndex index(CHROMAPRINT_ALGORITHM_TEST2);
+	index.Add(1, fp1);
+	index.Build();
+	index.Add(2, fp2);
+	index.Build();
+	ASSERT_EQ(2, index.num_fingerprints());
+
+	std::vector<FingerprintIndexResult> results;
+	ASSERT_TRUE(index.Search(fp1, 10, results));
+	ASSERT_EQ(1, results.size());
+	EXPECT_EQ(1, results[0].id);
+	EXPECT_EQ(0, results[0].offset);
+	EXPECT_EQ(300, results[0].votes);
+
+	ASSERT_TRUE(index.Search(fp2.data() + 100, 100, 10, results));
+	ASSERT_EQ(1, results.size());
+	EXPECT_EQ(2, results[0].id);
+	EXPECT_EQ(100, results[0].offset);
+}
+
+TEST(FingerprintIndex, WithoutVerification)
+{
+	std::mt19937 rng(42);
+	const auto fp1 = GenerateFingerprint(rng, 300);
+	auto fp2 = fp1;
+	std::rotate(fp2.begin(), fp2.begin() + 50, fp2.end());
+
+	FingerprintIndex index(CHROMAPRINT_ALGORITHM_TEST2);
+	index.set_verify(false);
+	index.Add(1, fp1);
+	index.Add(2, fp2);
+	index.Build();
+
+	// the query starts before fp2, so the offset there is negative
+	std::vector<FingerprintIndexResult> results;
+	ASSERT_TRUE(index.Search(fp1, 10, results));
+	ASSERT_EQ(2, results.size());
+	EXPECT_EQ(1, results[0].id);
+	EXPECT_EQ(0, results[0].offset);
+	EXPECT_EQ(300, results[0].votes);
+	EXPECT_EQ(-1.0, results[0].score);
+	EXPECT_EQ(2, results[1].id);
+	EXPECT_EQ(-50, results[1].offset);
+	EXPECT_EQ(250, results[1].votes);
+
+	ASSERT_TRUE(index.Search(fp1, 1, results));
+	ASSERT_EQ(1, results.size());
+
+	index.set_max_posting_list_size(1);
+	ASSERT_TRUE(index.Search(fp1, 10, results));
+	ASSERT_TRUE(results.empty());
+}
+
+TEST(FingerprintIndex, VerifiedOrderedByScore)
+{
+	std::mt19937 rng(1357);
+	const auto query = GenerateFingerprint(rng, 300);
+
+	// every item votes for fp1, but differs in two bits outside of the key
+	auto fp1 = query;
+	for (auto &x : fp1) {
+		x ^= 0x3;
+	}
+
+	// only the second half of fp2 votes, but it's an exact match
+	auto fp2 = GenerateFingerprint(rng, 150);
+	fp2.insert(fp2.end(), query.begin() + 150, query.end());
+
+	FingerprintIndex index(CHROMAPRINT_ALGORITHM_TEST2);
+	index.Add(1, fp1);
+	index.Add(2, fp2);
+	index.Build();
+
+	std::vector<FingerprintIndexResult> results;
+	ASSERT_TRUE(index.Search(query, 10, results));
+	ASSERT_EQ(2, results.size());
+	EXPECT_EQ(2, results[0].id);
+	EXPECT_EQ(1, results[1].id);
+	EXPECT_LT(results[0].votes, results[1].votes);
+	EXPECT_LT(results[0].score, results[1].score);
+}
+
+TEST(FingerprintIndex, SaveLoad)
+{
+	std::mt19937 rng(4321);
+	std::vector<std::vector<uint32_t>> fps;
+	FingerprintIndex index(CHROMAPRINT_ALGORITHM_TEST2);
+	for (uint32_t i = 0; i < 20; i++) {
+		fps.push_back(GenerateFingerprint(rng, 300));
+		index.Add(100 + i, fps.back());
+	}
+	index.Build();
+
+	const std::string file_name = testing::TempDir() + "chromaprint_test_index.cpi";
+	ASSERT_TRUE(index.Save(file_name));
+
+	FingerprintIndex loaded(CHROMAPRINT_ALGORITHM_TEST1);
+	ASSERT_TRUE(loaded.Load(file_name));
+	std::remove(file_name.c_str());
+
+	ASSERT_TRUE(loaded.is_read_only());
+	ASSERT_EQ(CHROMAPRINT_ALGORITHM_TEST2, loaded.algorithm());
+	ASSERT_EQ(20, loaded.num_fingerprints());
+	ASSERT_FALSE(loaded.Add(1, fps[0]));
+	ASSERT_FALSE(loaded.Build());
+
+	std::vector<FingerprintIndexResult> expected, actual;
+	for (uint32_t i = 0; i < 20; i++) {
+		const auto query = AddNoise(rng, fps[i].data() + 50, fps[i].data() + 250);
+		ASSERT_TRUE(index.Search(query, 10, expected));
+		ASSERT_TRUE(loaded.Search(query, 10, actual));
+		ASSERT_EQ(1, actual.size());
+		ASSERT_EQ(expected.size(), actual.size());
+		EXPECT_EQ(100 + i, actual[0].id);
+		EXPECT_EQ(expected[0].id, actual[0].id);
+		EXPECT_EQ(expected[0].offset, actual[0].offset);
+		EXPECT_EQ(expected[0].votes, actual[0].votes);
+		EXPECT_EQ(expected[0].score, actual[0].score);
+		EXPECT_EQ(expected[0].duration, actual[0].duration);
+	}
+}
+
+TEST(FingerprintIndex, LoadInvalid)
+{
+	const std::string file_name = testing::TempDir() + "chromaprint_test_invalid_index.cpi";
+	{
+		std::ofstream file(file_name.c_str(), std::ofstream::binary);
+		file << "this is not an index file, but it is long enough to contain a header";
+		file << std::string(200, 'x');
+	}
+	FingerprintIndex index(CHROMAPRINT_ALGORITHM_TEST2);
+	ASSERT_FALSE(index.Load(file_name));
+	std::remove(file_name.c_str());
+	ASSERT_FALSE(index.Load(file_name));
+	ASSERT_FALSE(index.is_read_only());
+}
+
+};
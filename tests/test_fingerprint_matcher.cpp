@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <vector>
 #include <fstream>
+#include <random>
 #include "fingerprinter_configuration.h"
 #include "fingerprint_matcher.h"
 #include "utils.h"
@@ -24,4 +25,54 @@ TEST(FingerprintMatcher, Match)
 	matcher.Match(fp1, fp2);
 }
 
+TEST(FingerprintMatcher, AlignmentMethods)
+{
+	std::mt19937 rng(42);
+	std::vector<uint32_t> fp1(2000);
+	for (auto &x : fp1) {
+		x = rng();
+	}
+	// a noisy copy of a part of fp1, with a run of repeated hashes
+	std::vector<uint32_t> fp2(fp1.begin() + 300, fp1.begin() + 1500);
+	for (auto &x : fp2) {
+		x ^= 1u << (rng() % 20);
+	}
+	std::fill(fp2.end() - 100, fp2.end(), fp2[0]);
+
+	FingerprintMatcher matcher1(CreateFingerprinterConfiguration(CHROMAPRINT_ALGORITHM_TEST2));
+	matcher1.set_alignment_method(FingerprintMatcher::ALIGNMENT_SORT);
+	ASSERT_TRUE(matcher1.Match(fp1, fp2));
+
+	FingerprintMatcher matcher2(CreateFingerprinterConfiguration(CHROMAPRINT_ALGORITHM_TEST2));
+	matcher2.set_alignment_method(FingerprintMatcher::ALIGNMENT_BUCKETS);
+	ASSERT_TRUE(matcher2.Match(fp1, fp2));
+
+	ASSERT_EQ(matcher1.histogram(), matcher2.histogram());
+	ASSERT_EQ(matcher1.segments().size(), matcher2.segments().size());
+	ASSERT_FALSE(matcher1.segments().empty());
+	for (size_t i = 0; i < matcher1.segments().size(); i++) {
+		EXPECT_EQ(matcher1.segments()[i].pos1, matcher2.segments()[i].pos1);
+		EXPECT_EQ(matcher1.segments()[i].pos2, matcher2.segments()[i].pos2);
+		EXPECT_EQ(matcher1.segments()[i].duration, matcher2.segments()[i].duration);
+		EXPECT_EQ(matcher1.segments()[i].score, matcher2.segments()[i].score);
+	}
+	EXPECT_EQ(300, matcher1.segments()[0].pos1);
+	EXPECT_EQ(0, matcher1.segments()[0].pos2);
+
+	// the repeated hash doesn't vote for any offset with a bucket size limit
+	matcher2.set_max_bucket_size(50);
+	ASSERT_TRUE(matcher2.Match(fp1, fp2));
+	uint32_t total1 = 0, total2 = 0;
+	for (auto count : matcher1.histogram()) {
+		total1 += count;
+	}
+	for (auto count : matcher2.histogram()) {
+		total2 += count;
+	}
+	EXPECT_LE(total1 - total2, 100u * 2u);
+	EXPECT_GE(total1 - total2, 100u);
+	ASSERT_FALSE(matcher2.segments().empty());
+	EXPECT_EQ(300, matcher2.segments()[0].pos1);
+}
+
 };
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "fingerprint_window.h"
+
+namespace chromaprint
+{
+
+class CollectingConsumer : public FingerprintConsumer {
+public:
+	virtual void Consume(const uint32_t *fingerprint, size_t size, size_t offset) override {
+		windows.emplace_back(fingerprint, fingerprint + size);
+		offsets.push_back(offset);
+	}
+	std::vector<std::vector<uint32_t>> windows;
+	std::vector<size_t> offsets;
+};
+
+TEST(FingerprintWindow, KeepsLastItems)
+{
+	FingerprintWindow window(4);
+	ASSERT_TRUE(window.GetFingerprint().empty());
+
+	const uint32_t data[] = { 1, 2, 3, 4, 5, 6, 7 };
+	window.Consume(data, 3, 0);
+	EXPECT_EQ(Vector<uint32_t>({ 1, 2, 3 }), window.GetFingerprint());
+	EXPECT_EQ(0, window.offset());
+
+	window.Consume(data + 3, 4, 3);
+	EXPECT_EQ(Vector<uint32_t>({ 4, 5, 6, 7 }), window.GetFingerprint());
+	EXPECT_EQ(3, window.offset());
+
+	window.ClearFingerprint();
+	EXPECT_TRUE(window.GetFingerprint().empty());
+	window.Consume(data, 1, 7);
+	EXPECT_EQ(Vector<uint32_t>({ 1 }), window.GetFingerprint());
+	EXPECT_EQ(7, window.offset());
+
+	window.Reset();
+	window.Consume(data, 2, 0);
+	EXPECT_EQ(Vector<uint32_t>({ 1, 2 }), window.GetFingerprint());
+	EXPECT_EQ(0, window.offset());
+}
+
+TEST(FingerprintWindow, EmitsOverlappingWindows)
+{
+	CollectingConsumer consumer;
+	FingerprintWindow window(4, 2, &consumer);
+
+	for (uint32_t i = 0; i < 9; i++) {
+		window.Consume(&i, 1, i);
+	}
+
+	ASSERT_EQ(3, consumer.windows.size());
+	EXPECT_EQ(std::vector<uint32_t>({ 0, 1, 2, 3 }), consumer.windows[0]);
+	EXPECT_EQ(std::vector<uint32_t>({ 2, 3, 4, 5 }), consumer.windows[1]);
+	EXPECT_EQ(std::vector<uint32_t>({ 4, 5, 6, 7 }), consumer.windows[2]);
+	EXPECT_EQ(std::vector<size_t>({ 0, 2, 4 }), consumer.offsets);
+}
+
+TEST(FingerprintWindow, EmitsNonOverlappingWindows)
+{
+	CollectingConsumer consumer;
+	FingerprintWindow window(3, 5, &consumer);
+
+	std::vector<uint32_t> data(13);
+	for (uint32_t i = 0; i < data.size(); i++) {
+		data[i] = i;
+	}
+	window.Consume(data.data(), data.size(), 0);
+
+	ASSERT_EQ(3, consumer.windows.size());
+	EXPECT_EQ(std::vector<uint32_t>({ 0, 1, 2 }), consumer.windows[0]);
+	EXPECT_EQ(std::vector<uint32_t>({ 5, 6, 7 }), consumer.windows[1]);
+	EXPECT_EQ(std::vector<uint32_t>({ 10, 11, 12 }), consumer.windows[2]);
+}
+
+};
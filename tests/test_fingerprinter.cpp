@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include "test_utils.h"
+#include "fingerprinter.h"
+#include "multi_fingerprinter.h"
+#include "fingerprinter_configuration.h"
+#include "fingerprint_consumer.h"
+#include "utils.h"
+
+using namespace chromaprint;
+
+namespace {
+
+template <typename FingerprinterType>
+Vector<uint32_t> CalculateFingerprint(int algorithm, const std::vector<short> &data, int sample_rate, int num_channels, int num_threads = 1)
+{
+	FingerprinterType fingerprinter(CreateFingerprinterConfiguration(algorithm));
+	if (num_threads != 1) {
+		EXPECT_TRUE(fingerprinter.SetOption("num_threads", num_threads));
+	}
+	fingerprinter.Start(sample_rate, num_channels);
+	// feed the data in chunks, like a decoder would
+	const size_t chunk_size = 4096 * num_channels;
+	for (size_t i = 0; i < data.size(); i += chunk_size) {
+		fingerprinter.Consume(data.data() + i, int(std::min(chunk_size, data.size() - i)));
+	}
+	fingerprinter.Finish();
+	return fingerprinter.GetFingerprint();
+}
+
+// The test files are only a few seconds long, repeat them to get enough
+// fingerprint items for a meaningful comparison.
+std::vector<short> LoadLongAudioFile(const std::string &file_name, int sample_rate, int num_channels, int duration = 10)
+{
+	const auto file_data = LoadAudioFile(file_name);
+	std::vector<short> data;
+	while (data.size() < size_t(duration * sample_rate * num_channels)) {
+		data.insert(data.end(), file_data.begin(), file_data.end());
+	}
+	return data;
+}
+
+};
+
+// The float pipeline is not guaranteed to be bit-identical to the double
+// one, when a classifier compares two almost equal areas of the image, the
+// rounding of the features to float can move the value across a quantizer
+// threshold. The integral image is kept in double, so this is rare enough
+// that the fingerprints of the test files are identical.
+TEST(Fingerprinter, FloatMatchesDouble)
+{
+	struct {
+		const char *file_name;
+		int sample_rate;
+		int num_channels;
+	} inputs[] = {
+		{ "data/test_mono_44100.raw", 44100, 1 },
+		{ "data/test_stereo_44100.raw", 44100, 2 },
+		{ "data/test_mono_11025.raw", 11025, 1 },
+		{ "data/test_mono_8000.raw", 8000, 1 },
+	};
+
+	for (const auto &input : inputs) {
+		const auto data = LoadLongAudioFile(input.file_name, input.sample_rate, input.num_channels);
+		for (int algorithm = CHROMAPRINT_ALGORITHM_TEST1; algorithm <= CHROMAPRINT_ALGORITHM_TEST5; algorithm++) {
+			SCOPED_TRACE(std::string(input.file_name) + " algorithm " + std::to_string(algorithm + 1));
+			const auto fp_double = CalculateFingerprint<BasicFingerprinter<double>>(algorithm, data, input.sample_rate, input.num_channels);
+			const auto fp_float = CalculateFingerprint<BasicFingerprinter<float>>(algorithm, data, input.sample_rate, input.num_channels);
+			ASSERT_FALSE(fp_double.empty());
+			ASSERT_EQ(fp_double.size(), fp_float.size());
+			for (size_t i = 0; i < fp_double.size(); i++) {
+				ASSERT_EQ(fp_double[i], fp_float[i]) << "Different at index " << i;
+			}
+		}
+	}
+}
+
+// The static pipeline is not available if the stages are instrumented.
+#if !ENABLE_STATS
+TEST(Fingerprinter, StaticMatchesDynamic)
+{
+	const auto data = LoadLongAudioFile("data/test_stereo_44100.raw", 44100, 2);
+	for (int algorithm = CHROMAPRINT_ALGORITHM_TEST1; algorithm <= CHROMAPRINT_ALGORITHM_TEST5; algorithm++) {
+		SCOPED_TRACE("algorithm " + std::to_string(algorithm + 1));
+		const auto fp_static = CalculateFingerprint<BasicFingerprinter<double, StaticFingerprintPipeline<double>>>(algorithm, data, 44100, 2);
+		const auto fp_dynamic = CalculateFingerprint<BasicFingerprinter<double, DynamicFingerprintPipeline<double>>>(algorithm, data, 44100, 2);
+		ASSERT_FALSE(fp_static.empty());
+		ASSERT_EQ(fp_dynamic, fp_static);
+	}
+}
+#endif
+
+// Long enough to be split into shards both while consuming the audio and
+// when it is finished.
+TEST(Fingerprinter, ShardedMatchesSequential)
+{
+	const auto data = LoadLongAudioFile("data/test_mono_11025.raw", 11025, 1, 135);
+	for (int algorithm = CHROMAPRINT_ALGORITHM_TEST1; algorithm <= CHROMAPRINT_ALGORITHM_TEST5; algorithm++) {
+		SCOPED_TRACE("algorithm " + std::to_string(algorithm + 1));
+		const auto fp_sequential = CalculateFingerprint<Fingerprinter>(algorithm, data, 11025, 1);
+		const auto fp_sharded = CalculateFingerprint<Fingerprinter>(algorithm, data, 11025, 1, 2);
+		ASSERT_FALSE(fp_sequential.empty());
+		ASSERT_EQ(fp_sequential, fp_sharded);
+	}
+
+	// less audio than the chroma filter needs
+	const std::vector<short> short_data(data.begin(), data.begin() + 11025);
+	ASSERT_EQ(
+		CalculateFingerprint<Fingerprinter>(CHROMAPRINT_ALGORITHM_DEFAULT, short_data, 11025, 1),
+		CalculateFingerprint<Fingerprinter>(CHROMAPRINT_ALGORITHM_DEFAULT, short_data, 11025, 1, 4));
+}
+
+// A fingerprint consumer gets the items a few seconds after the audio, not
+// only after enough audio for all threads.
+TEST(Fingerprinter, ShardedWithConsumer)
+{
+	struct Collector : public FingerprintConsumer {
+		void Consume(const uint32_t *fingerprint, size_t size, size_t) override {
+			items.insert(items.end(), fingerprint, fingerprint + size);
+		}
+		Vector<uint32_t> items;
+	};
+
+	const auto data = LoadLongAudioFile("data/test_mono_11025.raw", 11025, 1, 135);
+	const auto expected = CalculateFingerprint<Fingerprinter>(CHROMAPRINT_ALGORITHM_DEFAULT, data, 11025, 1);
+
+	Collector collector;
+	Fingerprinter fingerprinter(CreateFingerprinterConfiguration(CHROMAPRINT_ALGORITHM_DEFAULT));
+	ASSERT_TRUE(fingerprinter.SetOption("num_threads", 4));
+	fingerprinter.SetFingerprintConsumer(&collector);
+	fingerprinter.Start(11025, 1);
+	for (size_t i = 0; i < data.size(); i += 4096) {
+		fingerprinter.Consume(data.data() + i, int(std::min(size_t(4096), data.size() - i)));
+	}
+	ASSERT_GT(collector.items.size() + 64, expected.size());
+	fingerprinter.Finish();
+	ASSERT_EQ(expected, collector.items);
+}
+
+TEST(Fingerprinter, MultiMatchesSeparate)
+{
+	const auto data = LoadLongAudioFile("data/test_stereo_44100.raw", 44100, 2);
+	const int algorithms[] = {
+		CHROMAPRINT_ALGORITHM_TEST1,
+		CHROMAPRINT_ALGORITHM_TEST2,
+		CHROMAPRINT_ALGORITHM_TEST3,
+		CHROMAPRINT_ALGORITHM_TEST4,
+		CHROMAPRINT_ALGORITHM_TEST5,
+		CHROMAPRINT_ALGORITHM_TEST2,
+	};
+	const size_t num_algorithms = sizeof(algorithms) / sizeof(algorithms[0]);
+
+	MultiFingerprinter fingerprinter(algorithms, num_algorithms);
+	ASSERT_EQ(num_algorithms, fingerprinter.num_algorithms());
+	// Test1 and Test2 share the frames, Test3 frames don't overlap, Test4
+	// removes silence and Test5 has shorter frames
+	ASSERT_EQ(4u, fingerprinter.num_fft_stages());
+
+	// the second run checks that everything is reset
+	for (int run = 0; run < 2; run++) {
+		SCOPED_TRACE("run " + std::to_string(run));
+		ASSERT_TRUE(fingerprinter.Start(44100, 2));
+		const size_t chunk_size = 4096 * 2;
+		for (size_t i = 0; i < data.size(); i += chunk_size) {
+			fingerprinter.Consume(data.data() + i, int(std::min(chunk_size, data.size() - i)));
+		}
+		fingerprinter.Finish();
+
+		for (size_t i = 0; i < num_algorithms; i++) {
+			SCOPED_TRACE("algorithm " + std::to_string(algorithms[i] + 1));
+			const auto expected = CalculateFingerprint<Fingerprinter>(algorithms[i], data, 44100, 2);
+			ASSERT_FALSE(expected.empty());
+			ASSERT_EQ(expected, fingerprinter.GetFingerprint(i));
+		}
+	}
+}
+
+// The polyphase resampler is not exactly the same as avresample, but close
+// enough to only change a few bits of the fingerprint.
+TEST(Fingerprinter, PolyphaseResampler)
+{
+	struct {
+		const char *file_name;
+		int sample_rate;
+		int num_channels;
+	} inputs[] = {
+		{ "data/test_mono_44100.raw", 44100, 1 },
+		{ "data/test_stereo_44100.raw", 44100, 2 },
+		{ "data/test_mono_8000.raw", 8000, 1 },
+	};
+
+	for (const auto &input : inputs) {
+		SCOPED_TRACE(input.file_name);
+		const auto data = LoadLongAudioFile(input.file_name, input.sample_rate, input.num_channels);
+		const auto expected = CalculateFingerprint<Fingerprinter>(CHROMAPRINT_ALGORITHM_DEFAULT, data, input.sample_rate, input.num_channels);
+
+		Fingerprinter fingerprinter(CreateFingerprinterConfiguration(CHROMAPRINT_ALGORITHM_DEFAULT));
+		ASSERT_TRUE(fingerprinter.SetOption("resampler", CHROMAPRINT_RESAMPLER_POLYPHASE));
+		ASSERT_FALSE(fingerprinter.SetOption("resampler", 2));
+		fingerprinter.Start(input.sample_rate, input.num_channels);
+		fingerprinter.Consume(data.data(), int(data.size()));
+		fingerprinter.Finish();
+		const auto &actual = fingerprinter.GetFingerprint();
+
+		ASSERT_FALSE(expected.empty());
+		ASSERT_EQ(expected.size(), actual.size());
+		size_t bit_errors = 0;
+		for (size_t i = 0; i < expected.size(); i++) {
+			bit_errors += CountSetBits(expected[i] ^ actual[i]);
+		}
+		EXPECT_LT(bit_errors, expected.size() * 32 / 100);
+	}
+}
@@ -45,3 +45,31 @@ TEST(SilenceRemover, RemoveLeadingSilence)
 		ASSERT_EQ(data2[i], buffer.data()[i]) << "Signals differ at index " << i;
 	}
 }
+
+TEST(SilenceRemover, ResetAfterSound)
+{
+	short samples1[] = { 0, 60, 0, 1000, 2000, 0, 4000, 5000, 0 };
+	std::vector<short> data1(samples1, samples1 + NELEMS(samples1));
+
+	AudioBuffer expected;
+	SilenceRemover fresh(&expected, 100);
+	fresh.Reset(44100, 1);
+	fresh.Consume(data1.data(), data1.size());
+	fresh.Flush();
+
+	// the loud samples of the first stream must not count in the second one
+	short samples2[] = { 30000, 30000, 30000, 30000 };
+	AudioBuffer buffer;
+	SilenceRemover processor(&buffer, 100);
+	processor.Reset(44100, 1);
+	processor.Consume(samples2, NELEMS(samples2));
+	processor.Flush();
+
+	AudioBuffer buffer2;
+	processor.set_consumer(&buffer2);
+	processor.Reset(44100, 1);
+	processor.Consume(data1.data(), data1.size());
+	processor.Flush();
+
+	ASSERT_EQ(expected.data(), buffer2.data());
+}